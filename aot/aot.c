@@ -0,0 +1,311 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "aot.h"
+#include "../object/object.h"
+#include "../opcode/opcode.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../aot_runtime_embed.h"
+
+static int readOperand(Instructions instructions, int pos, int width) {
+  if (width == 2) {
+    return ((unsigned char)instructions[pos] << 8) |
+           (unsigned char)instructions[pos + 1];
+  }
+  return (unsigned char)instructions[pos];
+}
+
+static int instructionWidth(Instructions instructions, int pos) {
+  OpCode op = instructions[pos];
+  if (op < 0 || op > MAX_OPCODE) {
+    return -1;
+  }
+  return instructionLengths[(int)op];
+}
+
+// mark every pc that a jump lands on, so only those get a label
+static bool *findJumpTargets(Instructions instructions, int length) {
+  bool *targets = calloc(length + 1, sizeof(bool));
+  int pos = 0;
+  while (pos < length) {
+    int width = instructionWidth(instructions, pos);
+    if (width < 0) {
+      break;
+    }
+    OpCode op = instructions[pos];
+    if (op == OpJump || op == OpJumpNotTruthy) {
+      int target = readOperand(instructions, pos + 1, 2);
+      if (target <= length) {
+        targets[target] = true;
+      }
+    }
+    pos += width;
+  }
+  return targets;
+}
+
+// emit the body of one function; main returns 0 when it falls off the end,
+// compiled functions always end in a return instruction
+static int emitFunction(FILE *out, const char *name, Instructions instructions,
+                        int length, int entryPosition) {
+  bool *targets = findJumpTargets(instructions, length);
+  if (entryPosition > 0) {
+    targets[entryPosition] = true;
+  }
+
+  fprintf(out, "static int %s(struct VM *vm, int bp) {\n", name);
+  fprintf(out, "  (void)bp;\n");
+  if (entryPosition > 0) {
+    fprintf(out, "  goto L_%d;\n", entryPosition);
+  }
+
+  int pos = 0;
+  while (pos < length) {
+    int width = instructionWidth(instructions, pos);
+    if (width < 0) {
+      fprintf(stderr, "❌ unknown opcode %d at %d in %s\n", instructions[pos],
+              pos, name);
+      free(targets);
+      return -1;
+    }
+
+    if (targets[pos]) {
+      fprintf(out, "L_%d:;\n", pos);
+    }
+
+    OpCode op = instructions[pos];
+    int operand = 0;
+    if (width == 2) {
+      operand = readOperand(instructions, pos + 1, 1);
+    } else if (width == 3) {
+      operand = readOperand(instructions, pos + 1, 2);
+    }
+
+    switch (op) {
+    case OpConstant:
+      fprintf(out, "  if (executeConstant(vm, %d) != 0) return -1;\n", operand);
+      break;
+    case OpPop:
+      fprintf(out, "  executePop(vm);\n");
+      break;
+    case OpAdd:
+    case OpSub:
+    case OpMul:
+    case OpDiv:
+      fprintf(out, "  if (executeBinaryOperation(vm, %d) != 0) return -1;\n", op);
+      break;
+    case OpTrue:
+    case OpFalse:
+      fprintf(out, "  if (executeBoolean(vm, %s) != 0) return -1;\n",
+              op == OpTrue ? "true" : "false");
+      break;
+    case OpEqual:
+    case OpNotEqual:
+    case OpGreaterThan:
+      fprintf(out, "  if (executeComparison(vm, %d) != 0) return -1;\n", op);
+      break;
+    case OpBang:
+      fprintf(out, "  if (executeBangOperator(vm) != 0) return -1;\n");
+      break;
+    case OpMinus:
+      fprintf(out, "  if (executeMinusOperator(vm) != 0) return -1;\n");
+      break;
+    case OpJumpNotTruthy:
+      fprintf(out, "  if (!executeJumpCondition(vm)) goto L_%d;\n", operand);
+      break;
+    case OpJump:
+      fprintf(out, "  goto L_%d;\n", operand);
+      break;
+    case OpNull:
+      fprintf(out, "  if (executeNull(vm) != 0) return -1;\n");
+      break;
+    case OpSetGlobal:
+      fprintf(out, "  executeSetGlobal(vm, %d);\n", operand);
+      break;
+    case OpGetGlobal:
+      fprintf(out, "  if (executeGetGlobal(vm, %d) != 0) return -1;\n", operand);
+      break;
+    case OpArray:
+      fprintf(out, "  if (executeArray(vm, %d) != 0) return -1;\n", operand);
+      break;
+    case OpHash:
+      fprintf(out, "  if (executeHash(vm, %d) != 0) return -1;\n", operand);
+      break;
+    case OpIndex:
+      fprintf(out, "  if (executeIndex(vm) != 0) return -1;\n");
+      break;
+    case OpRecord:
+      fprintf(out, "  if (executeRecord(vm, %d) != 0) return -1;\n", operand);
+      break;
+    case OpGetField:
+      fprintf(out, "  if (executeGetField(vm, %d) != 0) return -1;\n", operand);
+      break;
+    case OpCall:
+      fprintf(out, "  if (runCall(vm, %d) != 0) return -1;\n", operand);
+      break;
+    case OpReturnValue:
+      fprintf(out, "  return executeReturnValue(vm, bp);\n");
+      break;
+    case OpReturn:
+      fprintf(out, "  return executeReturn(vm, bp);\n");
+      break;
+    case OpSetLocal:
+      fprintf(out, "  executeSetLocal(vm, bp, %d);\n", operand);
+      break;
+    case OpGetLocal:
+      fprintf(out, "  if (executeGetLocal(vm, bp, %d) != 0) return -1;\n", operand);
+      break;
+    case OpGetBuiltin:
+      fprintf(out, "  if (executeGetBuiltin(vm, %d) != 0) return -1;\n", operand);
+      break;
+    default:
+      // the vm has no implementation either; fail the same way at runtime
+      fprintf(out, "  return -1; // %s\n", definitions[(int)op].name);
+      break;
+    }
+
+    pos += width;
+  }
+
+  if (targets[length]) {
+    fprintf(out, "L_%d:;\n", length);
+  }
+  fprintf(out, "  return 0;\n}\n\n");
+
+  free(targets);
+  return 0;
+}
+
+int aotGenerate(FILE *out, ByteCode *bytecode, unsigned char *serialized,
+                int serializedLength, int entryPosition) {
+  fprintf(out, "// generated by monkeyc build --aot\n");
+  fprintf(out, "#include \"aot_runtime.h\"\n\n");
+
+  fprintf(out, "static const unsigned char program[%d] = {", serializedLength);
+  for (int i = 0; i < serializedLength; i++) {
+    fprintf(out, "%s0x%02x,", i % 16 == 0 ? "\n  " : " ", serialized[i]);
+  }
+  fprintf(out, "\n};\n\n");
+
+  for (int i = 0; i < bytecode->constantsCount; i++) {
+    Object *constant = &bytecode->constants[i];
+    if (strcmp(constant->type, CompiledFunctionObj) != 0) {
+      continue;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "fn_%d", i);
+    CompiledFunction *fn = constant->compiledFunction;
+    if (emitFunction(out, name, fn->instructions, fn->instructionCount, 0) != 0) {
+      return -1;
+    }
+  }
+
+  if (emitFunction(out, "fn_main", bytecode->instructions,
+                   bytecode->instructionCount, entryPosition) != 0) {
+    return -1;
+  }
+
+  fprintf(out, "int main(void) {\n");
+  fprintf(out, "  struct VM *vm = aotLoad(program, sizeof(program));\n");
+  fprintf(out, "  if (!vm) return 1;\n");
+  for (int i = 0; i < bytecode->constantsCount; i++) {
+    if (strcmp(bytecode->constants[i].type, CompiledFunctionObj) == 0) {
+      fprintf(out, "  aotRegister(vm, %d, fn_%d);\n", i, i);
+    }
+  }
+  fprintf(out, "  fn_main(vm, 0);\n");
+  fprintf(out, "  return aotFinish(vm);\n");
+  fprintf(out, "}\n");
+
+  return 0;
+}
+
+static int writeBlob(const char *path, const unsigned char *data, unsigned int length) {
+  FILE *fp = fopen(path, "wb");
+  if (!fp) {
+    fprintf(stderr, "❌ Cannot open %s for writing\n", path);
+    return -1;
+  }
+  size_t written = fwrite(data, 1, length, fp);
+  fclose(fp);
+  return written == length ? 0 : -1;
+}
+
+static int runCompiler(char **argv) {
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    return -1;
+  }
+  if (pid == 0) {
+    execvp(argv[0], argv);
+    fprintf(stderr, "❌ Cannot run C compiler '%s' (set %s)\n", argv[0], AOT_CC_ENV);
+    _exit(127);
+  }
+
+  int status;
+  if (waitpid(pid, &status, 0) < 0) {
+    perror("waitpid");
+    return -1;
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+int aotBuild(ByteCode *bytecode, unsigned char *serialized,
+             int serializedLength, int entryPosition, const char *outputPath) {
+  char dir[] = "/tmp/monkeyc-aot-XXXXXX";
+  if (!mkdtemp(dir)) {
+    perror("mkdtemp");
+    return -1;
+  }
+
+  char header[sizeof(dir) + 32], library[sizeof(dir) + 32], source[sizeof(dir) + 32];
+  snprintf(header, sizeof(header), "%s/aot_runtime.h", dir);
+  snprintf(library, sizeof(library), "%s/libmonkeyrt.a", dir);
+  snprintf(source, sizeof(source), "%s/program.c", dir);
+
+  int result = -1;
+  if (writeBlob(header, aot_aot_runtime_h, aot_aot_runtime_h_len) != 0 ||
+      writeBlob(library, bin_libmonkeyrt_a, bin_libmonkeyrt_a_len) != 0) {
+    goto cleanup;
+  }
+
+  FILE *out = fopen(source, "w");
+  if (!out) {
+    fprintf(stderr, "❌ Cannot open %s for writing\n", source);
+    goto cleanup;
+  }
+  int generated = aotGenerate(out, bytecode, serialized, serializedLength, entryPosition);
+  fclose(out);
+  if (generated != 0) {
+    goto cleanup;
+  }
+  printf("🛠️ Generated C for %d constants in %s\n", bytecode->constantsCount, source);
+
+  char *cc = getenv(AOT_CC_ENV);
+  if (!cc || cc[0] == '\0') {
+    cc = AOT_DEFAULT_CC;
+  }
+  // a helper missing from aot_runtime.h is an error, not an implicit
+  // declaration that happens to link
+  char *argv[] = {cc, "-O2", "-Werror=implicit-function-declaration",
+                  "-I", dir, source, library, "-o", (char *)outputPath, NULL};
+  printf("⚙️ %s -O2 %s -o %s\n", cc, source, outputPath);
+  if (runCompiler(argv) != 0) {
+    fprintf(stderr, "❌ Native compilation failed\n");
+    goto cleanup;
+  }
+  result = 0;
+
+cleanup:
+  unlink(source);
+  unlink(library);
+  unlink(header);
+  rmdir(dir);
+  return result;
+}
@@ -0,0 +1,23 @@
+#ifndef AOT_H
+#define AOT_H
+
+#include "../compiler/compiler.h"
+#include <stdio.h>
+
+// environment variable naming the C compiler used for --aot builds
+#define AOT_CC_ENV "MONKEYC_CC"
+#define AOT_DEFAULT_CC "clang"
+
+// write a C translation of the program to out: one C function per compiled
+// function plus one for the main program, with bytecode jumps as gotos. the
+// serialized program is embedded so constants and globals load exactly as in
+// the vm_stub; entryPosition is where main starts (0 without a snapshot)
+int aotGenerate(FILE *out, ByteCode *bytecode, unsigned char *serialized,
+                int serializedLength, int entryPosition);
+
+// generate the C source, compile it against the embedded runtime library and
+// write a native executable to outputPath
+int aotBuild(ByteCode *bytecode, unsigned char *serialized,
+             int serializedLength, int entryPosition, const char *outputPath);
+
+#endif
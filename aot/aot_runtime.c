@@ -0,0 +1,38 @@
+#include "aot_runtime.h"
+#include "../loader/loader.h"
+#include "../vm/vm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+VM *aotLoad(const unsigned char *data, int length) {
+  Snapshot snapshot;
+  ByteCode *bc = deserializeBytecode((unsigned char *)data, length, &snapshot);
+  if (!bc) {
+    fprintf(stderr, "❌ failed to load embedded bytecode\n");
+    return NULL;
+  }
+  return loadVM(bc, &snapshot);
+}
+
+int aotRegister(VM *vm, int constIndex, AotFunction function) {
+  if (constIndex < 0 || constIndex >= vm->constantsCount ||
+      strcmp(vm->constants[constIndex].type, CompiledFunctionObj) != 0) {
+    fprintf(stderr, "❌ constant %d is not a compiled function\n", constIndex);
+    return -1;
+  }
+  vm->constants[constIndex].compiledFunction->native = function;
+  return 0;
+}
+
+int aotFinish(VM *vm) {
+  Object *top = stackTop(vm);
+  if (!top) {
+    return 0;
+  }
+
+  char *out = inspect(top);
+  printf("%s\n", out);
+
+  return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef AOT_RUNTIME_H
+#define AOT_RUNTIME_H
+
+// runtime interface for ahead-of-time compiled programs. the generated C is
+// built against this header alone, so it only names `struct VM` and repeats
+// the vm helper prototypes it calls; aot_runtime.c includes vm.h as well so
+// the compiler catches any drift between the two.
+
+#include <stdbool.h>
+
+struct VM;
+typedef int (*AotFunction)(struct VM *vm, int basePointer);
+
+// load the serialized program (same format the vm_stub reads) into a vm
+struct VM *aotLoad(const unsigned char *data, int length);
+// attach native code to the compiled function at constant index constIndex
+int aotRegister(struct VM *vm, int constIndex, AotFunction function);
+// print the result the same way the vm_stub does; returns the exit code
+int aotFinish(struct VM *vm);
+
+int runCall(struct VM *vm, int numArgs);
+int executeBinaryOperation(struct VM *vm, char opCode);
+int executeComparison(struct VM *vm, char opCode);
+int executeBangOperator(struct VM *vm);
+int executeMinusOperator(struct VM *vm);
+int executeConstant(struct VM *vm, int constIndex);
+int executePop(struct VM *vm);
+int executeBoolean(struct VM *vm, bool value);
+int executeNull(struct VM *vm);
+bool executeJumpCondition(struct VM *vm);
+int executeSetGlobal(struct VM *vm, int globalIndex);
+int executeGetGlobal(struct VM *vm, int globalIndex);
+int executeArray(struct VM *vm, int numElements);
+int executeHash(struct VM *vm, int numElements);
+int executeIndex(struct VM *vm);
+int executeReturnValue(struct VM *vm, int basePointer);
+int executeReturn(struct VM *vm, int basePointer);
+int executeSetLocal(struct VM *vm, int basePointer, int localIndex);
+int executeGetLocal(struct VM *vm, int basePointer, int localIndex);
+int executeGetBuiltin(struct VM *vm, int builtinIndex);
+int executeRecord(struct VM *vm, int shapeIndex);
+int executeGetField(struct VM *vm, int keyIndex);
+
+#endif
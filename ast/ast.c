@@ -1,4 +1,5 @@
 #include "ast.h"
+#include "../intern/intern.h"
 #include "../token/token.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,12 +16,149 @@ char *strdup(const char *s) {
 }
 #endif
 
+// ===== AST ARENA =====
+
+#define AST_CHUNK_SIZE (64 * 1024)
+// every node holds pointers or long longs, so 8-byte alignment covers them
+#define AST_ALIGN 8
+
+struct AstArenaChunk {
+  AstArenaChunk *next;
+  size_t used;
+  size_t capacity;
+  unsigned char data[];
+};
+
+static AstArenaChunk *newChunk(AstArena *arena, size_t capacity) {
+  AstArenaChunk *chunk = malloc(sizeof(AstArenaChunk) + capacity);
+  if (!chunk) {
+    fprintf(stderr, "❌ out of memory allocating AST\n");
+    abort();
+  }
+  chunk->used = 0;
+  chunk->capacity = capacity;
+  arena->bytes += sizeof(AstArenaChunk) + capacity;
+  return chunk;
+}
+
+AstArena *newAstArena() {
+  AstArena *arena = malloc(sizeof(AstArena));
+  arena->chunks = NULL;
+  arena->bytes = 0;
+  return arena;
+}
+
+void *astAlloc(AstArena *arena, size_t size) {
+  size = (size + AST_ALIGN - 1) & ~(size_t)(AST_ALIGN - 1);
+
+  AstArenaChunk *chunk = arena->chunks;
+  if (chunk && chunk->used + size <= chunk->capacity) {
+    void *ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    return ptr;
+  }
+
+  // big requests (long lists, huge string literals) get a chunk of their
+  // own behind the current one so its free space isn't wasted
+  if (size > AST_CHUNK_SIZE / 4) {
+    AstArenaChunk *big = newChunk(arena, size);
+    big->used = size;
+    if (chunk) {
+      big->next = chunk->next;
+      chunk->next = big;
+    } else {
+      big->next = NULL;
+      arena->chunks = big;
+    }
+    return big->data;
+  }
+
+  chunk = newChunk(arena, AST_CHUNK_SIZE);
+  chunk->next = arena->chunks;
+  arena->chunks = chunk;
+  chunk->used = size;
+  return chunk->data;
+}
+
+void *astCopy(AstArena *arena, const void *data, size_t size) {
+  if (size == 0) {
+    return NULL;
+  }
+  void *copy = astAlloc(arena, size);
+  memcpy(copy, data, size);
+  return copy;
+}
+
+char *astStrndup(AstArena *arena, const char *start, size_t length) {
+  char *copy = astAlloc(arena, length + 1);
+  memcpy(copy, start, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+void astArenaReset(AstArena *arena) {
+  AstArenaChunk *keep = arena->chunks;
+  if (!keep) {
+    return;
+  }
+
+  // big allocations sit behind the head chunk, which is always a regular
+  // one unless the very first allocation was big
+  AstArenaChunk *chunk = keep->next;
+  if (keep->capacity != AST_CHUNK_SIZE) {
+    chunk = keep;
+    keep = NULL;
+  }
+  while (chunk) {
+    AstArenaChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+
+  arena->chunks = keep;
+  arena->bytes = 0;
+  if (keep) {
+    keep->next = NULL;
+    keep->used = 0;
+    arena->bytes = sizeof(AstArenaChunk) + keep->capacity;
+  }
+}
+
+void freeAstArena(AstArena *arena) {
+  if (!arena) {
+    return;
+  }
+  AstArenaChunk *chunk = arena->chunks;
+  while (chunk) {
+    AstArenaChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(arena);
+}
+
+Program *newProgram(AstArena *arena) {
+  Program *program = astAlloc(arena, sizeof(Program));
+  program->type = NODE_PROGRAM;
+  program->statements = NULL;
+  program->statementCount = 0;
+  program->arena = arena;
+  return program;
+}
+
+void freeProgram(Program *program) {
+  if (program) {
+    // the program itself lives in its arena
+    freeAstArena(program->arena);
+  }
+}
+
 // ===== AST NODE CONSTRUCTORS =====
 
 // create a new let statement node
-LetStatement *newLetStatement(Token token, Identifier *name,
+LetStatement *newLetStatement(AstArena *arena, Token token, Identifier *name,
                               Expression *value) {
-  LetStatement *stmt = malloc(sizeof(LetStatement));
+  LetStatement *stmt = astAlloc(arena, sizeof(LetStatement));
   stmt->token = token;
   stmt->name = name;
   stmt->value = value;
@@ -28,63 +166,74 @@ LetStatement *newLetStatement(Token token, Identifier *name,
 }
 
 // create a new identifier node
-Identifier *newIdentifier(Token token, const char *value) {
-  Identifier *ident = malloc(sizeof(Identifier));
+Identifier *newIdentifier(AstArena *arena, Token token, const char *value) {
+  Identifier *ident = astAlloc(arena, sizeof(Identifier));
   ident->token = cloneToken(token);
-  ident->value = strdup(value);
+  ident->value = internString(value);
   return ident;
 }
 
-IntegerLiteral *newIntegerLiteral(Token token, long long value) {
-  IntegerLiteral *il = malloc(sizeof(IntegerLiteral));
+Identifier *newIdentifierFromToken(AstArena *arena, Token token) {
+  Identifier *ident = astAlloc(arena, sizeof(Identifier));
+  ident->token = token;
+  ident->value = intern(token.start, token.length);
+  return ident;
+}
+
+IntegerLiteral *newIntegerLiteral(AstArena *arena, Token token,
+                                  long long value) {
+  IntegerLiteral *il = astAlloc(arena, sizeof(IntegerLiteral));
   il->token = cloneToken(token);
   il->value = value;
   return il;
 }
 
-BooleanLiteral *newBooleanLiteral(Token token, int value) {
-  BooleanLiteral *bl = malloc(sizeof(BooleanLiteral));
+BooleanLiteral *newBooleanLiteral(AstArena *arena, Token token, int value) {
+  BooleanLiteral *bl = astAlloc(arena, sizeof(BooleanLiteral));
   bl->token = cloneToken(token);
   bl->value = value;
   return bl;
 }
 
-ExpressionStatement *newExpressionStatement(Token token, Expression *expr) {
-  ExpressionStatement *stmt = malloc(sizeof(ExpressionStatement));
+ExpressionStatement *newExpressionStatement(AstArena *arena, Token token,
+                                            Expression *expr) {
+  ExpressionStatement *stmt = astAlloc(arena, sizeof(ExpressionStatement));
   stmt->token = cloneToken(token);
   stmt->expression = expr;
   return stmt;
 }
 
-ReturnStatement *newReturnStatement(Token token, Expression *value) {
-  ReturnStatement *stmt = malloc(sizeof(ReturnStatement));
+ReturnStatement *newReturnStatement(AstArena *arena, Token token,
+                                    Expression *value) {
+  ReturnStatement *stmt = astAlloc(arena, sizeof(ReturnStatement));
   stmt->token = cloneToken(token);
   stmt->return_value = value;
   return stmt;
 }
 
-PrefixExpression *newPrefixExpression(Token token, const char *op,
-                                      Expression *right) {
-  PrefixExpression *pe = malloc(sizeof(PrefixExpression));
+PrefixExpression *newPrefixExpression(AstArena *arena, Token token,
+                                      const char *op, Expression *right) {
+  PrefixExpression *pe = astAlloc(arena, sizeof(PrefixExpression));
   pe->token = token;
-  pe->op = strdup(op);
+  pe->op = astStrndup(arena, op, strlen(op));
   pe->right = right;
   return pe;
 }
 
-InfixExpression *newInfixExpression(Token token, Expression *left,
-                                    const char *op, Expression *right) {
-  InfixExpression *ie = malloc(sizeof(InfixExpression));
+InfixExpression *newInfixExpression(AstArena *arena, Token token,
+                                    Expression *left, const char *op,
+                                    Expression *right) {
+  InfixExpression *ie = astAlloc(arena, sizeof(InfixExpression));
   ie->token = token;
   ie->left = left;
-  ie->op = strdup(op);
+  ie->op = astStrndup(arena, op, strlen(op));
   ie->right = right;
   return ie;
 }
 
-HashLiteral *newHashLiteral(Token token, Expression **keys, Expression **values,
-                            int count) {
-  HashLiteral *hl = malloc(sizeof(HashLiteral));
+HashLiteral *newHashLiteral(AstArena *arena, Token token, Expression **keys,
+                            Expression **values, int count) {
+  HashLiteral *hl = astAlloc(arena, sizeof(HashLiteral));
   hl->token = token;
   hl->keys = keys;
   hl->values = values;
@@ -95,64 +244,64 @@ HashLiteral *newHashLiteral(Token token, Expression **keys, Expression **values,
 // ===== EXPRESSION WRAPPER FUNCTIONS =====
 // these functions wrap specific node types into generic Expression structs
 
-Expression *wrapIntegerLiteral(IntegerLiteral *il) {
-  Expression *expr = malloc(sizeof(Expression));
+Expression *wrapIntegerLiteral(AstArena *arena, IntegerLiteral *il) {
+  Expression *expr = astAlloc(arena, sizeof(Expression));
   expr->type = NODE_INTEGER_LITERAL;
   expr->integerLiteral = il;
   return expr;
 }
 
-Expression *wrapBooleanLiteral(BooleanLiteral *bl) {
-  Expression *expr = malloc(sizeof(Expression));
+Expression *wrapBooleanLiteral(AstArena *arena, BooleanLiteral *bl) {
+  Expression *expr = astAlloc(arena, sizeof(Expression));
   expr->type = NODE_BOOLEAN;
   expr->booleanLiteral = bl;
   return expr;
 }
 
-Expression *wrapIdentifier(Identifier *id) {
-  Expression *expr = malloc(sizeof(Expression));
+Expression *wrapIdentifier(AstArena *arena, Identifier *id) {
+  Expression *expr = astAlloc(arena, sizeof(Expression));
   expr->type = NODE_IDENTIFIER;
   expr->identifier = id;
   return expr;
 }
 
-Expression *wrapPrefixExpression(PrefixExpression *pe) {
-  Expression *expr = malloc(sizeof(Expression));
+Expression *wrapPrefixExpression(AstArena *arena, PrefixExpression *pe) {
+  Expression *expr = astAlloc(arena, sizeof(Expression));
   expr->type = NODE_PREFIX_EXPRESSION;
   expr->prefixExpression = pe;
   return expr;
 }
 
-Expression *wrapInfixExpression(InfixExpression *ie) {
-  Expression *expr = malloc(sizeof(Expression));
+Expression *wrapInfixExpression(AstArena *arena, InfixExpression *ie) {
+  Expression *expr = astAlloc(arena, sizeof(Expression));
   expr->type = NODE_INFIX_EXPRESSION;
   expr->infixExpression = ie;
   return expr;
 }
 
-Expression *wrapHashLiteral(HashLiteral *hl) {
-  Expression *expr = malloc(sizeof(Expression));
+Expression *wrapHashLiteral(AstArena *arena, HashLiteral *hl) {
+  Expression *expr = astAlloc(arena, sizeof(Expression));
   expr->type = NODE_HASH_LITERAL;
   expr->hashLiteral = hl;
   return expr;
 }
 
-Statement *wrapLetStatement(LetStatement *stmt) {
-  Statement *s = malloc(sizeof(Statement));
+Statement *wrapLetStatement(AstArena *arena, LetStatement *stmt) {
+  Statement *s = astAlloc(arena, sizeof(Statement));
   s->type = NODE_LET_STATEMENT;
   s->letStatement = stmt;
   return s;
 }
 
-Statement *wrapExpressionStatement(ExpressionStatement *stmt) {
-  Statement *s = malloc(sizeof(Statement));
+Statement *wrapExpressionStatement(AstArena *arena, ExpressionStatement *stmt) {
+  Statement *s = astAlloc(arena, sizeof(Statement));
   s->type = NODE_EXPRESSION_STATEMENT;
   s->expressionStatement = stmt;
   return s;
 }
 
-Statement *wrapReturnStatement(ReturnStatement *stmt) {
-  Statement *s = malloc(sizeof(Statement));
+Statement *wrapReturnStatement(AstArena *arena, ReturnStatement *stmt) {
+  Statement *s = astAlloc(arena, sizeof(Statement));
   s->type = NODE_RETURN_STATEMENT;
   s->returnStatement = stmt;
   return s;
@@ -161,11 +310,11 @@ Statement *wrapReturnStatement(ReturnStatement *stmt) {
 char *identifierToString(Identifier *ident) { return strdup(ident->value); }
 
 char *integerLiteralToString(IntegerLiteral *il) {
-  return strdup(il->token.literal);
+  return tokenLiteral(il->token);
 }
 
 char *booleanLiteralToString(BooleanLiteral *bl) {
-  return strdup(bl->token.literal);
+  return tokenLiteral(bl->token);
 }
 
 char *prefixExpressionToString(PrefixExpression *pe) {
@@ -220,31 +369,29 @@ char *expressionToString(Expression *expr) {
   if (!expr)
     return strdup("");
 
-  printf("➡️ expressionToString: %s\n", expr->type);
-
-  if (strcmp(expr->type, NODE_IDENTIFIER) == 0) {
+  if (expr->type == NODE_IDENTIFIER) {
     return identifierToString(expr->identifier);
-  } else if (strcmp(expr->type, NODE_INTEGER_LITERAL) == 0) {
+  } else if (expr->type == NODE_INTEGER_LITERAL) {
     return integerLiteralToString(expr->integerLiteral);
-  } else if (strcmp(expr->type, NODE_BOOLEAN) == 0) {
+  } else if (expr->type == NODE_BOOLEAN) {
     return booleanLiteralToString(expr->booleanLiteral);
-  } else if (strcmp(expr->type, NODE_STRING_LITERAL) == 0) {
+  } else if (expr->type == NODE_STRING_LITERAL) {
     return stringLiteralToString(expr->stringLiteral);
-  } else if (strcmp(expr->type, NODE_PREFIX_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_PREFIX_EXPRESSION) {
     return prefixExpressionToString(expr->prefixExpression);
-  } else if (strcmp(expr->type, NODE_INFIX_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_INFIX_EXPRESSION) {
     return infixExpressionToString(expr->infixExpression);
-  } else if (strcmp(expr->type, NODE_IF_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_IF_EXPRESSION) {
     return ifExpressionToString(expr->ifExpression);
-  } else if (strcmp(expr->type, NODE_FUNCTION_LITERAL) == 0) {
+  } else if (expr->type == NODE_FUNCTION_LITERAL) {
     return functionLiteralToString(expr->functionLiteral);
-  } else if (strcmp(expr->type, NODE_CALL_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_CALL_EXPRESSION) {
     return callExpressionToString(expr->callExpression);
-  } else if (strcmp(expr->type, NODE_ARRAY_LITERAL) == 0) {
+  } else if (expr->type == NODE_ARRAY_LITERAL) {
     return arrayLiteralToString(expr->arrayLiteral);
-  } else if (strcmp(expr->type, NODE_INDEX_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_INDEX_EXPRESSION) {
     return indexExpressionToString(expr->indexExpression);
-  } else if (strcmp(expr->type, NODE_HASH_LITERAL) == 0) {
+  } else if (expr->type == NODE_HASH_LITERAL) {
     return hashLiteralToString(expr->hashLiteral);
   }
 
@@ -255,7 +402,7 @@ char *statementToString(Statement *stmt) {
   if (!stmt)
     return strdup("");
 
-  if (strcmp(stmt->type, NODE_LET_STATEMENT) == 0) {
+  if (stmt->type == NODE_LET_STATEMENT) {
     LetStatement *ls = stmt->letStatement;
     char *name_str = identifierToString(ls->name);
     char *val_str = expressionToString(ls->value);
@@ -267,9 +414,9 @@ char *statementToString(Statement *stmt) {
     free(val_str);
     return out;
 
-  } else if (strcmp(stmt->type, NODE_EXPRESSION_STATEMENT) == 0) {
+  } else if (stmt->type == NODE_EXPRESSION_STATEMENT) {
     return expressionToString(stmt->expressionStatement->expression);
-  } else if (strcmp(stmt->type, NODE_RETURN_STATEMENT) == 0) {
+  } else if (stmt->type == NODE_RETURN_STATEMENT) {
     ReturnStatement *rs = stmt->returnStatement;
     char *val_str = expressionToString(rs->return_value);
     size_t len = strlen("return ") + strlen(val_str) + 2;
@@ -303,21 +450,139 @@ char *programToString(Program *program) {
 }
 
 // ===== BLOCK STATEMENT =====
-BlockStatement *newBlockStatement(Token token, Statement **stmts, int count) {
-  BlockStatement *b = malloc(sizeof(BlockStatement));
+BlockStatement *newBlockStatement(AstArena *arena, Token token,
+                                  Statement **stmts, int count) {
+  BlockStatement *b = astAlloc(arena, sizeof(BlockStatement));
   b->token = token;
   b->statements = stmts;
   b->count = count;
   return b;
 }
 
-Statement *wrapBlockStatement(BlockStatement *b) {
-  Statement *s = malloc(sizeof(Statement));
+Statement *wrapBlockStatement(AstArena *arena, BlockStatement *b) {
+  Statement *s = astAlloc(arena, sizeof(Statement));
   s->type = NODE_BLOCK_STATEMENT;
   s->blockStatement = b;
   return s;
 }
 
+int statementLine(const Statement *stmt) {
+  if (!stmt) {
+    return 0;
+  }
+  switch (stmt->type) {
+  case NODE_LET_STATEMENT:
+    return stmt->letStatement->token.line;
+  case NODE_RETURN_STATEMENT:
+    return stmt->returnStatement->token.line;
+  case NODE_EXPRESSION_STATEMENT:
+    return stmt->expressionStatement->token.line;
+  case NODE_BLOCK_STATEMENT:
+    return stmt->blockStatement->token.line;
+  default:
+    return 0;
+  }
+}
+
+int expressionLine(const Expression *expr) {
+  if (!expr) {
+    return 0;
+  }
+  switch (expr->type) {
+  case NODE_IDENTIFIER:
+    return expr->identifier->token.line;
+  case NODE_INTEGER_LITERAL:
+    return expr->integerLiteral->token.line;
+  case NODE_BOOLEAN:
+    return expr->booleanLiteral->token.line;
+  case NODE_PREFIX_EXPRESSION:
+    return expr->prefixExpression->token.line;
+  case NODE_INFIX_EXPRESSION:
+    return expr->infixExpression->token.line;
+  case NODE_IF_EXPRESSION:
+    return expr->ifExpression->token.line;
+  case NODE_FUNCTION_LITERAL:
+    return expr->functionLiteral->token.line;
+  case NODE_CALL_EXPRESSION:
+    return expr->callExpression->token.line;
+  case NODE_STRING_LITERAL:
+    return expr->stringLiteral->token.line;
+  case NODE_ARRAY_LITERAL:
+    return expr->arrayLiteral->token.line;
+  case NODE_INDEX_EXPRESSION:
+    return expr->indexExpression->token.line;
+  case NODE_HASH_LITERAL:
+    return expr->hashLiteral->token.line;
+  default:
+    return 0;
+  }
+}
+
+static bool blockCalls(const BlockStatement *block) {
+  if (!block) {
+    return false;
+  }
+  for (int i = 0; i < block->count; i++) {
+    Statement *stmt = block->statements[i];
+    Expression *expr = NULL;
+    if (stmt->type == NODE_LET_STATEMENT) {
+      expr = stmt->letStatement->value;
+    } else if (stmt->type == NODE_RETURN_STATEMENT) {
+      expr = stmt->returnStatement->return_value;
+    } else if (stmt->type == NODE_EXPRESSION_STATEMENT) {
+      expr = stmt->expressionStatement->expression;
+    } else if (stmt->type == NODE_BLOCK_STATEMENT) {
+      if (blockCalls(stmt->blockStatement)) {
+        return true;
+      }
+    }
+    if (expressionCalls(expr)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool expressionCalls(const Expression *expr) {
+  if (!expr) {
+    return false;
+  }
+  switch (expr->type) {
+  case NODE_CALL_EXPRESSION:
+    return true;
+  case NODE_PREFIX_EXPRESSION:
+    return expressionCalls(expr->prefixExpression->right);
+  case NODE_INFIX_EXPRESSION:
+    return expressionCalls(expr->infixExpression->left) ||
+           expressionCalls(expr->infixExpression->right);
+  case NODE_IF_EXPRESSION:
+    return expressionCalls(expr->ifExpression->condition) ||
+           blockCalls(expr->ifExpression->consequence) ||
+           blockCalls(expr->ifExpression->alternative);
+  case NODE_ARRAY_LITERAL:
+    for (int i = 0; i < expr->arrayLiteral->count; i++) {
+      if (expressionCalls(expr->arrayLiteral->elements[i])) {
+        return true;
+      }
+    }
+    return false;
+  case NODE_INDEX_EXPRESSION:
+    return expressionCalls(expr->indexExpression->left) ||
+           expressionCalls(expr->indexExpression->index);
+  case NODE_HASH_LITERAL:
+    for (int i = 0; i < expr->hashLiteral->count; i++) {
+      if (expressionCalls(expr->hashLiteral->keys[i]) ||
+          expressionCalls(expr->hashLiteral->values[i])) {
+        return true;
+      }
+    }
+    return false;
+  default:
+    // identifiers, literals and function literals
+    return false;
+  }
+}
+
 char *blockStatementToString(BlockStatement *b) {
   size_t size = 2;
   char *out = malloc(size);
@@ -334,18 +599,10 @@ char *blockStatementToString(BlockStatement *b) {
   return out;
 }
 
-void freeBlockStatement(BlockStatement *b) {
-  for (int i = 0; i < b->count; i++) {
-    freeStatement(b->statements[i]);
-  }
-  free(b->statements);
-  free(b);
-}
-
 // ===== IF EXPRESSION =====
-IfExpression *newIfExpression(Token token, Expression *cond,
+IfExpression *newIfExpression(AstArena *arena, Token token, Expression *cond,
                               BlockStatement *cons, BlockStatement *alt) {
-  IfExpression *ifExpr = malloc(sizeof(IfExpression));
+  IfExpression *ifExpr = astAlloc(arena, sizeof(IfExpression));
   ifExpr->token = token;
   ifExpr->condition = cond;
   ifExpr->consequence = cons;
@@ -353,8 +610,8 @@ IfExpression *newIfExpression(Token token, Expression *cond,
   return ifExpr;
 }
 
-Expression *wrapIfExpression(IfExpression *ifExpr) {
-  Expression *e = malloc(sizeof(Expression));
+Expression *wrapIfExpression(AstArena *arena, IfExpression *ifExpr) {
+  Expression *e = astAlloc(arena, sizeof(Expression));
   e->type = NODE_IF_EXPRESSION;
   e->ifExpression = ifExpr;
   return e;
@@ -383,17 +640,10 @@ char *ifExpressionToString(IfExpression *ie) {
   return out;
 }
 
-void freeIfExpression(IfExpression *ie) {
-  freeExpression(ie->condition);
-  freeBlockStatement(ie->consequence);
-  if (ie->alternative)
-    freeBlockStatement(ie->alternative);
-  free(ie);
-}
-
-FunctionLiteral *newFunctionLiteral(Token token, Identifier **params, int count,
+FunctionLiteral *newFunctionLiteral(AstArena *arena, Token token,
+                                    Identifier **params, int count,
                                     BlockStatement *body) {
-  FunctionLiteral *f = malloc(sizeof(FunctionLiteral));
+  FunctionLiteral *f = astAlloc(arena, sizeof(FunctionLiteral));
   f->token = token;
   f->parameters = params;
   f->param_count = count;
@@ -401,8 +651,8 @@ FunctionLiteral *newFunctionLiteral(Token token, Identifier **params, int count,
   return f;
 }
 
-Expression *wrapFunctionLiteral(FunctionLiteral *f) {
-  Expression *e = malloc(sizeof(Expression));
+Expression *wrapFunctionLiteral(AstArena *arena, FunctionLiteral *f) {
+  Expression *e = astAlloc(arena, sizeof(Expression));
   e->type = NODE_FUNCTION_LITERAL;
   e->functionLiteral = f;
   return e;
@@ -411,7 +661,7 @@ Expression *wrapFunctionLiteral(FunctionLiteral *f) {
 char *functionLiteralToString(FunctionLiteral *fl) {
   size_t size = 64;
   char *out = malloc(size);
-  strcpy(out, fl->token.literal);
+  snprintf(out, size, "%.*s", fl->token.length, fl->token.start);
   strcat(out, "(");
 
   for (int i = 0; i < fl->param_count; i++) {
@@ -433,19 +683,11 @@ char *functionLiteralToString(FunctionLiteral *fl) {
   return out;
 }
 
-void freeFunctionLiteral(FunctionLiteral *fl) {
-  for (int i = 0; i < fl->param_count; i++) {
-    free(fl->parameters[i]);
-  }
-  free(fl->parameters);
-  freeBlockStatement(fl->body);
-  free(fl);
-}
-
 // ===== CALL EXPRESSION =====
-CallExpression *newCallExpression(Token token, Expression *func,
-                                  Expression **args, int count) {
-  CallExpression *c = malloc(sizeof(CallExpression));
+CallExpression *newCallExpression(AstArena *arena, Token token,
+                                  Expression *func, Expression **args,
+                                  int count) {
+  CallExpression *c = astAlloc(arena, sizeof(CallExpression));
   c->token = token;
   c->function = func;
   c->arguments = args;
@@ -453,8 +695,8 @@ CallExpression *newCallExpression(Token token, Expression *func,
   return c;
 }
 
-Expression *wrapCallExpression(CallExpression *c) {
-  Expression *e = malloc(sizeof(Expression));
+Expression *wrapCallExpression(AstArena *arena, CallExpression *c) {
+  Expression *e = astAlloc(arena, sizeof(Expression));
   e->type = NODE_CALL_EXPRESSION;
   e->callExpression = c;
   return e;
@@ -488,25 +730,23 @@ char *callExpressionToString(CallExpression *ce) {
   return out;
 }
 
-void freeCallExpression(CallExpression *ce) {
-  freeExpression(ce->function);
-  for (int i = 0; i < ce->arg_count; i++) {
-    freeExpression(ce->arguments[i]);
-  }
-  free(ce->arguments);
-  free(ce);
+// ===== STRING LITERAL =====
+StringLiteral *newStringLiteral(AstArena *arena, Token token, const char *val) {
+  StringLiteral *s = astAlloc(arena, sizeof(StringLiteral));
+  s->token = token;
+  s->value = astStrndup(arena, val, strlen(val));
+  return s;
 }
 
-// ===== STRING LITERAL =====
-StringLiteral *newStringLiteral(Token token, const char *val) {
-  StringLiteral *s = malloc(sizeof(StringLiteral));
+StringLiteral *newStringLiteralFromToken(AstArena *arena, Token token) {
+  StringLiteral *s = astAlloc(arena, sizeof(StringLiteral));
   s->token = token;
-  s->value = strdup(val);
+  s->value = astStrndup(arena, token.start, token.length);
   return s;
 }
 
-Expression *wrapStringLiteral(StringLiteral *s) {
-  Expression *e = malloc(sizeof(Expression));
+Expression *wrapStringLiteral(AstArena *arena, StringLiteral *s) {
+  Expression *e = astAlloc(arena, sizeof(Expression));
   e->type = NODE_STRING_LITERAL;
   e->stringLiteral = s;
   return e;
@@ -514,22 +754,18 @@ Expression *wrapStringLiteral(StringLiteral *s) {
 
 char *stringLiteralToString(StringLiteral *s) { return strdup(s->value); }
 
-void freeStringLiteral(StringLiteral *s) {
-  free(s->value);
-  free(s);
-}
-
 // ===== ARRAY LITERAL =====
-ArrayLiteral *newArrayLiteral(Token token, Expression **elements, int count) {
-  ArrayLiteral *a = malloc(sizeof(ArrayLiteral));
+ArrayLiteral *newArrayLiteral(AstArena *arena, Token token,
+                              Expression **elements, int count) {
+  ArrayLiteral *a = astAlloc(arena, sizeof(ArrayLiteral));
   a->token = token;
   a->elements = elements;
   a->count = count;
   return a;
 }
 
-Expression *wrapArrayLiteral(ArrayLiteral *a) {
-  Expression *e = malloc(sizeof(Expression));
+Expression *wrapArrayLiteral(AstArena *arena, ArrayLiteral *a) {
+  Expression *e = astAlloc(arena, sizeof(Expression));
   e->type = NODE_ARRAY_LITERAL;
   e->arrayLiteral = a;
   return e;
@@ -554,25 +790,17 @@ char *arrayLiteralToString(ArrayLiteral *al) {
   return out;
 }
 
-void freeArrayLiteral(ArrayLiteral *al) {
-  for (int i = 0; i < al->count; i++) {
-    freeExpression(al->elements[i]);
-  }
-  free(al->elements);
-  free(al);
-}
-
-IndexExpression *newIndexExpression(Token token, Expression *left,
-                                    Expression *index) {
-  IndexExpression *ie = malloc(sizeof(IndexExpression));
+IndexExpression *newIndexExpression(AstArena *arena, Token token,
+                                    Expression *left, Expression *index) {
+  IndexExpression *ie = astAlloc(arena, sizeof(IndexExpression));
   ie->token = token;
   ie->left = left;
   ie->index = index;
   return ie;
 }
 
-Expression *wrapIndexExpression(IndexExpression *ie) {
-  Expression *e = malloc(sizeof(Expression));
+Expression *wrapIndexExpression(AstArena *arena, IndexExpression *ie) {
+  Expression *e = astAlloc(arena, sizeof(Expression));
   e->type = NODE_INDEX_EXPRESSION;
   e->indexExpression = ie;
   return e;
@@ -590,68 +818,3 @@ char *indexExpressionToString(IndexExpression *ie) {
   free(indexStr);
   return out;
 }
-
-void freeIndexExpression(IndexExpression *ie) {
-  freeExpression(ie->left);
-  freeExpression(ie->index);
-  free(ie);
-}
-
-void freeExpression(Expression *expr) {
-  if (!expr)
-    return;
-
-  if (strcmp(expr->type, NODE_IDENTIFIER) == 0) {
-    free(expr->identifier->value);
-    free(expr->identifier);
-  } else if (strcmp(expr->type, NODE_INTEGER_LITERAL) == 0) {
-    free(expr->integerLiteral);
-  } else if (strcmp(expr->type, NODE_PREFIX_EXPRESSION) == 0) {
-    free(expr->prefixExpression->op);
-    freeExpression(expr->prefixExpression->right);
-    free(expr->prefixExpression);
-  } else if (strcmp(expr->type, NODE_INFIX_EXPRESSION) == 0) {
-    freeExpression(expr->infixExpression->left);
-    free(expr->infixExpression->op);
-    freeExpression(expr->infixExpression->right);
-    free(expr->infixExpression);
-  } else if (strcmp(expr->type, NODE_HASH_LITERAL) == 0) {
-    for (int i = 0; i < expr->hashLiteral->count; i++) {
-      freeExpression(expr->hashLiteral->keys[i]);
-      freeExpression(expr->hashLiteral->values[i]);
-    }
-    free(expr->hashLiteral->keys);
-    free(expr->hashLiteral->values);
-    free(expr->hashLiteral);
-  }
-
-  free(expr);
-}
-
-void freeStatement(Statement *stmt) {
-  if (!stmt)
-    return;
-
-  if (strcmp(stmt->type, NODE_LET_STATEMENT) == 0) {
-    free(stmt->letStatement->name->value);
-    free(stmt->letStatement->name);
-    freeExpression(stmt->letStatement->value);
-    free(stmt->letStatement);
-  } else if (strcmp(stmt->type, NODE_EXPRESSION_STATEMENT) == 0) {
-    freeExpression(stmt->expressionStatement->expression);
-    free(stmt->expressionStatement);
-  } else if (strcmp(stmt->type, NODE_RETURN_STATEMENT) == 0) {
-    freeExpression(stmt->returnStatement->return_value);
-    free(stmt->returnStatement);
-  }
-
-  free(stmt);
-}
-
-void freeProgram(Program *program) {
-  for (int i = 0; i < program->statementCount; i++) {
-    freeStatement(program->statements[i]);
-  }
-  free(program->statements);
-  free(program);
-}
@@ -3,23 +3,49 @@
 
 #include "../token/token.h"
 
-#define NODE_PROGRAM "PROGRAM"
-#define NODE_LET_STATEMENT "LET_STATEMENT"
-#define NODE_RETURN_STATEMENT "RETURN_STATEMENT"
-#define NODE_EXPRESSION_STATEMENT "EXPRESSION_STATEMENT"
-#define NODE_BLOCK_STATEMENT "BLOCK_STATEMENT"
-#define NODE_IDENTIFIER "IDENTIFIER"
-#define NODE_INTEGER_LITERAL "INTEGER_LITERAL"
-#define NODE_BOOLEAN "BOOLEAN"
-#define NODE_PREFIX_EXPRESSION "PREFIX_EXPRESSION"
-#define NODE_INFIX_EXPRESSION "INFIX_EXPRESSION"
-#define NODE_IF_EXPRESSION "IF_EXPRESSION"
-#define NODE_FUNCTION_LITERAL "FUNCTION_LITERAL"
-#define NODE_CALL_EXPRESSION "CALL_EXPRESSION"
-#define NODE_STRING_LITERAL "STRING_LITERAL"
-#define NODE_ARRAY_LITERAL "ARRAY_LITERAL"
-#define NODE_INDEX_EXPRESSION "INDEX_EXPRESSION"
-#define NODE_HASH_LITERAL "HASH_LITERAL"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+  NODE_PROGRAM,
+  NODE_LET_STATEMENT,
+  NODE_RETURN_STATEMENT,
+  NODE_EXPRESSION_STATEMENT,
+  NODE_BLOCK_STATEMENT,
+  NODE_IDENTIFIER,
+  NODE_INTEGER_LITERAL,
+  NODE_BOOLEAN,
+  NODE_PREFIX_EXPRESSION,
+  NODE_INFIX_EXPRESSION,
+  NODE_IF_EXPRESSION,
+  NODE_FUNCTION_LITERAL,
+  NODE_CALL_EXPRESSION,
+  NODE_STRING_LITERAL,
+  NODE_ARRAY_LITERAL,
+  NODE_INDEX_EXPRESSION,
+  NODE_HASH_LITERAL,
+} NodeType;
+
+// bump allocator that owns an entire tree: every node, child array and
+// string of a parsed program is carved out of its chunks, so there are no
+// per-node malloc headers and the tree is released with one freeAstArena()
+typedef struct AstArenaChunk AstArenaChunk;
+
+typedef struct {
+  AstArenaChunk *chunks;
+  size_t bytes; // total chunk bytes requested from malloc
+} AstArena;
+
+AstArena *newAstArena();
+// returns size bytes aligned for any node; never fails (aborts on OOM)
+void *astAlloc(AstArena *arena, size_t size);
+void *astCopy(AstArena *arena, const void *data, size_t size);
+// null-terminated copy of length characters at start
+char *astStrndup(AstArena *arena, const char *start, size_t length);
+// drops everything allocated so far but keeps one chunk for reuse; used
+// when statements are compiled and discarded one at a time
+void astArenaReset(AstArena *arena);
+void freeAstArena(AstArena *arena);
 
 typedef struct Statement Statement;
 typedef struct Expression Expression;
@@ -41,7 +67,7 @@ typedef struct IndexExpression IndexExpression;
 typedef struct HashLiteral HashLiteral;
 
 struct Statement {
-  char *type;
+  NodeType type;
   union {
     LetStatement *letStatement;
     ReturnStatement *returnStatement;
@@ -51,7 +77,7 @@ struct Statement {
 };
 
 struct Expression {
-  char *type;
+  NodeType type;
   union {
     Identifier *identifier;
     IntegerLiteral *integerLiteral;
@@ -69,9 +95,10 @@ struct Expression {
 };
 
 typedef struct {
-  char *type;
+  NodeType type;
   Statement **statements;
   int statementCount;
+  AstArena *arena; // owns the whole tree, statements included
 } Program;
 
 struct LetStatement {
@@ -98,7 +125,7 @@ struct BlockStatement {
 
 struct Identifier {
   Token token;
-  char *value;
+  const char *value; // interned, so never freed with the arena
 };
 
 struct IntegerLiteral {
@@ -168,46 +195,67 @@ struct HashLiteral {
   Expression **values;
   int count;
 };
-LetStatement *newLetStatement(Token token, Identifier *name, Expression *value);
-ReturnStatement *newReturnStatement(Token token, Expression *value);
-ExpressionStatement *newExpressionStatement(Token token, Expression *expr);
-BlockStatement *newBlockStatement(Token token, Statement **statements,
-                                  int count);
-IfExpression *newIfExpression(Token token, Expression *cond,
+// node constructors allocate from arena; child arrays passed in must
+// live in the same arena (or outlive it)
+LetStatement *newLetStatement(AstArena *arena, Token token, Identifier *name,
+                              Expression *value);
+ReturnStatement *newReturnStatement(AstArena *arena, Token token,
+                                    Expression *value);
+ExpressionStatement *newExpressionStatement(AstArena *arena, Token token,
+                                            Expression *expr);
+BlockStatement *newBlockStatement(AstArena *arena, Token token,
+                                  Statement **statements, int count);
+IfExpression *newIfExpression(AstArena *arena, Token token, Expression *cond,
                               BlockStatement *cons, BlockStatement *alt);
-FunctionLiteral *newFunctionLiteral(Token token, Identifier **params, int count,
+FunctionLiteral *newFunctionLiteral(AstArena *arena, Token token,
+                                    Identifier **params, int count,
                                     BlockStatement *body);
-CallExpression *newCallExpression(Token token, Expression *func,
-                                  Expression **args, int count);
-StringLiteral *newStringLiteral(Token token, const char *val);
-ArrayLiteral *newArrayLiteral(Token token, Expression **elements, int count);
-IndexExpression *newIndexExpression(Token token, Expression *left,
-                                    Expression *index);
-HashLiteral *newHashLiteral(Token token, Expression **keys, Expression **values,
-                            int count);
-Identifier *newIdentifier(Token token, const char *value);
-IntegerLiteral *newIntegerLiteral(Token token, long long value);
-BooleanLiteral *newBooleanLiteral(Token token, int value);
-PrefixExpression *newPrefixExpression(Token token, const char *op,
-                                      Expression *right);
-InfixExpression *newInfixExpression(Token token, Expression *left,
-                                    const char *op, Expression *right);
-Expression *wrapIdentifier(Identifier *id);
-Expression *wrapIntegerLiteral(IntegerLiteral *il);
-Expression *wrapBooleanLiteral(BooleanLiteral *bl);
-Expression *wrapPrefixExpression(PrefixExpression *pe);
-Expression *wrapInfixExpression(InfixExpression *ie);
-Expression *wrapIfExpression(IfExpression *ifExpr);
-Expression *wrapFunctionLiteral(FunctionLiteral *fl);
-Expression *wrapCallExpression(CallExpression *ce);
-Expression *wrapStringLiteral(StringLiteral *sl);
-Expression *wrapArrayLiteral(ArrayLiteral *al);
-Expression *wrapIndexExpression(IndexExpression *ie);
-Expression *wrapHashLiteral(HashLiteral *hl);
-Statement *wrapLetStatement(LetStatement *stmt);
-Statement *wrapReturnStatement(ReturnStatement *stmt);
-Statement *wrapExpressionStatement(ExpressionStatement *stmt);
-Statement *wrapBlockStatement(BlockStatement *block);
+CallExpression *newCallExpression(AstArena *arena, Token token,
+                                  Expression *func, Expression **args,
+                                  int count);
+StringLiteral *newStringLiteral(AstArena *arena, Token token, const char *val);
+StringLiteral *newStringLiteralFromToken(AstArena *arena, Token token);
+ArrayLiteral *newArrayLiteral(AstArena *arena, Token token,
+                              Expression **elements, int count);
+IndexExpression *newIndexExpression(AstArena *arena, Token token,
+                                    Expression *left, Expression *index);
+HashLiteral *newHashLiteral(AstArena *arena, Token token, Expression **keys,
+                            Expression **values, int count);
+Identifier *newIdentifier(AstArena *arena, Token token, const char *value);
+// same, with the name materialized from the token's source slice
+Identifier *newIdentifierFromToken(AstArena *arena, Token token);
+IntegerLiteral *newIntegerLiteral(AstArena *arena, Token token,
+                                  long long value);
+BooleanLiteral *newBooleanLiteral(AstArena *arena, Token token, int value);
+PrefixExpression *newPrefixExpression(AstArena *arena, Token token,
+                                      const char *op, Expression *right);
+InfixExpression *newInfixExpression(AstArena *arena, Token token,
+                                    Expression *left, const char *op,
+                                    Expression *right);
+Expression *wrapIdentifier(AstArena *arena, Identifier *id);
+Expression *wrapIntegerLiteral(AstArena *arena, IntegerLiteral *il);
+Expression *wrapBooleanLiteral(AstArena *arena, BooleanLiteral *bl);
+Expression *wrapPrefixExpression(AstArena *arena, PrefixExpression *pe);
+Expression *wrapInfixExpression(AstArena *arena, InfixExpression *ie);
+Expression *wrapIfExpression(AstArena *arena, IfExpression *ifExpr);
+Expression *wrapFunctionLiteral(AstArena *arena, FunctionLiteral *fl);
+Expression *wrapCallExpression(AstArena *arena, CallExpression *ce);
+Expression *wrapStringLiteral(AstArena *arena, StringLiteral *sl);
+Expression *wrapArrayLiteral(AstArena *arena, ArrayLiteral *al);
+Expression *wrapIndexExpression(AstArena *arena, IndexExpression *ie);
+Expression *wrapHashLiteral(AstArena *arena, HashLiteral *hl);
+Statement *wrapLetStatement(AstArena *arena, LetStatement *stmt);
+Statement *wrapReturnStatement(AstArena *arena, ReturnStatement *stmt);
+Statement *wrapExpressionStatement(AstArena *arena, ExpressionStatement *stmt);
+Statement *wrapBlockStatement(AstArena *arena, BlockStatement *block);
+// source line of the token a node was parsed from, 0 if unknown
+int statementLine(const Statement *stmt);
+int expressionLine(const Expression *expr);
+// whether evaluating expr calls a function, i.e. it holds a call outside
+// of any function literal (whose body only runs when it is called)
+bool expressionCalls(const Expression *expr);
+// creates an empty program owning arena
+Program *newProgram(AstArena *arena);
 char *identifierToString(Identifier *ident);
 char *integerLiteralToString(IntegerLiteral *il);
 char *booleanLiteralToString(BooleanLiteral *bl);
@@ -224,15 +272,7 @@ char *blockStatementToString(BlockStatement *b);
 char *expressionToString(Expression *expr);
 char *statementToString(Statement *stmt);
 char *programToString(Program *program);
-void freeExpression(Expression *expr);
-void freeStatement(Statement *stmt);
+// releases the program and its whole tree
 void freeProgram(Program *program);
-void freeBlockStatement(BlockStatement *b);
-void freeIfExpression(IfExpression *ie);
-void freeFunctionLiteral(FunctionLiteral *fl);
-void freeCallExpression(CallExpression *ce);
-void freeStringLiteral(StringLiteral *s);
-void freeArrayLiteral(ArrayLiteral *al);
-void freeIndexExpression(IndexExpression *ie);
 
 #endif
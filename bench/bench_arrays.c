@@ -0,0 +1,164 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../object/object.h"
+
+// accumulating an array with push, as `fill(push(acc, x), n - 1)` does,
+// against push as it used to be: a fresh array with every element copied
+// (kept below as the baseline, freeing as it goes so memory stays flat; it
+// is quadratic, so it only runs on the smaller sizes). then reads in a
+// shuffled order, from the pushed vector and from a flat array, and a walk
+// with first and rest, against rest copying the remaining elements
+
+static const int PUSH_COUNTS[] = {1000, 10000, 100000, 1000000};
+#define MAX_BASELINE_COUNT 10000
+
+static Array *copyPush(Array *array, Object *value) {
+  Object *elements = malloc(sizeof(Object) * (array->count + 1));
+  memcpy(elements, array->elements, sizeof(Object) * array->count);
+  elements[array->count] = *value;
+  return newArray(elements, array->count + 1);
+}
+
+static double benchBaseline(Object *values, int count) {
+  Array *array = newArray(NULL, 0);
+  double start = now();
+  for (int i = 0; i < count; i++) {
+    Array *longer = copyPush(array, &values[i]);
+    free(array->elements);
+    free(array);
+    array = longer;
+  }
+  double elapsed = now() - start;
+  int ok = array->count == count;
+  free(array->elements);
+  free(array);
+  return ok ? elapsed / count * 1e9 : -1;
+}
+
+// through the builtin, as a program calls it
+static double benchVector(Object *values, int count, Object *result) {
+  BuiltinFunction push = getBuiltinByName(BuiltinFuncNamePush)->function;
+  Object array = {.type = ArrayObj, .array = newArray(NULL, 0)};
+  double start = now();
+  for (int i = 0; i < count; i++) {
+    array = *push((Object *[]){&array, &values[i]}, 2);
+  }
+  double elapsed = now() - start;
+  *result = array;
+  return array.array->count == count ? elapsed / count * 1e9 : -1;
+}
+
+static Array *copyRest(Array *array) {
+  Object *elements = malloc(sizeof(Object) * (array->count - 1));
+  memcpy(elements, array->elements + 1, sizeof(Object) * (array->count - 1));
+  return newArray(elements, array->count - 1);
+}
+
+// ns per step of sum(a) = first(a) + sum(rest(a)), through the builtins
+static double benchWalk(Array *array, int copy) {
+  BuiltinFunction first = getBuiltinByName(BuiltinFuncNameFirst)->function;
+  BuiltinFunction rest = getBuiltinByName(BuiltinFuncNameRest)->function;
+  Object current = {.type = ArrayObj, .array = array};
+  int count = array->count;
+  int64_t sum = 0;
+  double start = now();
+  while (current.array->count > 1) {
+    sum += first((Object *[]){&current}, 1)->integer->value;
+    if (copy) {
+      Array *shorter = copyRest(current.array);
+      if (current.array != array) {
+        free(current.array->elements);
+        free(current.array);
+      }
+      current.array = shorter;
+    } else {
+      current = *rest((Object *[]){&current}, 1);
+    }
+  }
+  sum += first((Object *[]){&current}, 1)->integer->value;
+  double elapsed = now() - start;
+  return sum == (int64_t)count * (count - 1) / 2 ? elapsed / count * 1e9 : -1;
+}
+
+static double benchReads(Array *array, int *order, int count) {
+  int64_t sum = 0;
+  Integer box;
+  double start = now();
+  for (int i = 0; i < count; i++) {
+    sum += arrayGetValue(array, order[i], &box).integer->value;
+  }
+  double elapsed = now() - start;
+  return sum == (int64_t)count * (count - 1) / 2 ? elapsed / count * 1e9 : -1;
+}
+
+static int benchCount(int count) {
+  Integer *ints = malloc(sizeof(Integer) * count);
+  Object *values = malloc(sizeof(Object) * count);
+  int *order = malloc(sizeof(int) * count);
+  for (int i = 0; i < count; i++) {
+    ints[i].value = i;
+    values[i] = (Object){.type = IntegerObj, .integer = &ints[i]};
+    order[i] = i;
+  }
+  unsigned long long state = 0x9e3779b97f4a7c15ULL;
+  for (int i = count - 1; i > 0; i--) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    int j = state % (i + 1);
+    int swap = order[i];
+    order[i] = order[j];
+    order[j] = swap;
+  }
+
+  Object vector;
+  double pushNs = benchVector(values, count, &vector);
+  double vectorRead = benchReads(vector.array, order, count);
+  Array *flat = newArray(values, count);
+  double flatRead = benchReads(flat, order, count);
+  double copyNs =
+      count <= MAX_BASELINE_COUNT ? benchBaseline(values, count) : 0;
+  double walkNs = benchWalk(flat, 0);
+  double copyWalkNs = count <= MAX_BASELINE_COUNT ? benchWalk(flat, 1) : 0;
+  if (pushNs < 0 || vectorRead < 0 || flatRead < 0 || copyNs < 0 ||
+      walkNs < 0 || copyWalkNs < 0) {
+    fprintf(stderr, "❌ wrong elements at %d\n", count);
+    return -1;
+  }
+
+  if (count <= MAX_BASELINE_COUNT) {
+    printf("🚀 %8d pushes: %8.1f -> %5.1f ns per push (copy -> vector), ",
+           count, copyNs, pushNs);
+  } else {
+    printf("🚀 %8d pushes: %8s -> %5.1f ns per push (copy skipped),   ",
+           count, "-", pushNs);
+  }
+  printf("read %4.1f -> %4.1f ns (flat -> vector)\n", flatRead, vectorRead);
+  if (count <= MAX_BASELINE_COUNT) {
+    printf("   %8d rest walk: %7.1f -> %5.1f ns per step (copy -> view)\n",
+           count, copyWalkNs, walkNs);
+  } else {
+    printf("   %8d rest walk: %7s -> %5.1f ns per step (copy skipped)\n",
+           count, "-", walkNs);
+  }
+
+  free(flat);
+  free(ints);
+  free(values);
+  free(order);
+  return 0;
+}
+
+int main() {
+  int runs = sizeof(PUSH_COUNTS) / sizeof(PUSH_COUNTS[0]);
+  for (int i = 0; i < runs; i++) {
+    if (benchCount(PUSH_COUNTS[i]) != 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../compiler/compiler.h"
+#include "../opcode/opcode.h"
+#include "../parser/parser.h"
+
+// compile time of a generated module made of thousands of top-level
+// function definitions, with the bodies compiled on 1, 2, 4 and 8 threads,
+// and the emitter's throughput in instructions per second
+
+#define FUNCTIONS 4000
+#define RUNS 3
+
+static const int THREADS[] = {1, 2, 4, 8};
+
+// every body is a few dozen statements of arithmetic, strings and calls
+static const char *BODY =
+    "let a = x * 2 + 1; let b = [a, a + 1, a + 2, \"item\"];"
+    "let c = {\"a\": a, \"b\": b[1]};"
+    "if (a > 10) { puts(\"big\", a); } else { puts(\"small\", a); };"
+    "let d = fn(y) { y * y + a - 3 }; let e = d(a) + d(b[0]) + len(b);"
+    "if (e == 42) { return c[\"a\"]; };"
+    "let s = \"alpha\" + \"beta\" + \"gamma\"; push(b, s); e - a * 7 + 99";
+
+static long countInstructions(Instructions ins, int length) {
+  long count = 0;
+  for (int pos = 0; pos < length; pos += instructionLengths[(int)ins[pos]]) {
+    count++;
+  }
+  return count;
+}
+
+// instructions in the main program and in every function
+static long totalInstructions(ByteCode *bytecode) {
+  long count =
+      countInstructions(bytecode->instructions, bytecode->instructionCount);
+  for (int i = 0; i < bytecode->constantsCount; i++) {
+    Object *constant = &bytecode->constants[i];
+    if (strcmp(constant->type, CompiledFunctionObj) == 0) {
+      count += countInstructions(constant->compiledFunction->instructions,
+                                 constant->compiledFunction->instructionCount);
+    }
+  }
+  return count;
+}
+
+static char *generateSource() {
+  size_t capacity = (size_t)FUNCTIONS * (strlen(BODY) + 64);
+  char *source = malloc(capacity);
+  if (!source) {
+    return NULL;
+  }
+  size_t length = 0;
+  for (int i = 0; i < FUNCTIONS; i++) {
+    length += snprintf(source + length, capacity - length,
+                       "let f = fn(x) { %s };\n", BODY);
+  }
+  return source;
+}
+
+int main() {
+  char *source = generateSource();
+  if (!source) {
+    fprintf(stderr, "❌ failed to allocate compiler input\n");
+    return 1;
+  }
+
+  Lexer *lexer = newLexer(source);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+
+  int counts = sizeof(THREADS) / sizeof(THREADS[0]);
+  for (int t = 0; t < counts; t++) {
+    double best = 0;
+    long instructions = 0;
+    for (int run = 0; run < RUNS; run++) {
+      Compiler *compiler = newCompiler();
+      compilerSetThreads(compiler, THREADS[t]);
+
+      double start = now();
+      int result = compileProgram(compiler, program);
+      double elapsed = now() - start;
+      if (result != 0) {
+        fprintf(stderr, "❌ compiling the module failed\n");
+        return 1;
+      }
+      if (best == 0 || elapsed < best) {
+        best = elapsed;
+      }
+
+      ByteCode *bytecode = getByteCode(compiler);
+      instructions = totalInstructions(bytecode);
+      free(bytecode);
+    }
+    printf("🚀 compile %d functions on %d thread(s): %.1f ms, %.1fM "
+           "instructions/s (best of %d)\n",
+           FUNCTIONS, THREADS[t], best * 1e3, instructions / best / 1e6, RUNS);
+  }
+
+  freeProgram(program);
+  freeParser(parser);
+  free(lexer);
+  free(source);
+  return 0;
+}
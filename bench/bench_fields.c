@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../compiler/compiler.h"
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../vm/vm.h"
+
+// reading one field of a record-like hash: OpIndex with the key on the
+// stack, which probes the table and compares the key, against an
+// OpGetField site whose inline cache already holds the record's shape.
+// then the compile time of a program with many record literals of distinct
+// keys, whose shapes are looked up by key list as each literal compiles
+
+#define READS 10000000
+#define SHAPES 20000
+
+static const char *SOURCE =
+    "let make = fn(n) { {\"id\": n, \"name\": \"Alice\", \"email\": \"a@b.c\", "
+    "\"age\": n + 30, \"city\": \"Springfield\", \"zip\": n * 7} };\n"
+    "let age = fn(person) { person[\"age\"] };\n"
+    "make(1)";
+
+// the constant holding the key of the field site in age()
+static int findKey(VM *vm, const char *name) {
+  for (int i = 0; i < vm->constantsCount; i++) {
+    Object *constant = &vm->constants[i];
+    if (strcmp(constant->type, StringObj) == 0 &&
+        strcmp(constant->string->value, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// ns per read, with the record pushed and the result popped each time
+static double benchReads(VM *vm, Object *record, int keyIndex, int cached) {
+  int64_t sum = 0;
+  double start = now();
+  for (int i = 0; i < READS; i++) {
+    push(vm, record);
+    if (cached) {
+      executeGetField(vm, keyIndex);
+    } else {
+      push(vm, &vm->constants[keyIndex]);
+      executeIndex(vm);
+    }
+    sum += pop(vm)->integer->value;
+  }
+  double elapsed = now() - start;
+
+  if (sum != (int64_t)READS * 31) {
+    fprintf(stderr, "❌ wrong field values read\n");
+    return -1;
+  }
+  return elapsed / READS * 1e9;
+}
+
+// ns per record literal, each with its own key
+static double benchShapes() {
+  size_t capacity = (size_t)SHAPES * 40;
+  char *source = malloc(capacity);
+  size_t length = snprintf(source, capacity, "let i = 1;\n");
+  for (int n = 0; n < SHAPES; n++) {
+    length += snprintf(source + length, capacity - length,
+                       "let r = {\"v%d\": i + 1};\n", n);
+  }
+  Lexer *lexer = newLexer(source);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+  Compiler *compiler = newCompiler();
+
+  double start = now();
+  int result = compileProgram(compiler, program);
+  double elapsed = now() - start;
+
+  int shapes = 0;
+  ByteCode *bytecode = getByteCode(compiler);
+  for (int n = 0; n < bytecode->constantsCount; n++) {
+    shapes += strcmp(bytecode->constants[n].type, HashObj) == 0;
+  }
+  free(bytecode);
+  freeProgram(program);
+  freeParser(parser);
+  free(lexer);
+  free(source);
+  return result == 0 && shapes == SHAPES ? elapsed / SHAPES * 1e9 : -1;
+}
+
+int main() {
+  Lexer *lexer = newLexer((char *)SOURCE);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+  Compiler *compiler = newCompiler();
+  if (compileProgram(compiler, program) != 0) {
+    fprintf(stderr, "❌ failed to compile the benchmark program\n");
+    return 1;
+  }
+
+  VM *vm = newVM(getByteCode(compiler));
+  if (run(vm) != 0) {
+    fprintf(stderr, "❌ failed to run the benchmark program\n");
+    return 1;
+  }
+  Object record = *pop(vm);
+  int keyIndex = findKey(vm, "age");
+  if (strcmp(record.type, HashObj) != 0 || !record.hash->shape ||
+      keyIndex < 0) {
+    fprintf(stderr, "❌ expected a record and a field site\n");
+    return 1;
+  }
+
+  double indexed = benchReads(vm, &record, keyIndex, 0);
+  double cached = benchReads(vm, &record, keyIndex, 1);
+  if (indexed < 0 || cached < 0) {
+    return 1;
+  }
+  printf("🚀 field read: %.1f ns (OpIndex) -> %.1f ns (OpGetField), %.1fx\n",
+         indexed, cached, indexed / cached);
+
+  double shapes = benchShapes();
+  if (shapes < 0) {
+    fprintf(stderr, "❌ wrong shapes compiled\n");
+    return 1;
+  }
+  printf("🚀 compile %d distinct record shapes: %.1f ns per literal\n",
+         SHAPES, shapes);
+
+  freeVM(vm);
+  return 0;
+}
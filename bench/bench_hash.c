@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../object/object.h"
+
+// hashSet/hashGet throughput from a thousand to ten million integer keys,
+// and up to a million string keys, against the chained table Hash used to
+// be (kept below as the baseline). lookups go in a shuffled order so the
+// large tables are measured out of cache, as real programs see them. the
+// last runs time persistent updates
+
+static const int KEY_COUNTS[] = {1000, 10000, 100000, 1000000, 10000000};
+#define MAX_STRING_KEYS 1000000
+
+// ===== BASELINE: CHAINED BUCKETS =====
+// one malloc'd node per pair, rehashed through the set path on resize
+
+typedef struct ChainedEntry ChainedEntry;
+struct ChainedEntry {
+  Object key;
+  Object value;
+  ChainedEntry *next;
+};
+
+typedef struct {
+  ChainedEntry **buckets;
+  int bucketCount;
+  int size;
+  int capacity;
+} Chained;
+
+static Chained *chainedNew() {
+  Chained *hash = malloc(sizeof(Chained));
+  hash->bucketCount = 16;
+  hash->size = 0;
+  hash->capacity = (int)(16 * 0.75);
+  hash->buckets = calloc(hash->bucketCount, sizeof(ChainedEntry *));
+  return hash;
+}
+
+static void chainedSet(Chained *hash, Object *key, Object *value);
+
+static void chainedResize(Chained *hash) {
+  int oldBucketCount = hash->bucketCount;
+  ChainedEntry **oldBuckets = hash->buckets;
+
+  hash->bucketCount *= 2;
+  hash->capacity = (int)(hash->bucketCount * 0.75);
+  hash->buckets = calloc(hash->bucketCount, sizeof(ChainedEntry *));
+  hash->size = 0;
+
+  for (int i = 0; i < oldBucketCount; i++) {
+    ChainedEntry *entry = oldBuckets[i];
+    while (entry) {
+      ChainedEntry *next = entry->next;
+      chainedSet(hash, &entry->key, &entry->value);
+      free(entry);
+      entry = next;
+    }
+  }
+  free(oldBuckets);
+}
+
+static void chainedSet(Chained *hash, Object *key, Object *value) {
+  if (hash->size >= hash->capacity) {
+    chainedResize(hash);
+  }
+
+  int bucket = getHashKey(key).value & (hash->bucketCount - 1);
+  for (ChainedEntry *entry = hash->buckets[bucket]; entry;
+       entry = entry->next) {
+    if (hashKeysEqual(&entry->key, key)) {
+      entry->value = *value;
+      return;
+    }
+  }
+
+  ChainedEntry *entry = malloc(sizeof(ChainedEntry));
+  entry->key = *key;
+  entry->value = *value;
+  entry->next = hash->buckets[bucket];
+  hash->buckets[bucket] = entry;
+  hash->size++;
+}
+
+static Object *chainedGet(Chained *hash, Object *key) {
+  int bucket = getHashKey(key).value & (hash->bucketCount - 1);
+  for (ChainedEntry *entry = hash->buckets[bucket]; entry;
+       entry = entry->next) {
+    if (hashKeysEqual(&entry->key, key)) {
+      return &entry->value;
+    }
+  }
+  return NULL;
+}
+
+static void chainedFree(Chained *hash) {
+  for (int i = 0; i < hash->bucketCount; i++) {
+    ChainedEntry *entry = hash->buckets[i];
+    while (entry) {
+      ChainedEntry *next = entry->next;
+      free(entry);
+      entry = next;
+    }
+  }
+  free(hash->buckets);
+  free(hash);
+}
+
+// ===== KEYS =====
+
+typedef struct {
+  Object *keys;   // in insertion order
+  Object *probes; // equal keys in their own objects, shuffled
+  Integer *ints;
+  String *strings;
+  char *text;
+  int count;
+} Keys;
+
+static unsigned long long rngState = 0x9e3779b97f4a7c15ULL;
+
+static unsigned long long nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 7;
+  rngState ^= rngState << 17;
+  return rngState;
+}
+
+// integers spread over the whole range, or strings of a typical length
+static int makeKeys(Keys *keys, int count, int strings) {
+  memset(keys, 0, sizeof(Keys));
+  keys->count = count;
+  keys->keys = malloc(sizeof(Object) * count);
+  keys->probes = malloc(sizeof(Object) * count);
+  if (strings) {
+    keys->strings = malloc(sizeof(String) * count * 2);
+    keys->text = malloc((size_t)count * 2 * 16);
+  } else {
+    keys->ints = malloc(sizeof(Integer) * count * 2);
+  }
+  if (!keys->keys || !keys->probes || (!keys->strings && !keys->ints) ||
+      (strings && !keys->text)) {
+    return -1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    unsigned long long value = nextRandom();
+    for (int copy = 0; copy < 2; copy++) {
+      Object *key = copy ? &keys->probes[i] : &keys->keys[i];
+      int slot = i * 2 + copy;
+      if (strings) {
+        char *text = keys->text + (size_t)slot * 16;
+        keys->strings[slot] = (String){
+            .value = text,
+            .length =
+                snprintf(text, 16, "user_%09llu", value % 1000000000ULL + i)};
+        *key = (Object){.type = StringObj, .string = &keys->strings[slot]};
+      } else {
+        keys->ints[slot].value = (int64_t)value;
+        *key = (Object){.type = IntegerObj, .integer = &keys->ints[slot]};
+      }
+    }
+  }
+
+  for (int i = count - 1; i > 0; i--) {
+    int j = nextRandom() % (i + 1);
+    Object probe = keys->probes[i];
+    keys->probes[i] = keys->probes[j];
+    keys->probes[j] = probe;
+  }
+  return 0;
+}
+
+static void freeKeys(Keys *keys) {
+  free(keys->keys);
+  free(keys->probes);
+  free(keys->ints);
+  free(keys->strings);
+  free(keys->text);
+}
+
+// ===== RUNS =====
+
+// ns per insert and per lookup, best of a few runs for the small tables
+static int benchTable(Keys *keys, int open, double *insertNs,
+                      double *lookupNs) {
+  int runs = keys->count <= 100000 ? 5 : 1;
+  *insertNs = 0;
+  *lookupNs = 0;
+  for (int run = 0; run < runs; run++) {
+    Hash *hash = open ? newHash() : NULL;
+    Chained *chained = open ? NULL : chainedNew();
+
+    double start = now();
+    for (int i = 0; i < keys->count; i++) {
+      if (open) {
+        hashSet(hash, &keys->keys[i], &keys->keys[i]);
+      } else {
+        chainedSet(chained, &keys->keys[i], &keys->keys[i]);
+      }
+    }
+    double inserted = now();
+
+    int found = 0;
+    for (int i = 0; i < keys->count; i++) {
+      Object *value = open ? hashGet(hash, &keys->probes[i])
+                           : chainedGet(chained, &keys->probes[i]);
+      found += value != NULL;
+    }
+    double looked = now();
+
+    if (open) {
+      freeHash(hash);
+    } else {
+      chainedFree(chained);
+    }
+    if (found != keys->count) {
+      fprintf(stderr, "❌ %d of %d keys found\n", found, keys->count);
+      return -1;
+    }
+
+    double insert = (inserted - start) / keys->count * 1e9;
+    double lookup = (looked - inserted) / keys->count * 1e9;
+    if (run == 0 || insert < *insertNs) {
+      *insertNs = insert;
+    }
+    if (run == 0 || lookup < *lookupNs) {
+      *lookupNs = lookup;
+    }
+  }
+  return 0;
+}
+
+static int benchKeys(int count, int strings) {
+  Keys keys;
+  if (makeKeys(&keys, count, strings) != 0) {
+    fprintf(stderr, "❌ failed to allocate %d keys\n", count);
+    freeKeys(&keys);
+    return -1;
+  }
+
+  double chainedInsert, chainedLookup, openInsert, openLookup;
+  if (benchTable(&keys, 0, &chainedInsert, &chainedLookup) != 0 ||
+      benchTable(&keys, 1, &openInsert, &openLookup) != 0) {
+    freeKeys(&keys);
+    return -1;
+  }
+
+  printf("🚀 %8d %s keys: insert %6.1f -> %6.1f ns, lookup %6.1f -> %6.1f "
+         "ns (chained -> open)\n",
+         count, strings ? "string " : "integer", chainedInsert, openInsert,
+         chainedLookup, openLookup);
+  freeKeys(&keys);
+  return 0;
+}
+
+// ===== PERSISTENT UPDATES =====
+// building a hash one pair at a time while keeping every version: set()
+// through the trie against copying the whole table for each new version
+
+#define MAX_VERSIONED_KEYS 10000
+
+static Hash *copyWith(Hash *hash, Object *key, Object *value) {
+  Hash *copy = newHash();
+  int cursor = 0;
+  HashEntry *entry;
+  while ((entry = hashNext(hash, &cursor)) != NULL) {
+    hashSet(copy, &entry->key, &entry->value);
+  }
+  hashSet(copy, key, value);
+  return copy;
+}
+
+static int benchVersions(int count) {
+  Keys keys;
+  if (makeKeys(&keys, count, 0) != 0) {
+    fprintf(stderr, "❌ failed to allocate %d keys\n", count);
+    freeKeys(&keys);
+    return -1;
+  }
+
+  double ns[2];
+  for (int trie = 0; trie < 2; trie++) {
+    Hash *hash = newHash();
+    double start = now();
+    for (int i = 0; i < count; i++) {
+      hash = trie ? hashWith(hash, &keys.keys[i], &keys.keys[i])
+                  : copyWith(hash, &keys.keys[i], &keys.keys[i]);
+    }
+    ns[trie] = (now() - start) / count * 1e9;
+    if (hash->size != count) {
+      fprintf(stderr, "❌ %d of %d keys kept\n", hash->size, count);
+      freeKeys(&keys);
+      return -1;
+    }
+  }
+
+  printf("🚀 %8d versions: %9.1f -> %6.1f ns per update (copy -> trie)\n",
+         count, ns[0], ns[1]);
+  freeKeys(&keys);
+  return 0;
+}
+
+int main() {
+  int runs = sizeof(KEY_COUNTS) / sizeof(KEY_COUNTS[0]);
+  for (int i = 0; i < runs; i++) {
+    if (benchKeys(KEY_COUNTS[i], 0) != 0) {
+      return 1;
+    }
+  }
+  for (int i = 0; i < runs && KEY_COUNTS[i] <= MAX_STRING_KEYS; i++) {
+    if (benchKeys(KEY_COUNTS[i], 1) != 0) {
+      return 1;
+    }
+  }
+  for (int i = 0; i < runs && KEY_COUNTS[i] <= MAX_VERSIONED_KEYS; i++) {
+    if (benchVersions(KEY_COUNTS[i]) != 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "../object/ints.h"
+#include "../object/object.h"
+
+// sum, min, max and dot over a million integers: boxed, as arrays of
+// integers used to be stored (an Object per element pointing at its own
+// malloc'd Integer), against the packed values through the plain c and the
+// avx2 kernels
+
+#define COUNT 1000000
+#define RUNS 20
+
+typedef struct {
+  Object *a;
+  Object *b;
+  int64_t *packedA;
+  int64_t *packedB;
+} Data;
+
+// the four reductions once over the boxed elements, folded into one value
+static int64_t reduceBoxed(Data *data) {
+  uint64_t sum = 0;
+  uint64_t dot = 0;
+  int64_t min = data->b[0].integer->value;
+  int64_t max = min;
+  for (int i = 0; i < COUNT; i++) {
+    int64_t a = data->a[i].integer->value;
+    int64_t b = data->b[i].integer->value;
+    sum += (uint64_t)a;
+    dot += (uint64_t)a * (uint64_t)b;
+  }
+  for (int i = 0; i < COUNT; i++) {
+    int64_t b = data->b[i].integer->value;
+    min = b < min ? b : min;
+  }
+  for (int i = 0; i < COUNT; i++) {
+    int64_t b = data->b[i].integer->value;
+    max = b > max ? b : max;
+  }
+  return (int64_t)(sum ^ dot ^ (uint64_t)min ^ (uint64_t)max);
+}
+
+static int64_t reducePacked(Data *data) {
+  uint64_t sum = (uint64_t)intsSum(data->packedA, COUNT);
+  uint64_t dot = (uint64_t)intsDot(data->packedA, data->packedB, COUNT);
+  int64_t min = intsMin(data->packedB, COUNT);
+  int64_t max = intsMax(data->packedB, COUNT);
+  return (int64_t)(sum ^ dot ^ (uint64_t)min ^ (uint64_t)max);
+}
+
+// ns per element for the four reductions, best of RUNS
+static double bench(Data *data, int packed, int64_t *result) {
+  double best = 0;
+  for (int run = 0; run < RUNS; run++) {
+    double start = now();
+    *result = packed ? reducePacked(data) : reduceBoxed(data);
+    double elapsed = now() - start;
+    if (run == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  return best / COUNT * 1e9;
+}
+
+int main() {
+  Data data;
+  data.a = malloc(sizeof(Object) * COUNT);
+  data.b = malloc(sizeof(Object) * COUNT);
+  data.packedA = malloc(sizeof(int64_t) * COUNT);
+  data.packedB = malloc(sizeof(int64_t) * COUNT);
+  unsigned long long state = 0x9e3779b97f4a7c15ULL;
+  for (int i = 0; i < COUNT; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    data.packedA[i] = (int64_t)(state % 2000001) - 1000000;
+    data.packedB[i] = (int64_t)(state >> 40) - (1 << 23);
+    data.a[i] = (Object){.type = IntegerObj, .integer = malloc(sizeof(Integer))};
+    data.b[i] = (Object){.type = IntegerObj, .integer = malloc(sizeof(Integer))};
+    data.a[i].integer->value = data.packedA[i];
+    data.b[i].integer->value = data.packedB[i];
+  }
+
+  int64_t boxedResult, scalarResult, avx2Result;
+  double boxed = bench(&data, 0, &boxedResult);
+  intsSetLevel(INTS_SCALAR);
+  double scalar = bench(&data, 1, &scalarResult);
+  int avx2 = intsSetLevel(INTS_AVX2) == INTS_AVX2;
+  double vector = bench(&data, 1, &avx2Result);
+  if (boxedResult != scalarResult || scalarResult != avx2Result) {
+    fprintf(stderr, "❌ reductions disagree\n");
+    return 1;
+  }
+
+  printf("🚀 sum+min+max+dot over %d integers: %.2f ns (boxed) -> %.2f ns "
+         "(packed) -> %.2f ns (packed, %s) per element\n",
+         COUNT, boxed, scalar, vector, avx2 ? "avx2" : "no avx2");
+  return 0;
+}
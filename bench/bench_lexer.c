@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../lexer/lexer.h"
+#include "../lexer/scan.h"
+
+// lexer throughput over generated multi-megabyte sources, once per scanner
+// implementation the cpu supports; with tokens being slices of the input
+// this loop should not allocate at all
+
+#define TARGET_BYTES (16 * 1024 * 1024)
+#define RUNS 5
+
+// ordinary code
+static const char *CODE_CHUNK =
+    "let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2); };\n"
+    "let greeting = \"hello, world\";\n"
+    "let values = [1, 2, 3, 4 * 5, 60 / 3];\n"
+    "let lookup = {\"one\": 1, \"two\": 2, true: false};\n"
+    "if (values[0] != 10 == !true) { puts(len(greeting)); } else { fib(25); }\n";
+
+// one row of a big data literal
+static const char *DATA_CHUNK =
+    "    {\"customer_identifier\": \"c0f8e2a4-93b1-4f77-a1d6-0c2f3b9a7e51\", "
+    "\"lifetime_value_in_cents\": 1234567890123, "
+    "\"shipping_address\": \"1600 Amphitheatre Parkway, Mountain View\", "
+    "\"order_ids\": [100000000001, 100000000002, 100000000003]},\n";
+
+static char *generateSource(const char *chunk, size_t *length) {
+  size_t chunkLength = strlen(chunk);
+  size_t copies = TARGET_BYTES / chunkLength;
+  char *source = malloc(copies * chunkLength + 1);
+  if (!source) {
+    return NULL;
+  }
+
+  for (size_t i = 0; i < copies; i++) {
+    memcpy(source + i * chunkLength, chunk, chunkLength);
+  }
+  source[copies * chunkLength] = '\0';
+  *length = copies * chunkLength;
+  return source;
+}
+
+static double lexBest(char *source, long *tokens) {
+  double best = 0;
+  for (int run = 0; run < RUNS; run++) {
+    Lexer *lexer = newLexer(source);
+    *tokens = 0;
+
+    double start = now();
+    for (Token tok = nextToken(lexer); tok.type != EOF_TOK;
+         tok = nextToken(lexer)) {
+      (*tokens)++;
+    }
+    double elapsed = now() - start;
+
+    if (best == 0 || elapsed < best) {
+      best = elapsed;
+    }
+    free(lexer);
+  }
+  return best;
+}
+
+static int benchSource(const char *name, const char *chunk) {
+  size_t length;
+  char *source = generateSource(chunk, &length);
+  if (!source) {
+    fprintf(stderr, "❌ failed to allocate lexer input\n");
+    return 1;
+  }
+
+  long tokens = 0;
+  printf("📏 %s input: %.1f MB\n", name, length / 1e6);
+  for (int level = SCAN_SCALAR; level <= SCAN_AVX2; level++) {
+    if (scanSetLevel(level) != (ScanLevel)level) {
+      continue; // not supported by this cpu
+    }
+    double best = lexBest(source, &tokens);
+    printf("🚀 lexer throughput (%s, %s): %.1f MB/s, %ld tokens (best of %d)\n",
+           name, scanLevelName(level), length / 1e6 / best, tokens, RUNS);
+  }
+
+  free(source);
+  return 0;
+}
+
+int main() {
+  if (benchSource("code", CODE_CHUNK) != 0 ||
+      benchSource("data", DATA_CHUNK) != 0) {
+    return 1;
+  }
+  return 0;
+}
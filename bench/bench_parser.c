@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../parser/parser.h"
+
+// parser throughput and AST footprint over a generated multi-megabyte
+// source; the whole tree lives in one arena, so its size is the memory the
+// AST costs and freeing it is a single call
+
+#define TARGET_BYTES (16 * 1024 * 1024)
+
+static const char *CHUNK =
+    "let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2); };\n"
+    "let greeting = \"hello, world\";\n"
+    "let values = [1, 2, 3, 4 * 5, 60 / 3];\n"
+    "let lookup = {\"one\": 1, \"two\": 2, true: false};\n"
+    "if (values[0] != 10 == !true) { puts(len(greeting)); } else { fib(25); }\n";
+
+int main() {
+  size_t chunkLength = strlen(CHUNK);
+  size_t copies = TARGET_BYTES / chunkLength;
+  size_t length = copies * chunkLength;
+  char *source = malloc(length + 1);
+  if (!source) {
+    fprintf(stderr, "❌ failed to allocate parser input\n");
+    return 1;
+  }
+  for (size_t i = 0; i < copies; i++) {
+    memcpy(source + i * chunkLength, CHUNK, chunkLength);
+  }
+  source[length] = '\0';
+
+  double start = now();
+  Lexer *lexer = newLexer(source);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+  double parsed = now();
+
+  if (parser->errorCount > 0) {
+    fprintf(stderr, "❌ parse error: %s\n", parser->errors[0]);
+    return 1;
+  }
+
+  size_t astBytes = program->arena->bytes;
+  int statements = program->statementCount;
+  freeProgram(program);
+  double freed = now();
+
+  printf("📏 parser input: %.1f MB, %d top-level statements\n", length / 1e6,
+         statements);
+  printf("🚀 parser throughput: %.1f MB/s\n", length / 1e6 / (parsed - start));
+  printf("🌳 AST arena: %.1f MB (%.2fx source), freed in %.2f ms\n",
+         astBytes / 1e6, (double)astBytes / length, (freed - parsed) * 1e3);
+
+  freeParser(parser);
+  free(lexer);
+  free(source);
+  return 0;
+}
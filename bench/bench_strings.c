@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../vm/vm.h"
+
+// building a string with repeated + up to 10 MB, 100 bytes at a time, then
+// reading it once as puts would. the baseline is the concatenation strings
+// used to have: strlen both sides, malloc, strcpy and strcat, which copies
+// the whole left operand on every append. it is quadratic, so it only runs
+// on the smaller sizes (and frees as it goes so memory stays flat)
+
+static const int TARGET_SIZES[] = {100000, 1000000, 10000000};
+#define MAX_BASELINE_SIZE 1000000
+#define PIECE_LENGTH 100
+
+static char *baselineConcat(char *left, char *right) {
+  char *result = malloc(strlen(left) + strlen(right) + 1);
+  strcpy(result, left);
+  strcat(result, right);
+  return result;
+}
+
+static double benchBaseline(char *piece, int appends) {
+  char *text = malloc(1);
+  text[0] = '\0';
+  double start = now();
+  for (int i = 0; i < appends; i++) {
+    char *longer = baselineConcat(text, piece);
+    free(text);
+    text = longer;
+  }
+  double elapsed = now() - start;
+
+  int ok = strlen(text) == (size_t)appends * PIECE_LENGTH;
+  free(text);
+  return ok ? elapsed : -1;
+}
+
+// through the vm's OpAdd, as `s = s + piece` in a loop would run
+static double benchRopes(VM *vm, Object *piece, int appends,
+                         double *flattenTime) {
+  String empty = {.value = "", .length = 0};
+  Object text = {.type = StringObj, .string = &empty};
+  double start = now();
+  for (int i = 0; i < appends; i++) {
+    push(vm, &text);
+    push(vm, piece);
+    if (executeBinaryOperation(vm, OpAdd) != 0) {
+      return -1;
+    }
+    text = *pop(vm);
+  }
+  double built = now();
+  char *bytes = stringValue(text.string);
+  *flattenTime = now() - built;
+
+  if (strlen(bytes) != (size_t)appends * PIECE_LENGTH ||
+      memcmp(bytes + (size_t)(appends - 1) * PIECE_LENGTH, piece->string->value,
+             PIECE_LENGTH) != 0) {
+    return -1;
+  }
+  return built - start;
+}
+
+int main() {
+  char pieceText[PIECE_LENGTH + 1];
+  for (int i = 0; i < PIECE_LENGTH; i++) {
+    pieceText[i] = 'a' + i % 26;
+  }
+  pieceText[PIECE_LENGTH] = '\0';
+  String pieceString = {.value = pieceText, .length = PIECE_LENGTH};
+  Object piece = {.type = StringObj, .string = &pieceString};
+
+  ByteCode bytecode = {0};
+  VM *vm = newVM(&bytecode);
+
+  int runs = sizeof(TARGET_SIZES) / sizeof(TARGET_SIZES[0]);
+  for (int i = 0; i < runs; i++) {
+    int appends = TARGET_SIZES[i] / PIECE_LENGTH;
+    double flattenTime;
+    double ropeTime = benchRopes(vm, &piece, appends, &flattenTime);
+    if (ropeTime < 0) {
+      fprintf(stderr, "❌ wrong string built by ropes\n");
+      return 1;
+    }
+
+    if (TARGET_SIZES[i] <= MAX_BASELINE_SIZE) {
+      double flatTime = benchBaseline(pieceText, appends);
+      if (flatTime < 0) {
+        fprintf(stderr, "❌ wrong string built by the baseline\n");
+        return 1;
+      }
+      printf("🚀 %8d bytes: %9.2f ms -> %6.2f ms + %5.2f ms flatten "
+             "(strcat -> rope)\n",
+             TARGET_SIZES[i], flatTime * 1e3, ropeTime * 1e3,
+             flattenTime * 1e3);
+    } else {
+      printf("🚀 %8d bytes: %9s    -> %6.2f ms + %5.2f ms flatten "
+             "(strcat skipped)\n",
+             TARGET_SIZES[i], "-", ropeTime * 1e3, flattenTime * 1e3);
+    }
+  }
+
+  freeVM(vm);
+  return 0;
+}
@@ -0,0 +1,80 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+// size of the vm_stub that every `monkeyc build` output embeds, and the time
+// a built program takes from exec to exit for a trivial script
+
+#define MONKEYC "bin/monkeyc"
+#define VM_STUB "bin/vm_stub"
+#define PROGRAM_SOURCE "tests/mon/01_arithmetic.mon"
+#define PROGRAM "bin/bench_stub_program"
+#define RUNS 200
+
+static long fileSize(const char *path) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    return -1;
+  }
+  return st.st_size;
+}
+
+// run path with stdout discarded; returns the exit status or -1
+static int runQuiet(char *const argv[]) {
+  pid_t pid = fork();
+  if (pid < 0) {
+    return -1;
+  }
+  if (pid == 0) {
+    if (!freopen("/dev/null", "w", stdout)) {
+      _exit(127);
+    }
+    execv(argv[0], argv);
+    _exit(127);
+  }
+
+  int status;
+  if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)) {
+    return -1;
+  }
+  return WEXITSTATUS(status);
+}
+
+int main() {
+  long stubSize = fileSize(VM_STUB);
+  if (stubSize < 0) {
+    fprintf(stderr, "❌ %s not found, run make first\n", VM_STUB);
+    return 1;
+  }
+
+  char *build[] = {MONKEYC, "build", PROGRAM_SOURCE, "-o", PROGRAM, NULL};
+  if (runQuiet(build) != 0) {
+    fprintf(stderr, "❌ failed to build %s\n", PROGRAM_SOURCE);
+    return 1;
+  }
+
+  char *program[] = {PROGRAM, NULL};
+  runQuiet(program); // warm the page cache
+
+  double start = now();
+  for (int i = 0; i < RUNS; i++) {
+    if (runQuiet(program) != 0) {
+      fprintf(stderr, "❌ %s failed\n", PROGRAM);
+      return 1;
+    }
+  }
+  double elapsed = now() - start;
+
+  printf("📦 vm_stub size: %ld bytes\n", stubSize);
+  printf("📦 built program size: %ld bytes\n", fileSize(PROGRAM));
+  printf("🚀 startup: %.1f us per run (%d runs)\n", elapsed / RUNS * 1e6, RUNS);
+
+  unlink(PROGRAM);
+  return 0;
+}
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../compiler/compiler.h"
+#include "../parser/parser.h"
+
+// compile time of generated scripts with many top-level globals, each one
+// defined from the previous one; symbol definition and resolution should
+// stay constant-time, so time per global must not grow with the count
+
+static const int GLOBAL_COUNTS[] = {12500, 25000, 50000};
+
+// identifiers are letters only, so global i is named g followed by i in
+// base 26
+static int globalName(char *out, int i) {
+  int length = 0;
+  out[length++] = 'g';
+  do {
+    out[length++] = 'a' + i % 26;
+    i /= 26;
+  } while (i > 0);
+  out[length] = '\0';
+  return length;
+}
+
+// let ga = 0; let gb = ga + 1; ...
+static char *generateSource(int globals) {
+  size_t capacity = (size_t)globals * 40 + 1;
+  char *source = malloc(capacity);
+  if (!source) {
+    return NULL;
+  }
+
+  char name[16];
+  char previous[16];
+  globalName(name, 0);
+  size_t length = snprintf(source, capacity, "let %s = 0;\n", name);
+  for (int i = 1; i < globals; i++) {
+    globalName(previous, i - 1);
+    globalName(name, i);
+    length += snprintf(source + length, capacity - length,
+                       "let %s = %s + 1;\n", name, previous);
+  }
+  return source;
+}
+
+int main() {
+  int runs = sizeof(GLOBAL_COUNTS) / sizeof(GLOBAL_COUNTS[0]);
+  for (int run = 0; run < runs; run++) {
+    int globals = GLOBAL_COUNTS[run];
+    char *source = generateSource(globals);
+    if (!source) {
+      fprintf(stderr, "❌ failed to allocate compiler input\n");
+      return 1;
+    }
+
+    Lexer *lexer = newLexer(source);
+    Parser *parser = newParser(lexer);
+    Program *program = parseProgram(parser);
+
+    Compiler *compiler = newCompiler();
+    double start = now();
+    int result = compileProgram(compiler, program);
+    double elapsed = now() - start;
+    if (result != 0) {
+      fprintf(stderr, "❌ compiling %d globals failed\n", globals);
+      return 1;
+    }
+
+    printf("🚀 compile %d globals: %.1f ms, %.0f ns per global\n", globals,
+           elapsed * 1e3, elapsed / globals * 1e9);
+
+    freeProgram(program);
+    freeParser(parser);
+    free(lexer);
+    free(source);
+  }
+  return 0;
+}
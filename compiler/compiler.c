@@ -1,48 +1,94 @@
 #include "compiler.h"
 #include "../opcode/opcode.h"
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 // initial capacities for dynamic arrays - these grow as needed
 #define INITIAL_CONSTANTS_CAPACITY 256     // constants pool starting size
 #define INITIAL_INSTRUCTIONS_CAPACITY 1024 // bytecode instructions starting size
 #define INITIAL_SCOPES_CAPACITY 8          // compilation scopes starting size
-
+#define INITIAL_JOBS_CAPACITY 16           // queued function bodies
+#define INITIAL_PENDING_CAPACITY 64        // constants waiting on them
+#define INITIAL_LINES_CAPACITY 16          // line table entries per scope
+#define INITIAL_SHAPES_CAPACITY 16         // record shape index slots
+
+// compileStatement flushes once this many bodies or constants are waiting,
+// which bounds both the memory held and the operand range of pending slots
+#define COMPILE_BATCH_JOBS 1024
+#define COMPILE_BATCH_CONSTANTS 16384
+#define MAX_COMPILE_THREADS 64
+
+// a top-level function literal whose body is compiled by compileFlush. it
+// sees the globals defined before it and nothing else, which is what
+// compiling it in place would have seen
+struct CompileJob {
+  FunctionLiteral *literal;
+  int position;       // main-scope offset of the OpConstant that loads it
+  int globalLimit;    // numDefinitions of the global table when queued
+  Object *constants;  // the body's constants, then the function itself
+  int constantsCount;
+  ShapeEntry *shapes; // the body's record shapes, indexing constants
+  int shapeCapacity;
+  int failed;
+};
+
+// main-scope constants keep their order relative to the queued bodies:
+// either a ready object, or the function a job produces
+struct PendingConstant {
+  Object object;
+  int job; // index into jobs, PENDING_OBJECT or PENDING_SHAPE for object
+};
+
+#define PENDING_OBJECT -1
+// a record shape, which compileFlush adds only if the pool lacks its keys
+#define PENDING_SHAPE -2
+
+// a record shape, by the keys it holds in order
+struct ShapeEntry {
+  Hash *shape; // NULL for an empty slot
+  uint64_t hash;
+  int index; // in the constant pool, -1 until it is added there
+  int slot;  // pending slot standing for it while bodies are queued, or -1
+};
+
+static int compileStatementNode(Compiler *compiler, Statement *statement);
+static int compileStatementBody(Compiler *compiler, Statement *statement);
 static int compileExpression(Compiler *compiler, Expression *expression);
+static int compileExpressionBody(Compiler *compiler, Expression *expression);
+static int compileFunctionLiteral(Compiler *compiler, FunctionLiteral *funcLit);
+static int queueFunction(Compiler *compiler, FunctionLiteral *funcLit);
 static int compileBlockStatement(Compiler *compiler, BlockStatement *block);
 static int emit(Compiler *compiler, OpCode opCode, int *operands,
                 int operandCount);
 static int addConstant(Compiler *compiler, Object *obj);
+static int appendConstant(Compiler *compiler, Object *obj);
+static int addPending(Compiler *compiler, Object obj, int job);
 static void setLastInstruction(Compiler *compiler, OpCode opCode, int position);
 static int lastInstructionIs(Compiler *compiler, OpCode opCode);
 static void removeLastPop(Compiler *compiler);
-static void replaceInstruction(Compiler *compiler, int pos,
-                               Instructions newInstruction, int length);
 static void changeOperand(Compiler *compiler, int opPos, int operand);
 static Instructions getCurrentInstructions(Compiler *compiler);
+static int getCurrentInstructionsLength(Compiler *compiler);
 static void enterScope(Compiler *compiler);
 static Instructions leaveScope(Compiler *compiler, int *length);
 static void replaceLastPopWithReturn(Compiler *compiler);
 static void loadSymbol(Compiler *compiler, Symbol symbol);
-static int addInstruction(Compiler *compiler, Instructions ins, int length);
+static void recordLine(CompilationScope *scope, int pc, int line);
+static void truncateLines(CompilationScope *scope, int end);
 
-Compiler *newCompiler() {
+// a compiler with an empty main scope over the given symbol table
+static Compiler *allocCompiler(SymbolTable *symbolTable) {
   Compiler *compiler = malloc(sizeof(Compiler));
 
   compiler->constants = malloc(sizeof(Object) * INITIAL_CONSTANTS_CAPACITY);
   compiler->constantsCount = 0;
   compiler->constantsCapacity = INITIAL_CONSTANTS_CAPACITY;
 
-  compiler->symbolTable = newSymbolTable();
-
-  // define built-in functions in symbol table
-  const char* builtinNames[] = {"len", "first", "last", "rest", "push", "puts"};
-  const int builtinCount = sizeof(builtinNames) / sizeof(builtinNames[0]);
-  
-  for (int i = 0; i < builtinCount; i++) {
-    defineBuiltin(compiler->symbolTable, (char*)builtinNames[i], i);
-  }
+  compiler->symbolTable = symbolTable;
 
   // Initialize scopes
   compiler->scopes = malloc(sizeof(CompilationScope) * INITIAL_SCOPES_CAPACITY);
@@ -56,10 +102,62 @@ Compiler *newCompiler() {
   compiler->scopes[0].instructionsCapacity = INITIAL_INSTRUCTIONS_CAPACITY;
   compiler->scopes[0].lastInstruction = (EmittedInstruction){0, -1};
   compiler->scopes[0].previousInstruction = (EmittedInstruction){0, -1};
+  compiler->scopes[0].lines = NULL;
+  compiler->scopes[0].lineCount = 0;
+  compiler->scopes[0].lineCapacity = 0;
+
+  compiler->threads = 1;
+  compiler->jobs = NULL;
+  compiler->jobCount = 0;
+  compiler->jobCapacity = 0;
+  compiler->pending = NULL;
+  compiler->pendingCount = 0;
+  compiler->pendingCapacity = 0;
+  compiler->pendingStart = 0;
+  compiler->shapes = NULL;
+  compiler->shapeCount = 0;
+  compiler->shapeCapacity = 0;
+  compiler->globalLimit = INT_MAX;
+  compiler->line = 0;
+
+  return compiler;
+}
+
+static int defaultThreads() {
+  char *value = getenv("MONKEYC_COMPILE_THREADS");
+  if (value) {
+    return atoi(value);
+  }
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return cpus > 0 ? (int)cpus : 1;
+}
+
+Compiler *newCompiler() {
+  Compiler *compiler = allocCompiler(newSymbolTable());
 
+  // define built-in functions in symbol table
+  const char* builtinNames[] = {"len", "first", "last", "rest", "push",
+                                "puts", "set",   "delete", "sum", "min",
+                                "max", "dot"};
+  const int builtinCount = sizeof(builtinNames) / sizeof(builtinNames[0]);
+  
+  for (int i = 0; i < builtinCount; i++) {
+    defineBuiltin(compiler->symbolTable, (char*)builtinNames[i], i);
+  }
+
+  compilerSetThreads(compiler, defaultThreads());
   return compiler;
 }
 
+void compilerSetThreads(Compiler *compiler, int threads) {
+  if (threads < 1) {
+    threads = 1;
+  } else if (threads > MAX_COMPILE_THREADS) {
+    threads = MAX_COMPILE_THREADS;
+  }
+  compiler->threads = threads;
+}
+
 Compiler *newCompilerWithState(SymbolTable *symbolTable, Object *constants) {
   Compiler *compiler = newCompiler();
   compiler->symbolTable = symbolTable;
@@ -72,11 +170,30 @@ Compiler *newCompilerWithState(SymbolTable *symbolTable, Object *constants) {
 }
 
 int compileProgram(Compiler *compiler, Program *program) {
+  return compileProgramWithMark(compiler, program, -1, NULL);
+}
+
+int compileProgramWithMark(Compiler *compiler, Program *program, int mark,
+                           int *markPosition) {
   for (int i = 0; i < program->statementCount; i++) {
+    if (i == mark && markPosition) {
+      *markPosition = getCurrentInstructionsLength(compiler);
+    }
     if (compileStatement(compiler, program->statements[i]) != 0) {
       return -1;
     }
   }
+  if (mark >= program->statementCount && markPosition) {
+    *markPosition = getCurrentInstructionsLength(compiler);
+  }
+
+  return compileFinish(compiler);
+}
+
+int compileFinish(Compiler *compiler) {
+  if (compileFlush(compiler) != 0) {
+    return -1;
+  }
 
   /*
    * If the last emitted instruction was a pop, remove it. This keeps the
@@ -86,25 +203,70 @@ int compileProgram(Compiler *compiler, Program *program) {
   if (lastInstructionIs(compiler, OpPop)) {
     removeLastPop(compiler);
   }
-
   return 0;
 }
 
 int compileStatement(Compiler *compiler, Statement *statement) {
-  if (!statement || !statement->type) {
+  if (compileStatementNode(compiler, statement) != 0) {
+    return -1;
+  }
+  if (compiler->jobCount >= COMPILE_BATCH_JOBS ||
+      compiler->pendingCount >= COMPILE_BATCH_CONSTANTS) {
+    return compileFlush(compiler);
+  }
+  return 0;
+}
+
+// what a node emits is attributed to its line, and its parent's line is
+// back in effect for whatever the parent emits after it
+static int compileStatementNode(Compiler *compiler, Statement *statement) {
+  int line = compiler->line;
+  int own = statementLine(statement);
+  if (own > 0) {
+    compiler->line = own;
+  }
+  int result = compileStatementBody(compiler, statement);
+  compiler->line = line;
+  return result;
+}
+
+static int compileExpression(Compiler *compiler, Expression *expression) {
+  int line = compiler->line;
+  int own = expressionLine(expression);
+  if (own > 0) {
+    compiler->line = own;
+  }
+  int result = compileExpressionBody(compiler, expression);
+  compiler->line = line;
+  return result;
+}
+
+static int compileStatementBody(Compiler *compiler, Statement *statement) {
+  if (!statement) {
     return -1;
   }
 
-  if (strcmp(statement->type, NODE_EXPRESSION_STATEMENT) == 0) {
+  if (statement->type == NODE_EXPRESSION_STATEMENT) {
     ExpressionStatement *exprStmt = statement->expressionStatement;
     if (compileExpression(compiler, exprStmt->expression) != 0) {
       return -1;
     }
     emit(compiler, OpPop, NULL, 0);
 
-  } else if (strcmp(statement->type, NODE_LET_STATEMENT) == 0) {
+  } else if (statement->type == NODE_LET_STATEMENT) {
     LetStatement *letStmt = statement->letStatement;
-    Symbol symbol = define(compiler->symbolTable, letStmt->name->value);
+
+    // queued bodies have to see the symbol this one replaces
+    Symbol existing;
+    if (compiler->jobCount > 0 &&
+        resolveInterned(compiler->symbolTable, letStmt->name->value,
+                        &existing) == 0 &&
+        compileFlush(compiler) != 0) {
+      return -1;
+    }
+
+    Symbol symbol =
+        defineInterned(compiler->symbolTable, letStmt->name->value);
 
     if (compileExpression(compiler, letStmt->value) != 0) {
       return -1;
@@ -118,14 +280,14 @@ int compileStatement(Compiler *compiler, Statement *statement) {
       emit(compiler, OpSetLocal, operands, 1);
     }
 
-  } else if (strcmp(statement->type, NODE_RETURN_STATEMENT) == 0) {
+  } else if (statement->type == NODE_RETURN_STATEMENT) {
     ReturnStatement *returnStmt = statement->returnStatement;
     if (compileExpression(compiler, returnStmt->return_value) != 0) {
       return -1;
     }
     emit(compiler, OpReturnValue, NULL, 0);
 
-  } else if (strcmp(statement->type, NODE_BLOCK_STATEMENT) == 0) {
+  } else if (statement->type == NODE_BLOCK_STATEMENT) {
     BlockStatement *blockStmt = statement->blockStatement;
     return compileBlockStatement(compiler, blockStmt);
 
@@ -136,12 +298,245 @@ int compileStatement(Compiler *compiler, Statement *statement) {
   return 0;
 }
 
-static int compileExpression(Compiler *compiler, Expression *expression) {
-  if (!expression || !expression->type) {
+// whether expression can be built once at compile time: a scalar literal,
+// or a non-empty array or hash literal made only of constant literals.
+// hash keys must be scalars, the only hashable objects. one object in the
+// constant pool is shared by every evaluation of the literal, which is safe
+// because no version of an array or hash ever changes what another one
+// sees: each keeps its own count and start and only writes past its own
+// end, and set and delete build new hashes
+static bool isScalarLiteral(Expression *expression) {
+  return expression->type == NODE_INTEGER_LITERAL ||
+         expression->type == NODE_STRING_LITERAL ||
+         expression->type == NODE_BOOLEAN;
+}
+
+static bool isConstantLiteral(Expression *expression) {
+  if (isScalarLiteral(expression)) {
+    return true;
+  }
+  if (expression->type == NODE_ARRAY_LITERAL) {
+    ArrayLiteral *arrayLit = expression->arrayLiteral;
+    for (int i = 0; i < arrayLit->count; i++) {
+      if (!isConstantLiteral(arrayLit->elements[i])) {
+        return false;
+      }
+    }
+    return arrayLit->count > 0;
+  }
+  if (expression->type == NODE_HASH_LITERAL) {
+    HashLiteral *hashLit = expression->hashLiteral;
+    for (int i = 0; i < hashLit->count; i++) {
+      if (!isScalarLiteral(hashLit->keys[i]) ||
+          !isConstantLiteral(hashLit->values[i])) {
+        return false;
+      }
+    }
+    return hashLit->count > 0;
+  }
+  return false;
+}
+
+// builds the object a constant literal evaluates to, as OpArray and OpHash
+// would have at runtime, duplicate hash keys included
+static void buildConstant(Expression *expression, Object *out) {
+  if (expression->type == NODE_INTEGER_LITERAL) {
+    out->type = IntegerObj;
+    out->integer = malloc(sizeof(Integer));
+    out->integer->value = expression->integerLiteral->value;
+
+  } else if (expression->type == NODE_STRING_LITERAL) {
+    char *value = expression->stringLiteral->value;
+    int length = strlen(value);
+    char *copy = malloc(length + 1);
+    memcpy(copy, value, length + 1);
+    out->type = StringObj;
+    out->string = newString(copy, length);
+
+  } else if (expression->type == NODE_BOOLEAN) {
+    out->type = BooleanObj;
+    out->boolean = malloc(sizeof(Boolean));
+    out->boolean->value = expression->booleanLiteral->value;
+
+  } else if (expression->type == NODE_ARRAY_LITERAL) {
+    ArrayLiteral *arrayLit = expression->arrayLiteral;
+    out->type = ArrayObj;
+    Object *elements = malloc(sizeof(Object) * arrayLit->count);
+    for (int i = 0; i < arrayLit->count; i++) {
+      buildConstant(arrayLit->elements[i], &elements[i]);
+    }
+    out->array = newArrayOf(elements, arrayLit->count);
+
+  } else {
+    HashLiteral *hashLit = expression->hashLiteral;
+    out->type = HashObj;
+    out->hash = newHash();
+    for (int i = 0; i < hashLit->count; i++) {
+      Object key, value;
+      buildConstant(hashLit->keys[i], &key);
+      buildConstant(hashLit->values[i], &value);
+      hashSet(out->hash, &key, &value);
+    }
+    out->hash->shape = out->hash; // lives as long as the constant pool
+  }
+}
+
+// the keys of a shape, in order, folded into one hash
+static uint64_t shapeHash(Hash *shape) {
+  uint64_t h = 0xcbf29ce484222325ull ^ (uint64_t)shape->size;
+  for (int i = 0; i < shape->size; i++) {
+    h = (h ^ stringHash(shape->entries[i].key.string)) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+static bool sameKeys(Hash *a, Hash *b) {
+  if (a->size != b->size) {
+    return false;
+  }
+  for (int i = 0; i < a->size; i++) {
+    if (!hashKeysEqual(&a->entries[i].key, &b->entries[i].key)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the entry for shape's key list, or the empty slot where it would go
+static ShapeEntry *findShapeEntry(ShapeEntry *shapes, int capacity,
+                                  Hash *shape, uint64_t hash) {
+  size_t mask = capacity - 1;
+  for (size_t i = (size_t)(hash >> 32) & mask;; i = (i + 1) & mask) {
+    ShapeEntry *entry = &shapes[i];
+    if (!entry->shape ||
+        (entry->hash == hash && sameKeys(entry->shape, shape))) {
+      return entry;
+    }
+  }
+}
+
+static void growShapes(Compiler *compiler) {
+  int capacity = compiler->shapeCapacity ? compiler->shapeCapacity * 2
+                                         : INITIAL_SHAPES_CAPACITY;
+  ShapeEntry *shapes = calloc(capacity, sizeof(ShapeEntry));
+  for (int i = 0; i < compiler->shapeCapacity; i++) {
+    ShapeEntry *entry = &compiler->shapes[i];
+    if (entry->shape) {
+      *findShapeEntry(shapes, capacity, entry->shape, entry->hash) = *entry;
+    }
+  }
+  free(compiler->shapes);
+  compiler->shapes = shapes;
+  compiler->shapeCapacity = capacity;
+}
+
+// the entry for shape's keys, holding shape itself if there was none yet
+static ShapeEntry *shapeEntry(Compiler *compiler, Hash *shape) {
+  if ((compiler->shapeCount + 1) * 2 > compiler->shapeCapacity) {
+    growShapes(compiler);
+  }
+  uint64_t hash = shapeHash(shape);
+  ShapeEntry *entry = findShapeEntry(compiler->shapes, compiler->shapeCapacity,
+                                     shape, hash);
+  if (!entry->shape) {
+    *entry = (ShapeEntry){shape, hash, -1, -1};
+    compiler->shapeCount++;
+  }
+  return entry;
+}
+
+// the constant index of a record of shape's keys; shape is freed when a
+// shape with the same keys in the same order was there first. while bodies
+// are queued, operands name a pending slot, and compileFlush adds the shape
+// only if neither the pool nor a body merged before it already has it
+static int internShape(Compiler *compiler, Hash *shape) {
+  ShapeEntry *entry = shapeEntry(compiler, shape);
+  if (entry->shape != shape) {
+    freeHash(shape);
+  } else {
+    shape->shape = shape;
+  }
+  Object obj = {.type = HashObj, .hash = entry->shape};
+  if (compiler->jobCount == 0) {
+    if (entry->index < 0) {
+      entry->index = appendConstant(compiler, &obj);
+    }
+    return entry->index;
+  }
+  if (entry->slot < 0) {
+    entry->slot = addPending(compiler, obj, PENDING_SHAPE);
+  }
+  return entry->slot;
+}
+
+// the pool index of shape's keys when compileFlush merges it, adding shape
+// to the pool if it is the first with them
+static int mergeShape(Compiler *compiler, Hash *shape) {
+  ShapeEntry *entry = shapeEntry(compiler, shape);
+  if (entry->index < 0) {
+    Object obj = {.type = HashObj, .hash = entry->shape};
+    entry->index = appendConstant(compiler, &obj);
+  }
+  if (entry->shape != shape) {
+    freeHash(shape);
+  }
+  return entry->index;
+}
+
+// after a flush no pending slot stands for a shape any more; after a failed
+// one some shapes never reached the pool, so the index starts over
+static void resetShapeSlots(Compiler *compiler, int failed) {
+  if (failed) {
+    free(compiler->shapes);
+    compiler->shapes = NULL;
+    compiler->shapeCount = 0;
+    compiler->shapeCapacity = 0;
+    return;
+  }
+  for (int i = 0; i < compiler->shapeCapacity; i++) {
+    compiler->shapes[i].slot = -1;
+  }
+}
+
+// a hash literal with distinct string literal keys, but values computed at
+// runtime, compiles to its values and an OpRecord of the hash holding its
+// keys (all with null values). every hash built by a literal with the same
+// keys in the same order then shares one constant's layout, so field sites
+// see a single shape. returns the constant index, -1 when the literal does
+// not qualify
+static int addRecordShape(Compiler *compiler, HashLiteral *hashLit) {
+  if (hashLit->count == 0) {
+    return -1;
+  }
+  for (int i = 0; i < hashLit->count; i++) {
+    if (hashLit->keys[i]->type != NODE_STRING_LITERAL) {
+      return -1;
+    }
+  }
+
+  static Null nullValue;
+  Object null = {.type = NullObj, .null = &nullValue};
+  Hash *shape = newHash();
+  for (int i = 0; i < hashLit->count; i++) {
+    Object key;
+    buildConstant(hashLit->keys[i], &key);
+    hashSet(shape, &key, &null);
+  }
+  if (shape->size != hashLit->count) {
+    // a repeated key keeps its last value, which OpHash already does
+    freeHash(shape);
+    return -1;
+  }
+
+  return internShape(compiler, shape);
+}
+
+static int compileExpressionBody(Compiler *compiler, Expression *expression) {
+  if (!expression) {
     return -1;
   }
 
-  if (strcmp(expression->type, NODE_INTEGER_LITERAL) == 0) {
+  if (expression->type == NODE_INTEGER_LITERAL) {
     IntegerLiteral *intLit = expression->integerLiteral;
     Object *obj = malloc(sizeof(Object));
     obj->type = IntegerObj;
@@ -152,7 +547,7 @@ static int compileExpression(Compiler *compiler, Expression *expression) {
     int operands[] = {constIndex};
     emit(compiler, OpConstant, operands, 1);
 
-  } else if (strcmp(expression->type, NODE_BOOLEAN) == 0) {
+  } else if (expression->type == NODE_BOOLEAN) {
     BooleanLiteral *boolLit = expression->booleanLiteral;
     if (boolLit->value) {
       emit(compiler, OpTrue, NULL, 0);
@@ -160,26 +555,27 @@ static int compileExpression(Compiler *compiler, Expression *expression) {
       emit(compiler, OpFalse, NULL, 0);
     }
 
-  } else if (strcmp(expression->type, NODE_STRING_LITERAL) == 0) {
-    StringLiteral *strLit = expression->stringLiteral;
-    Object *obj = malloc(sizeof(Object));
-    obj->type = StringObj;
-    obj->string = malloc(sizeof(String));
-    obj->string->value = strdup(strLit->value);
+  } else if (expression->type == NODE_STRING_LITERAL) {
+    Object obj;
+    buildConstant(expression, &obj);
 
-    int constIndex = addConstant(compiler, obj);
+    int constIndex = addConstant(compiler, &obj);
     int operands[] = {constIndex};
     emit(compiler, OpConstant, operands, 1);
 
-  } else if (strcmp(expression->type, NODE_IDENTIFIER) == 0) {
+  } else if (expression->type == NODE_IDENTIFIER) {
     Identifier *ident = expression->identifier;
     Symbol symbol;
-    if (resolve(compiler->symbolTable, ident->value, &symbol) != 0) {
+    if (resolveInterned(compiler->symbolTable, ident->value, &symbol) != 0) {
       return -1; // Undefined variable
     }
+    if (strcmp(symbol.scope, GlobalScope) == 0 &&
+        symbol.index >= compiler->globalLimit) {
+      return -1; // defined after the function being compiled
+    }
     loadSymbol(compiler, symbol);
 
-  } else if (strcmp(expression->type, NODE_INFIX_EXPRESSION) == 0) {
+  } else if (expression->type == NODE_INFIX_EXPRESSION) {
     InfixExpression *infix = expression->infixExpression;
 
     // Special case for "<" operator - swap operands and use ">"
@@ -223,7 +619,7 @@ static int compileExpression(Compiler *compiler, Expression *expression) {
       return -1; // Unknown operator
     }
 
-  } else if (strcmp(expression->type, NODE_PREFIX_EXPRESSION) == 0) {
+  } else if (expression->type == NODE_PREFIX_EXPRESSION) {
     PrefixExpression *prefix = expression->prefixExpression;
 
     if (compileExpression(compiler, prefix->right) != 0) {
@@ -238,7 +634,7 @@ static int compileExpression(Compiler *compiler, Expression *expression) {
       return -1; // Unknown operator
     }
 
-  } else if (strcmp(expression->type, NODE_IF_EXPRESSION) == 0) {
+  } else if (expression->type == NODE_IF_EXPRESSION) {
     IfExpression *ifExpr = expression->ifExpression;
 
     // Compile condition
@@ -284,7 +680,17 @@ static int compileExpression(Compiler *compiler, Expression *expression) {
     int afterAlternativePos = scope->instructionsLength;
     changeOperand(compiler, jumpPos, afterAlternativePos);
 
-  } else if (strcmp(expression->type, NODE_ARRAY_LITERAL) == 0) {
+  } else if ((expression->type == NODE_ARRAY_LITERAL ||
+              expression->type == NODE_HASH_LITERAL) &&
+             isConstantLiteral(expression)) {
+    Object obj;
+    buildConstant(expression, &obj);
+
+    int constIndex = addConstant(compiler, &obj);
+    int operands[] = {constIndex};
+    emit(compiler, OpConstant, operands, 1);
+
+  } else if (expression->type == NODE_ARRAY_LITERAL) {
     ArrayLiteral *arrayLit = expression->arrayLiteral;
 
     for (int i = 0; i < arrayLit->count; i++) {
@@ -296,36 +702,63 @@ static int compileExpression(Compiler *compiler, Expression *expression) {
     int operands[] = {arrayLit->count};
     emit(compiler, OpArray, operands, 1);
 
-  } else if (strcmp(expression->type, NODE_HASH_LITERAL) == 0) {
+  } else if (expression->type == NODE_HASH_LITERAL) {
     HashLiteral *hashLit = expression->hashLiteral;
 
-    // Compile key-value pairs
-    // Note: In the Go version, keys are sorted, but we'll compile them in order
-    for (int i = 0; i < hashLit->count; i++) {
-      if (compileExpression(compiler, hashLit->keys[i]) != 0) {
-        return -1;
+    int shapeIndex = addRecordShape(compiler, hashLit);
+    if (shapeIndex >= 0) {
+      for (int i = 0; i < hashLit->count; i++) {
+        if (compileExpression(compiler, hashLit->values[i]) != 0) {
+          return -1;
+        }
       }
-      if (compileExpression(compiler, hashLit->values[i]) != 0) {
-        return -1;
+      int operands[] = {shapeIndex};
+      emit(compiler, OpRecord, operands, 1);
+    } else {
+      // Compile key-value pairs
+      // Note: In the Go version, keys are sorted, but we'll compile them in order
+      for (int i = 0; i < hashLit->count; i++) {
+        if (compileExpression(compiler, hashLit->keys[i]) != 0) {
+          return -1;
+        }
+        if (compileExpression(compiler, hashLit->values[i]) != 0) {
+          return -1;
+        }
       }
+
+      int operands[] = {hashLit->count * 2};
+      emit(compiler, OpHash, operands, 1);
     }
 
-    int operands[] = {hashLit->count * 2};
-    emit(compiler, OpHash, operands, 1);
+  } else if (expression->type == NODE_INDEX_EXPRESSION &&
+             expression->indexExpression->index->type ==
+                 NODE_STRING_LITERAL) {
+    // string keys get an OpGetField site, which has an inline cache
+    IndexExpression *indexExpr = expression->indexExpression;
 
-  } else if (strcmp(expression->type, NODE_INDEX_EXPRESSION) == 0) {
+    if (compileExpression(compiler, indexExpr->left) != 0) {
+      return -1;
+    }
+
+    Object key;
+    buildConstant(indexExpr->index, &key);
+    int operands[] = {addConstant(compiler, &key)};
+    emit(compiler, OpGetField, operands, 1);
+
+  } else if (expression->type == NODE_INDEX_EXPRESSION) {
     IndexExpression *indexExpr = expression->indexExpression;
 
     if (compileExpression(compiler, indexExpr->left) != 0) {
       return -1;
     }
+
     if (compileExpression(compiler, indexExpr->index) != 0) {
       return -1;
     }
 
     emit(compiler, OpIndex, NULL, 0);
 
-  } else if (strcmp(expression->type, NODE_CALL_EXPRESSION) == 0) {
+  } else if (expression->type == NODE_CALL_EXPRESSION) {
     CallExpression *callExpr = expression->callExpression;
 
     if (compileExpression(compiler, callExpr->function) != 0) {
@@ -341,113 +774,189 @@ static int compileExpression(Compiler *compiler, Expression *expression) {
     int operands[] = {callExpr->arg_count};
     emit(compiler, OpCall, operands, 1);
 
-  } else if (strcmp(expression->type, NODE_FUNCTION_LITERAL) == 0) {
-    FunctionLiteral *funcLit = expression->functionLiteral;
+  } else if (expression->type == NODE_FUNCTION_LITERAL) {
+    return compileFunctionLiteral(compiler, expression->functionLiteral);
 
-    enterScope(compiler);
-
-    // Define parameters
-    for (int i = 0; i < funcLit->param_count; i++) {
-      define(compiler->symbolTable, funcLit->parameters[i]->value);
-    }
+  } else {
+    return -1; // Unknown expression type
+  }
 
-    // Compile function body
-    if (compileBlockStatement(compiler, funcLit->body) != 0) {
-      return -1;
-    }
+  return 0;
+}
 
-    if (lastInstructionIs(compiler, OpPop)) {
-      replaceLastPopWithReturn(compiler);
-    }
-    if (!lastInstructionIs(compiler, OpReturnValue)) {
-      emit(compiler, OpReturn, NULL, 0);
-    }
+static int compileFunctionLiteral(Compiler *compiler, FunctionLiteral *funcLit) {
+  if (compiler->threads > 1 && compiler->scopeIndex == 0) {
+    return queueFunction(compiler, funcLit);
+  }
 
-    int numLocals = compiler->symbolTable->numDefinitions;
-    int instructionsLength;
-    Instructions instructions = leaveScope(compiler, &instructionsLength);
+  enterScope(compiler);
 
-    Object *compiledFn = malloc(sizeof(Object));
-    compiledFn->type = CompiledFunctionObj;
-    compiledFn->compiledFunction = malloc(sizeof(CompiledFunction));
-    compiledFn->compiledFunction->instructions = instructions;
-    compiledFn->compiledFunction->instructionCount = instructionsLength;
-    compiledFn->compiledFunction->numLocals = numLocals;
-    compiledFn->compiledFunction->numParameters = funcLit->param_count;
+  // Define parameters
+  for (int i = 0; i < funcLit->param_count; i++) {
+    defineInterned(compiler->symbolTable, funcLit->parameters[i]->value);
+  }
 
-    int fnIndex = addConstant(compiler, compiledFn);
-    int operands[] = {fnIndex};
-    emit(compiler, OpConstant, operands, 1);
+  // Compile function body
+  if (compileBlockStatement(compiler, funcLit->body) != 0) {
+    return -1;
+  }
 
-  } else {
-    return -1; // Unknown expression type
+  if (lastInstructionIs(compiler, OpPop)) {
+    replaceLastPopWithReturn(compiler);
+  }
+  if (!lastInstructionIs(compiler, OpReturnValue)) {
+    emit(compiler, OpReturn, NULL, 0);
   }
 
+  CompilationScope *scope = &compiler->scopes[compiler->scopeIndex];
+  int lineTableLength;
+  unsigned char *lineTable =
+      encodeLineTable(scope->lines, scope->lineCount, &lineTableLength);
+
+  int numLocals = compiler->symbolTable->numDefinitions;
+  int instructionsLength;
+  Instructions instructions = leaveScope(compiler, &instructionsLength);
+
+  Object *compiledFn = malloc(sizeof(Object));
+  compiledFn->type = CompiledFunctionObj;
+  compiledFn->compiledFunction = malloc(sizeof(CompiledFunction));
+  compiledFn->compiledFunction->instructions = instructions;
+  compiledFn->compiledFunction->instructionCount = instructionsLength;
+  compiledFn->compiledFunction->numLocals = numLocals;
+  compiledFn->compiledFunction->native = NULL;
+  compiledFn->compiledFunction->invocationCount = 0;
+  compiledFn->compiledFunction->jitFailed = false;
+  compiledFn->compiledFunction->numParameters = funcLit->param_count;
+  compiledFn->compiledFunction->lineTable = lineTable;
+  compiledFn->compiledFunction->lineTableLength = lineTableLength;
+
+  int fnIndex = addConstant(compiler, compiledFn);
+  int operands[] = {fnIndex};
+  emit(compiler, OpConstant, operands, 1);
   return 0;
 }
 
 static int compileBlockStatement(Compiler *compiler, BlockStatement *block) {
   for (int i = 0; i < block->count; i++) {
-    if (compileStatement(compiler, block->statements[i]) != 0) {
+    if (compileStatementNode(compiler, block->statements[i]) != 0) {
       return -1;
     }
   }
   return 0;
 }
 
+// big-endian, as the vm reads them
+static void writeOperand(Instructions at, int width, int operand) {
+  if (width == 2) {
+    at[0] = (operand >> 8) & 0xff;
+    at[1] = operand & 0xff;
+  } else if (width == 1) {
+    at[0] = operand & 0xff;
+  }
+}
+
+// encodes the instruction straight into the current scope's buffer
 static int emit(Compiler *compiler, OpCode opCode, int *operands,
                 int operandCount) {
-  Instructions ins = makeInstruction(opCode, operands, operandCount);
-  if (!ins) {
+  if (opCode < 0 || opCode > MAX_OPCODE) {
     return -1;
   }
 
-  Definition def;
-  if (lookupOpCode(opCode, &def) != 0) {
-    free(ins);
-    return -1;
+  CompilationScope *scope = &compiler->scopes[compiler->scopeIndex];
+  int length = instructionLengths[(int)opCode];
+  if (scope->instructionsLength + length > scope->instructionsCapacity) {
+    scope->instructionsCapacity *= 2;
+    scope->instructions =
+        realloc(scope->instructions, scope->instructionsCapacity);
   }
 
-  int instructionLength = 1;
-  for (int i = 0; i < def.operandCount; i++) {
-    instructionLength += def.operandWidths[i];
+  int pos = scope->instructionsLength;
+  Instructions ins = scope->instructions + pos;
+  ins[0] = opCode;
+
+  const Definition *def = &definitions[(int)opCode];
+  int offset = 1;
+  for (int i = 0; i < def->operandCount && i < operandCount; i++) {
+    writeOperand(ins + offset, def->operandWidths[i], operands[i]);
+    offset += def->operandWidths[i];
   }
+  scope->instructionsLength += length;
 
-  int pos = addInstruction(compiler, ins, instructionLength);
+  recordLine(scope, pos, compiler->line);
   setLastInstruction(compiler, opCode, pos);
-
-  free(ins);
   return pos;
 }
 
-static int addConstant(Compiler *compiler, Object *obj) {
-  if (compiler->constantsCount >= compiler->constantsCapacity) {
-    compiler->constantsCapacity *= 2;
-    compiler->constants = realloc(compiler->constants,
-                                  sizeof(Object) * compiler->constantsCapacity);
+static void recordLine(CompilationScope *scope, int pc, int line) {
+  if (line <= 0) {
+    return; // unknown, the instruction stays on the line before
+  }
+  if (scope->lineCount > 0) {
+    LineEntry *last = &scope->lines[scope->lineCount - 1];
+    if (last->line == line) {
+      return;
+    }
+    if (last->pc == pc) {
+      // nothing was emitted on the last entry's line
+      scope->lineCount--;
+      if (scope->lineCount > 0 &&
+          scope->lines[scope->lineCount - 1].line == line) {
+        return;
+      }
+    }
   }
 
-  compiler->constants[compiler->constantsCount] = *obj;
-  return compiler->constantsCount++;
+  if (scope->lineCount >= scope->lineCapacity) {
+    scope->lineCapacity =
+        scope->lineCapacity ? scope->lineCapacity * 2 : INITIAL_LINES_CAPACITY;
+    scope->lines =
+        realloc(scope->lines, sizeof(LineEntry) * scope->lineCapacity);
+  }
+  scope->lines[scope->lineCount].pc = pc;
+  scope->lines[scope->lineCount].line = line;
+  scope->lineCount++;
 }
 
-static int addInstruction(Compiler *compiler, Instructions ins, int length) {
-  CompilationScope *scope = &compiler->scopes[compiler->scopeIndex];
+// drops the entries of instructions at or past end, which were removed
+static void truncateLines(CompilationScope *scope, int end) {
+  while (scope->lineCount > 0 && scope->lines[scope->lineCount - 1].pc >= end) {
+    scope->lineCount--;
+  }
+}
 
-  int posNewInstruction = scope->instructionsLength;
+static int addPending(Compiler *compiler, Object obj, int job) {
+  if (compiler->pendingCount >= compiler->pendingCapacity) {
+    compiler->pendingCapacity = compiler->pendingCapacity
+                                    ? compiler->pendingCapacity * 2
+                                    : INITIAL_PENDING_CAPACITY;
+    compiler->pending =
+        realloc(compiler->pending,
+                sizeof(PendingConstant) * compiler->pendingCapacity);
+  }
 
-  // Reallocate if needed
-  if (scope->instructionsLength + length > scope->instructionsCapacity) {
-    scope->instructionsCapacity *= 2;
-    scope->instructions =
-        realloc(scope->instructions, scope->instructionsCapacity);
+  compiler->pending[compiler->pendingCount].object = obj;
+  compiler->pending[compiler->pendingCount].job = job;
+  return compiler->pendingCount++;
+}
+
+static int addConstant(Compiler *compiler, Object *obj) {
+  // once a body is queued, the constants after it can only be numbered
+  // when its own are known; until then operands hold the pending slot
+  if (compiler->jobCount > 0) {
+    return addPending(compiler, *obj, PENDING_OBJECT);
   }
+  return appendConstant(compiler, obj);
+}
 
-  // Copy instruction
-  memcpy(scope->instructions + scope->instructionsLength, ins, length);
-  scope->instructionsLength += length;
+static int appendConstant(Compiler *compiler, Object *obj) {
+  if (compiler->constantsCount >= compiler->constantsCapacity) {
+    compiler->constantsCapacity *= 2;
+    compiler->constants = realloc(compiler->constants,
+                                  sizeof(Object) * compiler->constantsCapacity);
+  }
 
-  return posNewInstruction;
+  compiler->constants[compiler->constantsCount] = *obj;
+  return compiler->constantsCount++;
 }
 
 static void setLastInstruction(Compiler *compiler, OpCode opCode,
@@ -475,34 +984,14 @@ static void removeLastPop(Compiler *compiler) {
 
   scope->instructionsLength = last.position;
   scope->lastInstruction = previous;
-}
-
-static void replaceInstruction(Compiler *compiler, int pos,
-                               Instructions newInstruction, int length) {
-  CompilationScope *scope = &compiler->scopes[compiler->scopeIndex];
-
-  for (int i = 0; i < length; i++) {
-    scope->instructions[pos + i] = newInstruction[i];
-  }
+  truncateLines(scope, last.position);
 }
 
 static void changeOperand(Compiler *compiler, int opPos, int operand) {
   CompilationScope *scope = &compiler->scopes[compiler->scopeIndex];
   OpCode op = scope->instructions[opPos];
-
-  int operands[] = {operand};
-  Instructions newInstruction = makeInstruction(op, operands, 1);
-
-  Definition def;
-  if (lookupOpCode(op, &def) == 0) {
-    int instructionLength = 1;
-    for (int i = 0; i < def.operandCount; i++) {
-      instructionLength += def.operandWidths[i];
-    }
-    replaceInstruction(compiler, opPos, newInstruction, instructionLength);
-  }
-
-  free(newInstruction);
+  writeOperand(scope->instructions + opPos + 1,
+               definitions[(int)op].operandWidths[0], operand);
 }
 
 static Instructions getCurrentInstructions(Compiler *compiler) {
@@ -537,6 +1026,7 @@ static void enterScope(Compiler *compiler) {
 static Instructions leaveScope(Compiler *compiler, int *length) {
   Instructions instructions = getCurrentInstructions(compiler);
   *length = getCurrentInstructionsLength(compiler);
+  free(compiler->scopes[compiler->scopeIndex].lines);
 
   compiler->scopesLength--;
   compiler->scopeIndex--;
@@ -549,11 +1039,8 @@ static void replaceLastPopWithReturn(Compiler *compiler) {
   CompilationScope *scope = &compiler->scopes[compiler->scopeIndex];
   int lastPos = scope->lastInstruction.position;
 
-  Instructions returnInst = makeInstruction(OpReturnValue, NULL, 0);
-  replaceInstruction(compiler, lastPos, returnInst, 1);
-
+  scope->instructions[lastPos] = OpReturnValue;
   scope->lastInstruction.opCode = OpReturnValue;
-  free(returnInst);
 }
 
 static void loadSymbol(Compiler *compiler, Symbol symbol) {
@@ -568,13 +1055,204 @@ static void loadSymbol(Compiler *compiler, Symbol symbol) {
   }
 }
 
+// ===== PARALLEL FUNCTION BODIES =====
+// the main compiler only queues top-level function literals; compileFlush
+// compiles the queued bodies on a pool of threads, each job with its own
+// compiler, scopes and constants over the shared (and then read-only)
+// global symbol table. the results are merged in source order: a job's
+// constants are appended where compiling it in place would have put them
+// (record shapes the pool already has are reused instead), its constant
+// operands rewritten to match, and the main-scope operands that held
+// pending slots rewritten to the final indices
+
+static int queueFunction(Compiler *compiler, FunctionLiteral *funcLit) {
+  if (compiler->jobCount >= compiler->jobCapacity) {
+    compiler->jobCapacity =
+        compiler->jobCapacity ? compiler->jobCapacity * 2 : INITIAL_JOBS_CAPACITY;
+    compiler->jobs =
+        realloc(compiler->jobs, sizeof(CompileJob) * compiler->jobCapacity);
+  }
+  if (compiler->jobCount == 0) {
+    compiler->pendingStart = getCurrentInstructionsLength(compiler);
+  }
+
+  CompileJob *job = &compiler->jobs[compiler->jobCount];
+  job->literal = funcLit;
+  job->position = getCurrentInstructionsLength(compiler);
+  job->globalLimit = compiler->symbolTable->numDefinitions;
+  job->constants = NULL;
+  job->constantsCount = 0;
+  job->shapes = NULL;
+  job->shapeCapacity = 0;
+  job->failed = 0;
+
+  Object none = {0};
+  int slot = addPending(compiler, none, compiler->jobCount++);
+  int operands[] = {slot};
+  emit(compiler, OpConstant, operands, 1);
+  return 0;
+}
+
+static void runJob(SymbolTable *globals, CompileJob *job) {
+  Compiler *compiler = allocCompiler(globals);
+  compiler->globalLimit = job->globalLimit;
+  compiler->line = job->literal->token.line;
+
+  job->failed = compileFunctionLiteral(compiler, job->literal) != 0;
+  job->constants = compiler->constants;
+  job->constantsCount = compiler->constantsCount;
+  job->shapes = compiler->shapes;
+  job->shapeCapacity = compiler->shapeCapacity;
+
+  // a failed body can leave its scopes open
+  for (int i = 0; i < compiler->scopesLength; i++) {
+    free(compiler->scopes[i].instructions);
+    free(compiler->scopes[i].lines);
+  }
+  free(compiler->scopes);
+  free(compiler);
+}
+
+typedef struct {
+  Compiler *compiler;
+  int next;
+} JobQueue;
+
+static void *compileWorker(void *arg) {
+  JobQueue *queue = arg;
+  for (;;) {
+    int i = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+    if (i >= queue->compiler->jobCount) {
+      return NULL;
+    }
+    runJob(queue->compiler->symbolTable, &queue->compiler->jobs[i]);
+  }
+}
+
+static void runJobs(Compiler *compiler) {
+  JobQueue queue = {compiler, 0};
+  int workers = compiler->threads < compiler->jobCount ? compiler->threads
+                                                       : compiler->jobCount;
+
+  // the calling thread is one of the workers; if threads cannot be
+  // started it simply does more of the work
+  pthread_t threads[MAX_COMPILE_THREADS];
+  int started = 0;
+  while (started < workers - 1 &&
+         pthread_create(&threads[started], NULL, compileWorker, &queue) == 0) {
+    started++;
+  }
+  compileWorker(&queue);
+  for (int i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+// rewrites the constant index operand of every OpConstant, OpRecord and
+// OpGetField in ins[start, end) to slots[operand]
+static void remapConstants(Instructions ins, int start, int end,
+                           const int *slots) {
+  int pos = start;
+  while (pos < end) {
+    OpCode op = ins[pos];
+    if (op < 0 || op > MAX_OPCODE) {
+      return;
+    }
+
+    if (op == OpConstant || op == OpRecord || op == OpGetField) {
+      int operand = ((unsigned char)ins[pos + 1] << 8) |
+                    (unsigned char)ins[pos + 2];
+      writeOperand(ins + pos + 1, 2, slots[operand]);
+    }
+    pos += instructionLengths[(int)op];
+  }
+}
+
+int compileFlush(Compiler *compiler) {
+  if (compiler->jobCount == 0) {
+    return 0;
+  }
+
+  runJobs(compiler);
+
+  int *slots = calloc(compiler->pendingCount, sizeof(int));
+  CompilationScope *scope = &compiler->scopes[0];
+  int end = scope->instructionsLength;
+  int failed = 0;
+
+  for (int i = 0; i < compiler->pendingCount && !failed; i++) {
+    PendingConstant *pending = &compiler->pending[i];
+    if (pending->job == PENDING_SHAPE) {
+      slots[i] = mergeShape(compiler, pending->object.hash);
+      continue;
+    }
+    if (pending->job == PENDING_OBJECT) {
+      slots[i] = appendConstant(compiler, &pending->object);
+      continue;
+    }
+
+    CompileJob *job = &compiler->jobs[pending->job];
+    if (job->failed) {
+      // where compiling in place would have stopped
+      end = job->position;
+      failed = 1;
+      break;
+    }
+
+    // the body's shapes join those of the pool, as compiling it in place
+    // would have had them, so its constants map to indices one by one
+    int *map = malloc(sizeof(int) * job->constantsCount);
+    char *isShape = calloc(job->constantsCount, 1);
+    for (int j = 0; j < job->shapeCapacity; j++) {
+      if (job->shapes[j].shape) {
+        isShape[job->shapes[j].index] = 1;
+      }
+    }
+    for (int j = 0; j < job->constantsCount; j++) {
+      Object *constant = &job->constants[j];
+      if (strcmp(constant->type, CompiledFunctionObj) == 0) {
+        CompiledFunction *fn = constant->compiledFunction;
+        remapConstants(fn->instructions, 0, fn->instructionCount, map);
+      }
+      map[j] = isShape[j] ? mergeShape(compiler, constant->hash)
+                          : appendConstant(compiler, constant);
+    }
+    slots[i] = map[job->constantsCount - 1];
+    free(map);
+    free(isShape);
+  }
+
+  remapConstants(scope->instructions, compiler->pendingStart, end, slots);
+  resetShapeSlots(compiler, failed);
+  if (failed) {
+    scope->instructionsLength = end;
+    truncateLines(scope, end);
+    scope->lastInstruction = (EmittedInstruction){0, -1};
+    scope->previousInstruction = (EmittedInstruction){0, -1};
+  }
+
+  for (int i = 0; i < compiler->jobCount; i++) {
+    free(compiler->jobs[i].constants);
+    free(compiler->jobs[i].shapes);
+  }
+  free(slots);
+  compiler->jobCount = 0;
+  compiler->pendingCount = 0;
+  return failed ? -1 : 0;
+}
+
 ByteCode *getByteCode(Compiler *compiler) {
+  compileFlush(compiler);
+
   ByteCode *bytecode = malloc(sizeof(ByteCode));
   bytecode->instructions = getCurrentInstructions(compiler);
   bytecode->constants = compiler->constants;
   bytecode->constantsCount = compiler->constantsCount;
   bytecode->constantsCapacity = compiler->constantsCapacity;
   bytecode->instructionCount = getCurrentInstructionsLength(compiler);
+  bytecode->lineTable = encodeLineTable(compiler->scopes[0].lines,
+                                        compiler->scopes[0].lineCount,
+                                        &bytecode->lineTableLength);
   return bytecode;
 }
 
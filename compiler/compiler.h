@@ -11,6 +11,9 @@ typedef struct {
   int constantsCount;
   int constantsCapacity;
   int instructionCount;
+  // pc -> source line for the main instructions, NULL when unknown
+  unsigned char *lineTable;
+  int lineTableLength;
 } ByteCode;
 
 typedef struct {
@@ -24,8 +27,19 @@ typedef struct {
   int instructionsCapacity;
   EmittedInstruction lastInstruction;
   EmittedInstruction previousInstruction;
+  // where each source line starts, encoded when the scope is done
+  LineEntry *lines;
+  int lineCount;
+  int lineCapacity;
 } CompilationScope;
 
+// see compiler.c; a function body queued for compileFlush, and a main-scope
+// constant whose index is only known once the queued bodies are merged
+typedef struct CompileJob CompileJob;
+typedef struct PendingConstant PendingConstant;
+// see compiler.c; a record shape constant, indexed by its ordered key list
+typedef struct ShapeEntry ShapeEntry;
+
 typedef struct {
   Instructions instructions;
   Object *constants;
@@ -38,12 +52,52 @@ typedef struct {
   int scopesLength;
   int scopesCapacity;
   int scopeIndex;
+
+  // with more than one thread, top-level function literals are queued and
+  // their bodies compiled in parallel by compileFlush; the bytecode comes
+  // out the same as with one thread
+  int threads;
+  CompileJob *jobs;
+  int jobCount;
+  int jobCapacity;
+  PendingConstant *pending;
+  int pendingCount;
+  int pendingCapacity;
+  // main-scope offset of the first instruction that refers to a pending
+  // constant
+  int pendingStart;
+  // the record shapes added so far, in an open-addressing hash table of
+  // shapeCapacity slots (a power of two, allocated with the first shape)
+  ShapeEntry *shapes;
+  int shapeCount;
+  int shapeCapacity;
+  // globals with an index at or past this are not visible yet; only
+  // lower than INT_MAX while compiling a queued function body
+  int globalLimit;
+  // source line of the node being compiled, recorded against what it emits
+  int line;
 } Compiler;
 
 Compiler *newCompiler();
 Compiler *newCompilerWithState(SymbolTable *symbolTable, Object *constants);
 int compileProgram(Compiler *compiler, Program *program);
+// compiles like compileProgram and stores in markPosition the main-scope
+// instruction offset reached just before statement `mark` is compiled
+int compileProgramWithMark(Compiler *compiler, Program *program, int mark,
+                           int *markPosition);
+// statements may also be compiled one at a time, e.g. while the source is
+// still being parsed; compileFinish then does what compileProgram does
+// after the last one
 int compileStatement(Compiler *compiler, Statement *statement);
+int compileFinish(Compiler *compiler);
+// compiles every queued function body and numbers the constants waiting
+// on them; afterwards the tree of the statements compiled so far is no
+// longer needed. returns -1 if a body failed to compile, in which case the
+// bytecode ends where compiling one function at a time would have stopped
+int compileFlush(Compiler *compiler);
+// 1 compiles everything on the calling thread; newCompiler takes the count
+// from MONKEYC_COMPILE_THREADS, defaulting to the number of cpus
+void compilerSetThreads(Compiler *compiler, int threads);
 ByteCode *getByteCode(Compiler *compiler);
 int getByteCodeInstructionsLength(Compiler *compiler);
 
@@ -0,0 +1,125 @@
+#include "intern.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// open-addressing table of names; strings are packed into big blocks, as
+// they are never freed one by one
+
+#define INTERN_INITIAL_CAPACITY 1024
+#define INTERN_BLOCK_SIZE (64 * 1024)
+
+typedef struct {
+  const char *name; // NULL for an empty slot
+  uint32_t hash;
+  uint32_t length;
+} InternEntry;
+
+typedef struct InternBlock InternBlock;
+struct InternBlock {
+  InternBlock *next;
+  size_t used;
+  size_t capacity;
+  char data[];
+};
+
+static InternEntry *entries = NULL;
+static size_t capacity = 0;
+static int count = 0;
+static InternBlock *blocks = NULL;
+
+static void *internAlloc(size_t size) {
+  void *ptr = malloc(size);
+  if (!ptr) {
+    fprintf(stderr, "❌ out of memory interning identifiers\n");
+    abort();
+  }
+  return ptr;
+}
+
+// fnv-1a
+static uint32_t hashName(const char *start, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char)start[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static InternEntry *findSlot(const char *start, size_t length, uint32_t hash) {
+  size_t mask = capacity - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    InternEntry *entry = &entries[i];
+    if (!entry->name || (entry->hash == hash && entry->length == length &&
+                         memcmp(entry->name, start, length) == 0)) {
+      return entry;
+    }
+  }
+}
+
+static void grow() {
+  InternEntry *old = entries;
+  size_t oldCapacity = capacity;
+
+  capacity = capacity ? capacity * 2 : INTERN_INITIAL_CAPACITY;
+  entries = internAlloc(sizeof(InternEntry) * capacity);
+  memset(entries, 0, sizeof(InternEntry) * capacity);
+
+  for (size_t i = 0; i < oldCapacity; i++) {
+    if (old[i].name) {
+      *findSlot(old[i].name, old[i].length, old[i].hash) = old[i];
+    }
+  }
+  free(old);
+}
+
+static char *storeName(const char *start, size_t length) {
+  size_t size = length + 1;
+  if (!blocks || blocks->used + size > blocks->capacity) {
+    size_t blockCapacity =
+        size > INTERN_BLOCK_SIZE / 4 ? size : INTERN_BLOCK_SIZE;
+    InternBlock *block = internAlloc(sizeof(InternBlock) + blockCapacity);
+    block->used = 0;
+    block->capacity = blockCapacity;
+    block->next = blocks;
+    blocks = block;
+  }
+
+  char *copy = blocks->data + blocks->used;
+  blocks->used += size;
+  memcpy(copy, start, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+const char *intern(const char *start, size_t length) {
+  uint32_t hash = hashName(start, length);
+  InternEntry *entry = capacity ? findSlot(start, length, hash) : NULL;
+  if (entry && entry->name) {
+    return entry->name;
+  }
+
+  // keep the load factor at or below 1/2
+  if ((size_t)(count + 1) * 2 > capacity) {
+    grow();
+    entry = findSlot(start, length, hash);
+  }
+  entry->name = storeName(start, length);
+  entry->hash = hash;
+  entry->length = (uint32_t)length;
+  count++;
+  return entry->name;
+}
+
+const char *internString(const char *s) { return intern(s, strlen(s)); }
+
+const char *internLookup(const char *start, size_t length) {
+  if (count == 0) {
+    return NULL;
+  }
+  return findSlot(start, length, hashName(start, length))->name;
+}
+
+int internCount() { return count; }
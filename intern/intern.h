@@ -0,0 +1,25 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+
+// process-wide identifier interner. every distinct name is stored exactly
+// once and handed out as the same pointer, so interned names can be
+// compared with == and need no freeing; the strings live until exit.
+//
+// there is no locking: interning a name that is already present only
+// reads the table, so threads may share it as long as every name they
+// use was interned before they started (the compiler's jobs rely on this)
+
+// canonical null-terminated copy of the length bytes at start
+const char *intern(const char *start, size_t length);
+const char *internString(const char *s);
+
+// canonical copy if the name has been interned before, otherwise NULL;
+// unlike intern this never adds anything
+const char *internLookup(const char *start, size_t length);
+
+// number of distinct names interned so far
+int internCount();
+
+#endif
@@ -0,0 +1,562 @@
+#define _DEFAULT_SOURCE
+
+#include "jit.h"
+#include "../vm/vm.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define JIT_SUPPORTED 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static bool initialized = false;
+static bool enabled = true;
+static int threshold = JIT_DEFAULT_THRESHOLD;
+static bool perfMap = false;
+
+static void jitInit() {
+  if (initialized) {
+    return;
+  }
+  initialized = true;
+
+  char *value = getenv("MONKEYC_JIT");
+  if (value && (strcmp(value, "0") == 0 || strcmp(value, "off") == 0)) {
+    enabled = false;
+  }
+  value = getenv("MONKEYC_JIT_THRESHOLD");
+  if (value && value[0] != '\0') {
+    threshold = atoi(value);
+  }
+  value = getenv("MONKEYC_PERF_MAP");
+  if (value && strcmp(value, "1") == 0) {
+    perfMap = true;
+  }
+}
+
+void jitSetEnabled(bool value) {
+  jitInit();
+  enabled = value;
+}
+
+void jitSetThreshold(int value) {
+  jitInit();
+  threshold = value;
+}
+
+bool jitIsEnabled() {
+  jitInit();
+#ifdef JIT_SUPPORTED
+  return enabled;
+#else
+  return false;
+#endif
+}
+
+void jitMaybeCompile(CompiledFunction *fn) {
+  if (fn->jitFailed || !jitIsEnabled()) {
+    return;
+  }
+  if (++fn->invocationCount < threshold) {
+    return;
+  }
+  if (jitCompile(fn) != 0) {
+    fn->jitFailed = true;
+  }
+}
+
+#ifndef JIT_SUPPORTED
+
+int jitCompile(CompiledFunction *fn) {
+  (void)fn;
+  return -1;
+}
+
+#else
+
+// === code buffer ===
+
+typedef struct {
+  unsigned char *code;
+  int length;
+  int capacity;
+} CodeBuffer;
+
+// pseudo targets for jumps that do not land on a bytecode pc
+#define TARGET_EPILOGUE -1
+#define TARGET_FAIL -2
+#define TARGET_OVERFLOW -3
+
+typedef struct {
+  int position; // offset of the rel32 to patch
+  int target;   // bytecode pc or TARGET_*
+} Fixup;
+
+typedef struct {
+  CodeBuffer buf;
+  int *pcOffsets; // machine code offset for each bytecode pc, -1 if none
+  Fixup *fixups;
+  int fixupCount;
+  int fixupCapacity;
+} Assembler;
+
+static void emit8(Assembler *as, unsigned char byte) {
+  if (as->buf.length == as->buf.capacity) {
+    as->buf.capacity = as->buf.capacity ? as->buf.capacity * 2 : 256;
+    as->buf.code = realloc(as->buf.code, as->buf.capacity);
+  }
+  as->buf.code[as->buf.length++] = byte;
+}
+
+static void emitBytes(Assembler *as, const unsigned char *bytes, int count) {
+  for (int i = 0; i < count; i++) {
+    emit8(as, bytes[i]);
+  }
+}
+
+static void emit32(Assembler *as, int32_t value) {
+  for (int i = 0; i < 4; i++) {
+    emit8(as, (value >> (i * 8)) & 0xff);
+  }
+}
+
+static void emit64(Assembler *as, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    emit8(as, (value >> (i * 8)) & 0xff);
+  }
+}
+
+// emit a rel32 placeholder resolved once all offsets are known
+static void emitRel32(Assembler *as, int target) {
+  if (as->fixupCount == as->fixupCapacity) {
+    as->fixupCapacity = as->fixupCapacity ? as->fixupCapacity * 2 : 16;
+    as->fixups = realloc(as->fixups, sizeof(Fixup) * as->fixupCapacity);
+  }
+  as->fixups[as->fixupCount++] = (Fixup){as->buf.length, target};
+  emit32(as, 0);
+}
+
+// === templates ===
+// register use inside compiled code:
+//   rbx = vm, r12 = basePointer, r13 = &vm->stack[basePointer],
+//   r14 = vm->stack; xmm0 carries one Object (16 bytes) between loads/stores
+
+#define VM_SP ((int32_t)offsetof(VM, sp))
+#define VM_STACK ((int32_t)offsetof(VM, stack))
+#define VM_CONSTANTS ((int32_t)offsetof(VM, constants))
+#define VM_GLOBALS ((int32_t)offsetof(VM, globals))
+
+static void emitPrologue(Assembler *as) {
+  static const unsigned char code[] = {
+      0x53,                   // push rbx
+      0x41, 0x54,             // push r12
+      0x41, 0x55,             // push r13
+      0x41, 0x56,             // push r14
+      0x48, 0x83, 0xec, 0x08, // sub rsp, 8 (keep calls 16-byte aligned)
+      0x48, 0x89, 0xfb,       // mov rbx, rdi
+      0x4c, 0x63, 0xe6,       // movsxd r12, esi
+  };
+  emitBytes(as, code, sizeof(code));
+  emitBytes(as, (const unsigned char[]){0x4c, 0x8b, 0xb3}, 3); // mov r14, [rbx+stack]
+  emit32(as, VM_STACK);
+  static const unsigned char frame[] = {
+      0x4d, 0x89, 0xe5,       // mov r13, r12
+      0x49, 0xc1, 0xe5, 0x04, // shl r13, 4
+      0x4d, 0x01, 0xf5,       // add r13, r14
+  };
+  emitBytes(as, frame, sizeof(frame));
+}
+
+// one bounds check for the whole body instead of one per push
+static void emitStackCheck(Assembler *as, int maxDepth) {
+  emitBytes(as, (const unsigned char[]){0x8b, 0x83}, 2); // mov eax, [rbx+sp]
+  emit32(as, VM_SP);
+  emit8(as, 0x05); // add eax, maxDepth
+  emit32(as, maxDepth);
+  emit8(as, 0x3d); // cmp eax, STACK_SIZE
+  emit32(as, STACK_SIZE);
+  emitBytes(as, (const unsigned char[]){0x0f, 0x8f}, 2); // jg overflow
+  emitRel32(as, TARGET_OVERFLOW);
+}
+
+static void emitEpilogue(Assembler *as) {
+  static const unsigned char code[] = {
+      0x48, 0x83, 0xc4, 0x08, // add rsp, 8
+      0x41, 0x5e,             // pop r14
+      0x41, 0x5d,             // pop r13
+      0x41, 0x5c,             // pop r12
+      0x5b,                   // pop rbx
+      0xc3,                   // ret
+  };
+  emitBytes(as, code, sizeof(code));
+}
+
+// xmm0 -> vm->stack[vm->sp++]
+static void emitPushXmm0(Assembler *as) {
+  emitBytes(as, (const unsigned char[]){0x48, 0x63, 0x83}, 3); // movsxd rax, [rbx+sp]
+  emit32(as, VM_SP);
+  emitBytes(as, (const unsigned char[]){0x48, 0xc1, 0xe0, 0x04}, 4); // shl rax, 4
+  emitBytes(as, (const unsigned char[]){0xf3, 0x41, 0x0f, 0x7f, 0x04, 0x06}, 6); // movdqu [r14+rax], xmm0
+  emitBytes(as, (const unsigned char[]){0xff, 0x83}, 2); // inc dword [rbx+sp]
+  emit32(as, VM_SP);
+}
+
+// vm->stack[--vm->sp] -> xmm0
+static void emitPopXmm0(Assembler *as) {
+  emitBytes(as, (const unsigned char[]){0xff, 0x8b}, 2); // dec dword [rbx+sp]
+  emit32(as, VM_SP);
+  emitBytes(as, (const unsigned char[]){0x48, 0x63, 0x83}, 3); // movsxd rax, [rbx+sp]
+  emit32(as, VM_SP);
+  emitBytes(as, (const unsigned char[]){0x48, 0xc1, 0xe0, 0x04}, 4); // shl rax, 4
+  emitBytes(as, (const unsigned char[]){0xf3, 0x41, 0x0f, 0x6f, 0x04, 0x06}, 6); // movdqu xmm0, [r14+rax]
+}
+
+// push a copy of table[index], where table is the Object array at vm+field
+static void emitPushFromTable(Assembler *as, int32_t field, int index) {
+  emitBytes(as, (const unsigned char[]){0x48, 0x8b, 0x83}, 3); // mov rax, [rbx+field]
+  emit32(as, field);
+  emitBytes(as, (const unsigned char[]){0xf3, 0x0f, 0x6f, 0x80}, 4); // movdqu xmm0, [rax+disp]
+  emit32(as, index * (int32_t)sizeof(Object));
+  emitPushXmm0(as);
+}
+
+// call helper(vm[, arg]) with the argument either an immediate or the base
+// pointer; on a non-zero int result bail out through the fail path
+#define ARG_NONE 0
+#define ARG_IMMEDIATE 1
+#define ARG_BASE_POINTER 2
+
+static void emitCall(Assembler *as, void *helper, int argKind, int arg) {
+  emitBytes(as, (const unsigned char[]){0x48, 0x89, 0xdf}, 3); // mov rdi, rbx
+  if (argKind == ARG_IMMEDIATE) {
+    emit8(as, 0xbe); // mov esi, imm32
+    emit32(as, arg);
+  } else if (argKind == ARG_BASE_POINTER) {
+    emitBytes(as, (const unsigned char[]){0x44, 0x89, 0xe6}, 3); // mov esi, r12d
+  }
+  emitBytes(as, (const unsigned char[]){0x48, 0xb8}, 2); // mov rax, helper
+  emit64(as, (uint64_t)(uintptr_t)helper);
+  emitBytes(as, (const unsigned char[]){0xff, 0xd0}, 2); // call rax
+}
+
+static void emitCheckedCall(Assembler *as, void *helper, int argKind, int arg) {
+  emitCall(as, helper, argKind, arg);
+  emitBytes(as, (const unsigned char[]){0x85, 0xc0}, 2); // test eax, eax
+  emitBytes(as, (const unsigned char[]){0x0f, 0x85}, 2); // jnz fail
+  emitRel32(as, TARGET_FAIL);
+}
+
+static void emitJump(Assembler *as, int target) {
+  emit8(as, 0xe9); // jmp rel32
+  emitRel32(as, target);
+}
+
+static int jitStackOverflow(VM *vm) {
+  (void)vm;
+  fprintf(stderr, "stack overflow: exceeded maximum stack size of %d\n", STACK_SIZE);
+  return -1;
+}
+
+// === translation ===
+
+static int readOperand(Instructions instructions, int pos, int width) {
+  if (width == 2) {
+    return ((unsigned char)instructions[pos] << 8) |
+           (unsigned char)instructions[pos + 1];
+  }
+  return (unsigned char)instructions[pos];
+}
+
+static int instructionWidth(Instructions instructions, int pos, int *operand) {
+  Definition def;
+  if (lookupOpCode(instructions[pos], &def) != 0) {
+    return -1;
+  }
+  *operand = 0;
+  if (def.operandCount > 0) {
+    *operand = readOperand(instructions, pos + 1, def.operandWidths[0]);
+  }
+  return instructionLengths[(int)instructions[pos]];
+}
+
+// upper bound on operand stack growth. monkey has no loops and the compiler
+// emits structured if/else, so a straight walk over-approximates every path
+static int maxStackDepth(CompiledFunction *fn) {
+  int depth = 0, max = 0, operand;
+  for (int pos = 0; pos < fn->instructionCount;) {
+    int width = instructionWidth(fn->instructions, pos, &operand);
+    switch (fn->instructions[pos]) {
+    case OpConstant:
+    case OpTrue:
+    case OpFalse:
+    case OpNull:
+    case OpGetGlobal:
+    case OpGetLocal:
+    case OpGetBuiltin:
+      depth++;
+      break;
+    case OpArray:
+    case OpHash:
+      depth += 1 - operand;
+      break;
+    case OpCall:
+      depth -= operand;
+      break;
+    case OpRecord:
+      // pops one value per key of its shape, which is not known here;
+      // leaving depth as it is over-approximates
+      break;
+    case OpPop:
+    case OpAdd:
+    case OpSub:
+    case OpMul:
+    case OpDiv:
+    case OpEqual:
+    case OpNotEqual:
+    case OpGreaterThan:
+    case OpJumpNotTruthy:
+    case OpSetGlobal:
+    case OpSetLocal:
+    case OpIndex:
+    case OpReturnValue:
+      depth--;
+      break;
+    default:
+      break;
+    }
+    if (depth < 0) {
+      depth = 0;
+    }
+    if (depth > max) {
+      max = depth;
+    }
+    pos += width;
+  }
+  return max;
+}
+
+static int translate(Assembler *as, CompiledFunction *fn) {
+  Instructions instructions = fn->instructions;
+  int length = fn->instructionCount;
+
+  emitPrologue(as);
+  emitStackCheck(as, maxStackDepth(fn));
+
+  int operand;
+  for (int pos = 0; pos < length;) {
+    int width = instructionWidth(instructions, pos, &operand);
+    if (width < 0) {
+      return -1;
+    }
+    as->pcOffsets[pos] = as->buf.length;
+
+    OpCode op = instructions[pos];
+    switch (op) {
+    case OpConstant:
+      emitPushFromTable(as, VM_CONSTANTS, operand);
+      break;
+    case OpGetGlobal:
+      emitPushFromTable(as, VM_GLOBALS, operand);
+      break;
+    case OpSetGlobal:
+      emitPopXmm0(as);
+      emitBytes(as, (const unsigned char[]){0x48, 0x8b, 0x83}, 3); // mov rax, [rbx+globals]
+      emit32(as, VM_GLOBALS);
+      emitBytes(as, (const unsigned char[]){0xf3, 0x0f, 0x7f, 0x80}, 4); // movdqu [rax+disp], xmm0
+      emit32(as, operand * (int32_t)sizeof(Object));
+      break;
+    case OpGetLocal:
+      emitBytes(as, (const unsigned char[]){0xf3, 0x41, 0x0f, 0x6f, 0x85}, 5); // movdqu xmm0, [r13+disp]
+      emit32(as, operand * (int32_t)sizeof(Object));
+      emitPushXmm0(as);
+      break;
+    case OpSetLocal:
+      emitPopXmm0(as);
+      emitBytes(as, (const unsigned char[]){0xf3, 0x41, 0x0f, 0x7f, 0x85}, 5); // movdqu [r13+disp], xmm0
+      emit32(as, operand * (int32_t)sizeof(Object));
+      break;
+    case OpPop:
+      emitBytes(as, (const unsigned char[]){0xff, 0x8b}, 2); // dec dword [rbx+sp]
+      emit32(as, VM_SP);
+      break;
+    case OpAdd:
+    case OpSub:
+    case OpMul:
+    case OpDiv:
+      emitCheckedCall(as, (void *)executeBinaryOperation, ARG_IMMEDIATE, op);
+      break;
+    case OpEqual:
+    case OpNotEqual:
+    case OpGreaterThan:
+      emitCheckedCall(as, (void *)executeComparison, ARG_IMMEDIATE, op);
+      break;
+    case OpTrue:
+    case OpFalse:
+      emitCheckedCall(as, (void *)executeBoolean, ARG_IMMEDIATE, op == OpTrue);
+      break;
+    case OpNull:
+      emitCheckedCall(as, (void *)executeNull, ARG_NONE, 0);
+      break;
+    case OpBang:
+      emitCheckedCall(as, (void *)executeBangOperator, ARG_NONE, 0);
+      break;
+    case OpMinus:
+      emitCheckedCall(as, (void *)executeMinusOperator, ARG_NONE, 0);
+      break;
+    case OpArray:
+      emitCheckedCall(as, (void *)executeArray, ARG_IMMEDIATE, operand);
+      break;
+    case OpHash:
+      emitCheckedCall(as, (void *)executeHash, ARG_IMMEDIATE, operand);
+      break;
+    case OpIndex:
+      emitCheckedCall(as, (void *)executeIndex, ARG_NONE, 0);
+      break;
+    case OpRecord:
+      emitCheckedCall(as, (void *)executeRecord, ARG_IMMEDIATE, operand);
+      break;
+    case OpGetField:
+      emitCheckedCall(as, (void *)executeGetField, ARG_IMMEDIATE, operand);
+      break;
+    case OpGetBuiltin:
+      emitCheckedCall(as, (void *)executeGetBuiltin, ARG_IMMEDIATE, operand);
+      break;
+    case OpCall:
+      emitCheckedCall(as, (void *)runCall, ARG_IMMEDIATE, operand);
+      break;
+    case OpJumpNotTruthy:
+      emitCall(as, (void *)executeJumpCondition, ARG_NONE, 0);
+      emitBytes(as, (const unsigned char[]){0x84, 0xc0}, 2); // test al, al
+      emitBytes(as, (const unsigned char[]){0x0f, 0x84}, 2); // jz target
+      emitRel32(as, operand);
+      break;
+    case OpJump:
+      emitJump(as, operand);
+      break;
+    case OpReturnValue:
+      emitCall(as, (void *)executeReturnValue, ARG_BASE_POINTER, 0);
+      emitJump(as, TARGET_EPILOGUE);
+      break;
+    case OpReturn:
+      emitCall(as, (void *)executeReturn, ARG_BASE_POINTER, 0);
+      emitJump(as, TARGET_EPILOGUE);
+      break;
+    default:
+      // no template, the function stays in the interpreter
+      return -1;
+    }
+
+    pos += width;
+  }
+
+  // falling off the end behaves like the interpreter finishing the frame
+  as->pcOffsets[length] = as->buf.length;
+  emitBytes(as, (const unsigned char[]){0x31, 0xc0}, 2); // xor eax, eax
+
+  int epilogue = as->buf.length;
+  emitEpilogue(as);
+
+  int overflow = as->buf.length;
+  emitCall(as, (void *)jitStackOverflow, ARG_NONE, 0);
+  emitJump(as, TARGET_EPILOGUE);
+
+  int fail = as->buf.length;
+  emit8(as, 0xb8); // mov eax, -1
+  emit32(as, -1);
+  emitJump(as, TARGET_EPILOGUE);
+
+  for (int i = 0; i < as->fixupCount; i++) {
+    Fixup *fixup = &as->fixups[i];
+    int target;
+    switch (fixup->target) {
+    case TARGET_EPILOGUE:
+      target = epilogue;
+      break;
+    case TARGET_FAIL:
+      target = fail;
+      break;
+    case TARGET_OVERFLOW:
+      target = overflow;
+      break;
+    default:
+      if (fixup->target > length || as->pcOffsets[fixup->target] < 0) {
+        return -1; // jump into the middle of an instruction
+      }
+      target = as->pcOffsets[fixup->target];
+    }
+    int32_t rel = target - (fixup->position + 4);
+    memcpy(as->buf.code + fixup->position, &rel, sizeof(rel));
+  }
+
+  return 0;
+}
+
+// copy finished code into its own mapping and flip it to read+execute
+static void *install(CodeBuffer *buf) {
+  long pageSize = sysconf(_SC_PAGESIZE);
+  size_t size = ((size_t)buf->length + pageSize - 1) & ~((size_t)pageSize - 1);
+
+  void *region = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
+    return NULL;
+  }
+  memcpy(region, buf->code, buf->length);
+  if (mprotect(region, size, PROT_READ | PROT_EXEC) != 0) {
+    munmap(region, size);
+    return NULL;
+  }
+  return region;
+}
+
+static void writePerfMap(void *code, int size, CompiledFunction *fn) {
+  static int compiledCount = 0;
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/perf-%d.map", (int)getpid());
+
+  FILE *fp = fopen(path, "a");
+  if (!fp) {
+    return;
+  }
+  fprintf(fp, "%lx %x monkey_jit_%d_%p\n", (unsigned long)(uintptr_t)code,
+          size, compiledCount++, (void *)fn);
+  fclose(fp);
+}
+
+int jitCompile(CompiledFunction *fn) {
+  jitInit();
+
+  Assembler as = {0};
+  as.pcOffsets = malloc(sizeof(int) * (fn->instructionCount + 1));
+  for (int i = 0; i <= fn->instructionCount; i++) {
+    as.pcOffsets[i] = -1;
+  }
+
+  int result = translate(&as, fn);
+  void *code = NULL;
+  if (result == 0) {
+    code = install(&as.buf);
+    if (!code) {
+      result = -1;
+    }
+  }
+
+  if (result == 0) {
+    if (perfMap) {
+      writePerfMap(code, as.buf.length, fn);
+    }
+    fn->native = (NativeFunction)code;
+  }
+
+  free(as.buf.code);
+  free(as.pcOffsets);
+  free(as.fixups);
+  return result;
+}
+
+#endif
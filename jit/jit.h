@@ -0,0 +1,28 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "../object/object.h"
+#include <stdbool.h>
+
+// baseline template jit: once an interpreted CompiledFunction has been
+// called `threshold` times its bytecode is stitched into x86-64 machine code
+// and installed as the function's native entry point.
+//
+// environment (read on first use, the setters below take precedence):
+//   MONKEYC_JIT=0            disable the jit
+//   MONKEYC_JIT_THRESHOLD=n  invocations before a function is compiled
+//   MONKEYC_PERF_MAP=1       append symbols to /tmp/perf-<pid>.map for perf
+#define JIT_DEFAULT_THRESHOLD 1000
+
+void jitSetEnabled(bool enabled);
+void jitSetThreshold(int threshold);
+bool jitIsEnabled();
+
+// count one interpreted invocation of fn and compile it once it is hot
+void jitMaybeCompile(CompiledFunction *fn);
+
+// compile fn right away; returns -1 and leaves fn interpreted when its
+// bytecode holds an unsupported opcode or the platform has no jit support
+int jitCompile(CompiledFunction *fn);
+
+#endif
@@ -1,4 +1,5 @@
 #include "lexer.h"
+#include "scan.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,50 +23,60 @@ void readChar(Lexer *lexer) {
   lexer->nextPosition += 1;
 }
 
+// move to position as if readChar had been called up to it
+static void seekTo(Lexer *lexer, int position) {
+  lexer->position = position;
+  lexer->nextPosition = position + 1;
+  lexer->currentChar =
+      position < lexer->inputLength ? lexer->input[position] : 0;
+}
+
+// token sliced from the input, on the current line. built in place rather
+// than with newTokenSlice, which is in another translation unit, since this
+// runs for every token
+static Token lexerToken(Lexer *lexer, TokenType type, const char *start,
+                        int length) {
+  Token token;
+  token.start = start;
+  token.length = length;
+  token.type = type;
+  token.line = lexer->line <= TOKEN_MAX_LINE ? lexer->line : 0;
+  return token;
+}
+
 Lexer *newLexer(char *input) {
+  return newLexerWithLength(input, strlen(input));
+}
+
+Lexer *newLexerWithLength(char *input, int length) {
   Lexer *lexer = malloc(sizeof(Lexer));
   lexer->input = input;
   lexer->position = 0;
   lexer->nextPosition = 0;
   lexer->currentChar = 0;
-  lexer->inputLength = strlen(input);
+  lexer->inputLength = length;
+  lexer->line = 1;
 
   readChar(lexer);
   return lexer;
 }
 
-// create a null-terminated string from a single character
-char *createSingleCharLiteral(unsigned char ch) {
-  char *literal = malloc(2);
-  if (!literal)
-    return NULL;
-
-  literal[0] = ch;
-  literal[1] = '\0';
-
-  return literal;
-}
-
-// read string literal between quotes
-char *readString(Lexer *lexer) {
+// read string literal between quotes; the slice excludes the quotes
+Token readString(Lexer *lexer) {
   int start = lexer->position + 1;
-
-  for (;;) {
-    readChar(lexer);
-    if (lexer->currentChar == '"' || lexer->currentChar == 0) {
-      break;
-    }
+  Token token = lexerToken(lexer, STRING, &lexer->input[start], 0);
+
+  // an unterminated string runs to the end of the input; the lines it
+  // spans are counted on the way
+  int end = scanString(lexer->input, start, lexer->inputLength);
+  while (end < lexer->inputLength && lexer->input[end] == '\n') {
+    lexer->line++;
+    end = scanString(lexer->input, end + 1, lexer->inputLength);
   }
+  seekTo(lexer, end);
 
-  int length = lexer->position - start;
-  char *out = malloc(length + 1);
-  if (!out)
-    return NULL;
-
-  memcpy(out, &lexer->input[start], length);
-  out[length] = '\0';
-
-  return out;
+  token.length = end - start;
+  return token;
 }
 
 // check if character is a letter or underscore
@@ -78,62 +89,55 @@ int isDigit(unsigned char ch) {
   return '0' <= ch && ch <= '9'; 
 }
 
+static int isWhitespace(unsigned char ch) {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
 // skip whitespace characters (space, tab, newline, carriage return)
 void skipWhitespace(Lexer *lexer) {
-  for (;;) {
-    if ((lexer->currentChar == ' ') || (lexer->currentChar == '\t') ||
-        (lexer->currentChar == '\n') || (lexer->currentChar == '\r')) {
-      readChar(lexer);
-    } else {
-      break;
+  // most tokens are preceded by no whitespace at all or a single space
+  if (!isWhitespace(lexer->currentChar)) {
+    return;
+  }
+  lexer->line += lexer->currentChar == '\n';
+  readChar(lexer);
+  if (!isWhitespace(lexer->currentChar)) {
+    return;
+  }
+  if (lexer->position < lexer->inputLength) {
+    int start = lexer->position;
+    int end = scanWhitespace(lexer->input, start, lexer->inputLength);
+    // runs are short, typically a newline and some indentation
+    for (int i = start; i < end; i++) {
+      lexer->line += lexer->input[i] == '\n';
     }
+    seekTo(lexer, end);
   }
 }
 
 // read a sequence of digits as a number
-char *readNumber(Lexer *lexer) {
+Token readNumber(Lexer *lexer) {
+  // the current character is known to be a digit
   int start = lexer->position;
-  while (isDigit(lexer->currentChar)) {
-    readChar(lexer);
-  }
+  seekTo(lexer, scanDigits(lexer->input, start + 1, lexer->inputLength));
 
-  int len = lexer->position - start;
-  char *num = malloc(len + 1);
-  if (!num)
-    return NULL;
-
-  memcpy(num, &lexer->input[start], len);
-  num[len] = '\0';
-  return num;
+  return lexerToken(lexer, INT, &lexer->input[start], lexer->position - start);
 }
 
-// read identifier (letters and underscores)
-char *readIdentifier(Lexer *lexer) {
+// read identifier (letters and underscores) or keyword
+Token readIdentifier(Lexer *lexer) {
+  // the current character is known to be a letter
   int start = lexer->position;
-  while (isLetter(lexer->currentChar)) {
-    readChar(lexer);
-  }
+  seekTo(lexer, scanLetters(lexer->input, start + 1, lexer->inputLength));
 
-  int len = lexer->position - start;
-  char *id = malloc(len + 1);
-  if (!id)
-    return NULL;
-
-  memcpy(id, &lexer->input[start], len);
-  id[len] = '\0';
-  return id;
+  int length = lexer->position - start;
+  const char *literal = &lexer->input[start];
+  return lexerToken(lexer, lookupKeyword(literal, length), literal, length);
 }
 
-// helper function to create two-character tokens like == and !=
-char *createTwoCharLiteral(unsigned char first, unsigned char second) {
-  char *literal = malloc(3);
-  if (literal == NULL) {
-    abort();
-  }
-  literal[0] = first;
-  literal[1] = second;
-  literal[2] = '\0';
-  return literal;
+// token covering the current character, or the current and next character
+static Token charToken(Lexer *lexer, TokenType type, int length) {
+  return lexerToken(lexer, type, &lexer->input[lexer->position], length);
 }
 
 // main tokenization function - converts input into tokens
@@ -145,123 +149,116 @@ Token nextToken(Lexer *lexer) {
   switch (lexer->currentChar) {
   case '=': {
     if (peekChar(lexer) == '=') {
-      unsigned char currentChar = lexer->currentChar;
+      token = charToken(lexer, EQ, 2);
       readChar(lexer);
-      token = newToken(EQ, createTwoCharLiteral(currentChar, lexer->currentChar));
     } else {
-      token = newToken(ASSIGN, createSingleCharLiteral(lexer->currentChar));
+      token = charToken(lexer, ASSIGN, 1);
     }
     break;
   }
 
   case '+': {
-    token = newToken(PLUS, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, PLUS, 1);
     break;
   }
 
   case '-': {
-    token = newToken(MINUS, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, MINUS, 1);
     break;
   }
 
   case '!': {
     if (peekChar(lexer) == '=') {
-      unsigned char currentChar = lexer->currentChar;
+      token = charToken(lexer, NOT_EQ, 2);
       readChar(lexer);
-      token = newToken(NOT_EQ, createTwoCharLiteral(currentChar, lexer->currentChar));
     } else {
-      token = newToken(BANG, createSingleCharLiteral(lexer->currentChar));
+      token = charToken(lexer, BANG, 1);
     }
     break;
   }
 
   case '*': {
-    token = newToken(ASTERISK, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, ASTERISK, 1);
     break;
   }
 
   case '/': {
-    token = newToken(SLASH, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, SLASH, 1);
     break;
   }
 
   case '<': {
-    token = newToken(LT, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, LT, 1);
     break;
   }
 
   case '>': {
-    token = newToken(GT, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, GT, 1);
     break;
   }
 
   case ',': {
-    token = newToken(COMMA, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, COMMA, 1);
     break;
   }
 
   case ';': {
-    token = newToken(SEMICOLON, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, SEMICOLON, 1);
     break;
   }
 
   case ':': {
-    token = newToken(COLON, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, COLON, 1);
     break;
   }
 
   case '(': {
-    token = newToken(LPAREN, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, LPAREN, 1);
     break;
   }
 
   case ')': {
-    token = newToken(RPAREN, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, RPAREN, 1);
     break;
   }
 
   case '{': {
-    token = newToken(LBRACE, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, LBRACE, 1);
     break;
   }
 
   case '}': {
-    token = newToken(RBRACE, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, RBRACE, 1);
     break;
   }
 
   case '[': {
-    token = newToken(LBRACKET, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, LBRACKET, 1);
     break;
   }
 
   case ']': {
-    token = newToken(RBRACKET, createSingleCharLiteral(lexer->currentChar));
+    token = charToken(lexer, RBRACKET, 1);
     break;
   }
 
   case '"': {
-    token.type = STRING;
-    token.literal = readString(lexer);
+    token = readString(lexer);
     break;
   }
 
   case 0: {
-    token.literal = createSingleCharLiteral(0);
-    token.type = EOF_TOK;
+    // position keeps advancing past the end, so anchor EOF at the terminator
+    token = lexerToken(lexer, EOF_TOK, &lexer->input[lexer->inputLength], 0);
     break;
   }
   default: {
     if (isLetter(lexer->currentChar)) {
-      token.literal = readIdentifier(lexer);
-      token.type = lookupIdentifier(token.literal);
-      return token;
+      return readIdentifier(lexer);
     } else if (isDigit(lexer->currentChar)) {
-      token.literal = readNumber(lexer);
-      token.type = INT;
-      return token;
+      return readNumber(lexer);
     } else {
-      token = newToken(ILLEGAL, createSingleCharLiteral(lexer->currentChar));
+      token = charToken(lexer, ILLEGAL, 1);
     }
     break;
   }
@@ -9,10 +9,15 @@ typedef struct {
   int nextPosition;
   int inputLength;
   unsigned char currentChar;
+  int line; // of position, counted as whitespace and strings are skipped
 } Lexer;
 
 Lexer *newLexer(char *input);
 
+// lexes exactly length bytes of input, which need not be null-terminated
+// (e.g. an mmap'd file); nothing at or past input[length] is read
+Lexer *newLexerWithLength(char *input, int length);
+
 Token nextToken(Lexer *lexer);
 
 #endif
@@ -0,0 +1,289 @@
+#include "scan.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__))
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+typedef int (*ScanFn)(const char *input, int pos, int end);
+
+typedef struct {
+  ScanFn whitespace;
+  ScanFn letters;
+  ScanFn digits;
+  ScanFn string;
+} Scanners;
+
+// ===== SCALAR =====
+
+static int isWhitespaceByte(unsigned char ch) {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+static int isLetterByte(unsigned char ch) {
+  return ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z') || ch == '_';
+}
+
+static int isDigitByte(unsigned char ch) { return '0' <= ch && ch <= '9'; }
+
+static int scalarWhitespace(const char *input, int pos, int end) {
+  while (pos < end && isWhitespaceByte(input[pos])) {
+    pos++;
+  }
+  return pos;
+}
+
+static int scalarLetters(const char *input, int pos, int end) {
+  while (pos < end && isLetterByte(input[pos])) {
+    pos++;
+  }
+  return pos;
+}
+
+static int scalarDigits(const char *input, int pos, int end) {
+  while (pos < end && isDigitByte(input[pos])) {
+    pos++;
+  }
+  return pos;
+}
+
+static int scalarString(const char *input, int pos, int end) {
+  while (pos < end && input[pos] != '"' && input[pos] != '\n') {
+    pos++;
+  }
+  return pos;
+}
+
+static const Scanners scalarScanners = {scalarWhitespace, scalarLetters,
+                                        scalarDigits, scalarString};
+
+#ifdef SCAN_X86
+
+// ===== SSE2 =====
+// every class test yields 0xff in the lanes that belong to the run; the
+// first zero lane of the movemask is where the run ends. unsigned range
+// checks use min: x <= n exactly when min(x, n) == x
+
+static __m128i sse2Whitespace(__m128i x) {
+  __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                            _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+  ws = _mm_or_si128(ws, _mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+  return _mm_or_si128(ws, _mm_cmpeq_epi8(x, _mm_set1_epi8('\r')));
+}
+
+static __m128i sse2Letters(__m128i x) {
+  // folding 0x20 maps 'A'-'Z' onto 'a'-'z' and nothing else onto them
+  __m128i folded = _mm_or_si128(x, _mm_set1_epi8(0x20));
+  __m128i offset = _mm_sub_epi8(folded, _mm_set1_epi8('a'));
+  __m128i letter =
+      _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(25)), offset);
+  return _mm_or_si128(letter, _mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+}
+
+static __m128i sse2Digits(__m128i x) {
+  __m128i offset = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+  return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(9)), offset);
+}
+
+// returns from the enclosing scanner if the run ends in the 16 bytes at pos
+#define SCAN_BLOCK16(classify)                                                 \
+  do {                                                                         \
+    __m128i x = _mm_loadu_si128((const __m128i *)(input + pos));               \
+    unsigned stop = ~(unsigned)_mm_movemask_epi8(classify(x)) & 0xffffu;       \
+    if (stop) {                                                                \
+      return pos + __builtin_ctz(stop);                                        \
+    }                                                                          \
+    pos += 16;                                                                 \
+  } while (0)
+
+#define SSE2_SCAN(name, classify, scalar)                                      \
+  static int name(const char *input, int pos, int end) {                       \
+    while (pos + 16 <= end) {                                                  \
+      SCAN_BLOCK16(classify);                                                  \
+    }                                                                          \
+    return scalar(input, pos, end);                                            \
+  }
+
+SSE2_SCAN(sse2ScanWhitespace, sse2Whitespace, scalarWhitespace)
+SSE2_SCAN(sse2ScanLetters, sse2Letters, scalarLetters)
+SSE2_SCAN(sse2ScanDigits, sse2Digits, scalarDigits)
+
+static int sse2ScanString(const char *input, int pos, int end) {
+  __m128i quote = _mm_set1_epi8('"');
+  __m128i newline = _mm_set1_epi8('\n');
+  while (pos + 16 <= end) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(input + pos));
+    unsigned found = (unsigned)_mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, newline)));
+    if (found) {
+      return pos + __builtin_ctz(found);
+    }
+    pos += 16;
+  }
+  return scalarString(input, pos, end);
+}
+
+static const Scanners sse2Scanners = {sse2ScanWhitespace, sse2ScanLetters,
+                                      sse2ScanDigits, sse2ScanString};
+
+// ===== AVX2 =====
+// same class tests on 32 lanes
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static __m256i avx2Whitespace(__m256i x) {
+  __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')),
+                               _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t')));
+  ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')));
+  return _mm256_or_si256(ws, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r')));
+}
+
+AVX2 static __m256i avx2Letters(__m256i x) {
+  __m256i folded = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+  __m256i offset = _mm256_sub_epi8(folded, _mm256_set1_epi8('a'));
+  __m256i letter =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(25)), offset);
+  return _mm256_or_si256(letter, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_')));
+}
+
+AVX2 static __m256i avx2Digits(__m256i x) {
+  __m256i offset = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(9)),
+                           offset);
+}
+
+// most runs are short, so one 16 byte block is tried before going wide.
+// the narrow blocks are inlined here rather than calling the sse2 scanners,
+// which keeps the whole scan in vex-encoded code
+#define AVX2_SCAN(name, classify, classify16, scalar)                          \
+  AVX2 static int name(const char *input, int pos, int end) {                  \
+    if (pos + 16 <= end) {                                                     \
+      SCAN_BLOCK16(classify16);                                                \
+    }                                                                          \
+    while (pos + 32 <= end) {                                                  \
+      __m256i x = _mm256_loadu_si256((const __m256i *)(input + pos));          \
+      unsigned stop = ~(unsigned)_mm256_movemask_epi8(classify(x));            \
+      if (stop) {                                                              \
+        return pos + __builtin_ctz(stop);                                      \
+      }                                                                        \
+      pos += 32;                                                               \
+    }                                                                          \
+    if (pos + 16 <= end) {                                                     \
+      SCAN_BLOCK16(classify16);                                                \
+    }                                                                          \
+    return scalar(input, pos, end);                                            \
+  }
+
+AVX2_SCAN(avx2ScanWhitespace, avx2Whitespace, sse2Whitespace, scalarWhitespace)
+AVX2_SCAN(avx2ScanLetters, avx2Letters, sse2Letters, scalarLetters)
+AVX2_SCAN(avx2ScanDigits, avx2Digits, sse2Digits, scalarDigits)
+
+AVX2 static int avx2ScanString(const char *input, int pos, int end) {
+  __m256i quote = _mm256_set1_epi8('"');
+  __m256i newline = _mm256_set1_epi8('\n');
+  while (pos + 32 <= end) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(input + pos));
+    unsigned found = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(
+        _mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, newline)));
+    if (found) {
+      return pos + __builtin_ctz(found);
+    }
+    pos += 32;
+  }
+  return scalarString(input, pos, end);
+}
+
+static const Scanners avx2Scanners = {avx2ScanWhitespace, avx2ScanLetters,
+                                      avx2ScanDigits, avx2ScanString};
+
+#endif
+
+// ===== DISPATCH =====
+
+static const Scanners *active = NULL;
+static ScanLevel activeLevel = SCAN_SCALAR;
+
+static ScanLevel cpuLevel() {
+#ifdef SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return SCAN_AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return SCAN_SSE2;
+  }
+#endif
+  return SCAN_SCALAR;
+}
+
+ScanLevel scanSetLevel(ScanLevel level) {
+  ScanLevel supported = cpuLevel();
+  if (level > supported) {
+    level = supported;
+  }
+
+  activeLevel = level;
+  switch (level) {
+#ifdef SCAN_X86
+  case SCAN_AVX2:
+    active = &avx2Scanners;
+    break;
+  case SCAN_SSE2:
+    active = &sse2Scanners;
+    break;
+#endif
+  default:
+    active = &scalarScanners;
+    break;
+  }
+  return activeLevel;
+}
+
+static const Scanners *scanners() {
+  if (!active) {
+    ScanLevel level = SCAN_AVX2;
+    char *value = getenv("MONKEYC_SIMD");
+    if (value && strcmp(value, "scalar") == 0) {
+      level = SCAN_SCALAR;
+    } else if (value && strcmp(value, "sse2") == 0) {
+      level = SCAN_SSE2;
+    }
+    scanSetLevel(level);
+  }
+  return active;
+}
+
+ScanLevel scanGetLevel() {
+  scanners();
+  return activeLevel;
+}
+
+const char *scanLevelName(ScanLevel level) {
+  switch (level) {
+  case SCAN_AVX2:
+    return "avx2";
+  case SCAN_SSE2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
+
+int scanWhitespace(const char *input, int pos, int end) {
+  return scanners()->whitespace(input, pos, end);
+}
+
+int scanLetters(const char *input, int pos, int end) {
+  return scanners()->letters(input, pos, end);
+}
+
+int scanDigits(const char *input, int pos, int end) {
+  return scanners()->digits(input, pos, end);
+}
+
+int scanString(const char *input, int pos, int end) {
+  return scanners()->string(input, pos, end);
+}
@@ -0,0 +1,34 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+// character-class scanners used by the lexer to skip over whole runs of
+// whitespace, identifier letters, digits and string bodies at once.
+//
+// each scanner returns the index of the first byte in [pos, end) that ends
+// the run, or end when the run reaches it. bytes at or past end are never
+// read, so end may be the exact length of the buffer.
+//
+// the implementation is picked once at runtime from what the cpu supports
+// (avx2, then sse2, then plain c); MONKEYC_SIMD=scalar|sse2|avx2 caps it
+typedef enum { SCAN_SCALAR, SCAN_SSE2, SCAN_AVX2 } ScanLevel;
+
+// index of the first byte that is not ' ', '\t', '\n' or '\r'
+int scanWhitespace(const char *input, int pos, int end);
+
+// index of the first byte that is not a letter or '_'
+int scanLetters(const char *input, int pos, int end);
+
+// index of the first byte that is not '0'-'9'
+int scanDigits(const char *input, int pos, int end);
+
+// index of the first '"' or '\n', so string bodies can be skipped while
+// counting the lines they span
+int scanString(const char *input, int pos, int end);
+
+// selects the implementation; levels the cpu lacks fall back to the best
+// one it has. returns the level now in use
+ScanLevel scanSetLevel(ScanLevel level);
+ScanLevel scanGetLevel();
+const char *scanLevelName(ScanLevel level);
+
+#endif
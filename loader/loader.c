@@ -0,0 +1,396 @@
+#include "loader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Little-endian decoding helpers
+static uint32_t read_le32(const unsigned char *buf) {
+  return (uint32_t)buf[0] |
+         ((uint32_t)buf[1] << 8) |
+         ((uint32_t)buf[2] << 16) |
+         ((uint32_t)buf[3] << 24);
+}
+
+static uint64_t read_le64(const unsigned char *buf) {
+  return (uint64_t)buf[0] |
+         ((uint64_t)buf[1] << 8) |
+         ((uint64_t)buf[2] << 16) |
+         ((uint64_t)buf[3] << 24) |
+         ((uint64_t)buf[4] << 32) |
+         ((uint64_t)buf[5] << 40) |
+         ((uint64_t)buf[6] << 48) |
+         ((uint64_t)buf[7] << 56);
+}
+
+// Forward declaration
+static int deserializeObject(Object *obj, unsigned char *data, int offset, int total_len);
+
+// Deserialize an object from buffer, returns new offset
+static int deserializeObject(Object *obj, unsigned char *data, int offset, int total_len) {
+  if (offset >= total_len) {
+    fprintf(stderr, "❌ unexpected EOF while reading object tag\n");
+    exit(1);
+  }
+  
+  uint8_t tag = *(uint8_t *)(data + offset);
+  offset += 1;
+  
+  if (tag == CONST_INTEGER) {
+    if (offset + (int)sizeof(int64_t) > total_len) {
+      fprintf(stderr, "❌ truncated integer object\n");
+      exit(1);
+    }
+    int64_t val = read_le64(data + offset);
+    offset += sizeof(int64_t);
+    
+    Integer *intObj = malloc(sizeof(Integer));
+    intObj->value = val;
+    obj->type = "Integer";
+    obj->integer = intObj;
+    
+  } else if (tag == CONST_STRING) {
+    if (offset + (int)sizeof(int32_t) > total_len) {
+      fprintf(stderr, "❌ truncated string length\n");
+      exit(1);
+    }
+    int32_t len = read_le32(data + offset);
+    offset += sizeof(int32_t);
+    
+    if (offset + len > total_len) {
+      fprintf(stderr, "❌ truncated string data\n");
+      exit(1);
+    }
+    char *str = malloc(len + 1);
+    memcpy(str, data + offset, len);
+    str[len] = '\0';
+    offset += len;
+    
+    obj->type = "String";
+    obj->string = newString(str, len);
+    
+  } else if (tag == CONST_BOOLEAN) {
+    if (offset + 1 > total_len) {
+      fprintf(stderr, "❌ truncated boolean value\n");
+      exit(1);
+    }
+    uint8_t val = *(uint8_t *)(data + offset);
+    offset += 1;
+    
+    Boolean *boolObj = malloc(sizeof(Boolean));
+    boolObj->value = (val != 0);
+    obj->type = "Boolean";
+    obj->boolean = boolObj;
+    
+  } else if (tag == CONST_NULL) {
+    Null *nullObj = malloc(sizeof(Null));
+    obj->type = "Null";
+    obj->null = nullObj;
+    
+  } else if (tag == CONST_ARRAY) {
+    if (offset + (int)sizeof(int32_t) > total_len) {
+      fprintf(stderr, "❌ truncated array count\n");
+      exit(1);
+    }
+    int32_t count = read_le32(data + offset);
+    offset += sizeof(int32_t);
+    
+    Object *elements = malloc(sizeof(Object) * count);
+    
+    for (int i = 0; i < count; i++) {
+      offset = deserializeObject(&elements[i], data, offset, total_len);
+    }
+    
+    obj->type = "Array";
+    obj->array = newArrayOf(elements, count);
+    
+  } else if (tag == CONST_HASH) {
+    if (offset + (int)sizeof(int32_t) > total_len) {
+      fprintf(stderr, "❌ truncated hash pair count\n");
+      exit(1);
+    }
+    int32_t pairCount = read_le32(data + offset);
+    offset += sizeof(int32_t);
+    
+    Hash *hashObj = newHash();
+    
+    // Read key-value pairs and insert into hash so lookups hash to the
+    // right buckets (snapshot globals are indexed at runtime)
+    for (int i = 0; i < pairCount; i++) {
+      Object key, value;
+      offset = deserializeObject(&key, data, offset, total_len);
+      offset = deserializeObject(&value, data, offset, total_len);
+      hashSet(hashObj, &key, &value);
+    }
+    // whatever the loader builds lives as long as the program, so each
+    // hash can be its own shape
+    hashObj->shape = hashObj;
+    
+    obj->type = "Hash";
+    obj->hash = hashObj;
+    
+  } else if (tag == CONST_COMPILED_FUNCTION) {
+    // Read instruction count
+    if (offset + (int)sizeof(int32_t) > total_len) {
+      fprintf(stderr, "❌ truncated compiled function instruction count\n");
+      exit(1);
+    }
+    int32_t instr_count = read_le32(data + offset);
+    offset += sizeof(int32_t);
+    
+    // Read instructions
+    if (offset + instr_count > total_len) {
+      fprintf(stderr, "❌ truncated compiled function instructions\n");
+      exit(1);
+    }
+    unsigned char *instructions = malloc(instr_count);
+    memcpy(instructions, data + offset, instr_count);
+    offset += instr_count;
+    
+    // Read numLocals
+    if (offset + (int)sizeof(int32_t) > total_len) {
+      fprintf(stderr, "❌ truncated compiled function numLocals\n");
+      exit(1);
+    }
+    int32_t numLocals = read_le32(data + offset);
+    offset += sizeof(int32_t);
+    
+    // Read numParameters
+    if (offset + (int)sizeof(int32_t) > total_len) {
+      fprintf(stderr, "❌ truncated compiled function numParameters\n");
+      exit(1);
+    }
+    int32_t numParameters = read_le32(data + offset);
+    offset += sizeof(int32_t);
+    
+    // Create CompiledFunction object
+    CompiledFunction *fnObj = malloc(sizeof(CompiledFunction));
+    fnObj->instructions = (char*)instructions;
+    fnObj->instructionCount = instr_count;
+    fnObj->numLocals = numLocals;
+    fnObj->native = NULL;
+    fnObj->invocationCount = 0;
+    fnObj->jitFailed = false;
+    fnObj->numParameters = numParameters;
+    fnObj->lineTable = NULL; // filled in from the line section, if any
+    fnObj->lineTableLength = 0;
+    
+    obj->type = "CompiledFunction";
+    obj->compiledFunction = fnObj;
+    
+  } else {
+    fprintf(stderr, "❌ unknown object tag: %d\n", tag);
+    exit(1);
+  }
+  
+  return offset;
+}
+
+// read the snapshot section payload: entry position, then the globals
+static void deserializeSnapshot(Snapshot *snapshot, unsigned char *data,
+                                int offset, int end) {
+  if (offset + (int)(2 * sizeof(int32_t)) > end) {
+    fprintf(stderr, "❌ truncated snapshot header\n");
+    exit(1);
+  }
+  snapshot->entryPosition = read_le32(data + offset);
+  offset += sizeof(int32_t);
+  snapshot->globalCount = read_le32(data + offset);
+  offset += sizeof(int32_t);
+
+  if (snapshot->globalCount > GLOBAL_SIZE) {
+    fprintf(stderr, "❌ snapshot holds too many globals: %d\n", snapshot->globalCount);
+    exit(1);
+  }
+
+  snapshot->globals = malloc(sizeof(Object) * snapshot->globalCount);
+  for (int i = 0; i < snapshot->globalCount; i++) {
+    offset = deserializeObject(&snapshot->globals[i], data, offset, end);
+  }
+  snapshot->present = 1;
+}
+
+// copies length bytes at offset into a new table, NULL for an empty one
+static unsigned char *readLineTable(unsigned char *data, int offset,
+                                    int length, int end) {
+  if (length < 0 || offset + length > end) {
+    fprintf(stderr, "❌ truncated line table\n");
+    exit(1);
+  }
+  if (length == 0) {
+    return NULL;
+  }
+  unsigned char *table = malloc(length);
+  memcpy(table, data + offset, length);
+  return table;
+}
+
+// read the line section payload; runs after the snapshot section so that
+// tables can be attached to the functions held in its globals
+static void deserializeLines(ByteCode *bc, Snapshot *snapshot,
+                             unsigned char *data, int offset, int end) {
+  if (offset + (int)sizeof(int32_t) > end) {
+    fprintf(stderr, "❌ truncated line section\n");
+    exit(1);
+  }
+  bc->lineTableLength = read_le32(data + offset);
+  offset += sizeof(int32_t);
+  bc->lineTable = readLineTable(data, offset, bc->lineTableLength, end);
+  offset += bc->lineTableLength;
+
+  while (offset < end) {
+    if (offset + 1 + (int)(2 * sizeof(int32_t)) > end) {
+      fprintf(stderr, "❌ truncated line table record\n");
+      exit(1);
+    }
+    uint8_t owner = data[offset];
+    offset += 1;
+    int32_t index = read_le32(data + offset);
+    offset += sizeof(int32_t);
+    int32_t length = read_le32(data + offset);
+    offset += sizeof(int32_t);
+
+    Object *holder = NULL;
+    if (owner == LINES_CONSTANT && index >= 0 && index < bc->constantsCount) {
+      holder = &bc->constants[index];
+    } else if (owner == LINES_GLOBAL && snapshot->present && index >= 0 &&
+               index < snapshot->globalCount) {
+      holder = &snapshot->globals[index];
+    }
+    if (!holder || strcmp(holder->type, CompiledFunctionObj) != 0) {
+      fprintf(stderr, "❌ line table for a missing function\n");
+      exit(1);
+    }
+
+    holder->compiledFunction->lineTable =
+        readLineTable(data, offset, length, end);
+    holder->compiledFunction->lineTableLength = length;
+    offset += length;
+  }
+}
+
+ByteCode *deserializeBytecode(unsigned char *data, int total_len, Snapshot *snapshot) {
+  ByteCode *bc = malloc(sizeof(ByteCode));
+  int offset = 0;
+
+  if (offset + (int)sizeof(int32_t) > total_len) {
+    fprintf(stderr, "❌ truncated bytecode: no instruction length\n");
+    exit(1);
+  }
+
+  int32_t instr_len = read_le32(data + offset);
+  offset += sizeof(int32_t);
+
+  bc->instructions = malloc(instr_len);
+  memcpy(bc->instructions, data + offset, instr_len);
+  bc->instructionCount = instr_len;
+  offset += instr_len;
+  bc->lineTable = NULL;
+  bc->lineTableLength = 0;
+
+  if (offset + (int)sizeof(int32_t) > total_len) {
+    fprintf(stderr, "❌ truncated bytecode: no constant count\n");
+    exit(1);
+  }
+
+  int32_t const_count = read_le32(data + offset);
+  offset += sizeof(int32_t);
+  bc->constantsCount = const_count;
+  bc->constants = malloc(sizeof(Object) * const_count);
+
+  for (int i = 0; i < const_count; i++) {
+    offset = deserializeObject(&bc->constants[i], data, offset, total_len);
+  }
+
+  // Optional sections: tag + length + payload, unknown tags are skipped
+  snapshot->present = 0;
+  snapshot->globals = NULL;
+  snapshot->globalCount = 0;
+  snapshot->entryPosition = 0;
+  int linesOffset = -1;
+  int linesEnd = 0;
+  while (offset < total_len) {
+    if (offset + 1 + (int)sizeof(int32_t) > total_len) {
+      fprintf(stderr, "❌ truncated section header\n");
+      exit(1);
+    }
+    uint8_t tag = data[offset];
+    offset += 1;
+    int32_t section_len = read_le32(data + offset);
+    offset += sizeof(int32_t);
+
+    if (offset + section_len > total_len) {
+      fprintf(stderr, "❌ truncated section %d\n", tag);
+      exit(1);
+    }
+
+    if (tag == SECTION_SNAPSHOT) {
+      deserializeSnapshot(snapshot, data, offset, offset + section_len);
+    } else if (tag == SECTION_LINES) {
+      linesOffset = offset;
+      linesEnd = offset + section_len;
+    }
+    offset += section_len;
+  }
+
+  if (linesOffset >= 0) {
+    deserializeLines(bc, snapshot, data, linesOffset, linesEnd);
+  }
+
+  return bc;
+}
+
+// find the LAST occurrence of the marker (search backwards) and return the
+// bytecode that follows it
+unsigned char *findBytecode(unsigned char *data, long size, int *length) {
+  unsigned char *marker = NULL;
+  size_t marker_len = strlen(BYTECODE_MARKER);
+  for (long i = size - marker_len; i >= 0; i--) {
+    if (memcmp(data + i, BYTECODE_MARKER, marker_len) == 0) {
+      marker = data + i;
+      break;
+    }
+  }
+
+  if (!marker) {
+    fprintf(stderr, "❌ no bytecode marker found.\n");
+    return NULL;
+  }
+
+  size_t marker_offset = marker - data;
+  size_t len_offset = marker_offset + marker_len;
+
+  if (len_offset + sizeof(int32_t) > (size_t)size) {
+    fprintf(stderr, "❌ not enough space for bytecode length\n");
+    return NULL;
+  }
+
+  int32_t bytecode_len = read_le32(data + len_offset);
+  unsigned char *bytecode = data + len_offset + sizeof(int32_t);
+
+  if (bytecode + bytecode_len > data + size) {
+    fprintf(stderr, "❌ bytecode exceeds file size\n");
+    return NULL;
+  }
+
+  *length = bytecode_len;
+  return bytecode;
+}
+
+VM *loadVM(ByteCode *bc, Snapshot *snapshot) {
+  if (!snapshot || !snapshot->present) {
+    return newVM(bc);
+  }
+
+  // restore the pre-initialized globals and skip their initializers
+  Object *globals = malloc(sizeof(Object) * GLOBAL_SIZE);
+  Object nullObj = {.type = NullObj, .null = malloc(sizeof(Null))};
+  for (int i = 0; i < GLOBAL_SIZE; i++) {
+    globals[i] = i < snapshot->globalCount ? snapshot->globals[i] : nullObj;
+  }
+
+  VM *vm = newVMWithGlobalStore(bc, globals, GLOBAL_SIZE);
+  if (vm) {
+    vm->frames[0].ip = snapshot->entryPosition - 1;
+  }
+  return vm;
+}
@@ -0,0 +1,49 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "../compiler/compiler.h"
+#include "../object/object.h"
+#include "../vm/vm.h"
+
+// serialized bytecode layout shared by `monkeyc build` and the runtime:
+// marker, length, instructions, constant pool, then optional sections
+#define BYTECODE_MARKER "MONKEY_BYTECODE"
+
+#define CONST_INTEGER 1
+#define CONST_STRING  2
+#define CONST_COMPILED_FUNCTION 3
+#define CONST_BOOLEAN 4
+#define CONST_NULL 5
+#define CONST_ARRAY 6
+#define CONST_HASH 7
+
+// optional sections that may follow the constant pool
+#define SECTION_SNAPSHOT 1
+// pc -> source line tables: the main table as a length and its bytes, then
+// one record per function that has a table: owner, index (into the constant
+// pool or the snapshot globals), length and bytes
+#define SECTION_LINES 2
+#define LINES_CONSTANT 0
+#define LINES_GLOBAL 1
+
+// globals captured at build time by `monkeyc build --snapshot`
+typedef struct {
+  int present;
+  int entryPosition;
+  Object *globals;
+  int globalCount;
+} Snapshot;
+
+// locate the bytecode appended after the last marker in data
+// returns: pointer to the bytecode and its length in *length, or NULL
+unsigned char *findBytecode(unsigned char *data, long size, int *length);
+
+// decode serialized bytecode; exits on malformed input
+// snapshot: filled in from the snapshot section, if present; line tables come
+// from the line section, if present, and are NULL otherwise
+ByteCode *deserializeBytecode(unsigned char *data, int total_len, Snapshot *snapshot);
+
+// create a vm for bc, restoring the snapshot's globals and entry point
+VM *loadVM(ByteCode *bc, Snapshot *snapshot);
+
+#endif
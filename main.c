@@ -1,7 +1,12 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <unistd.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -11,8 +16,10 @@
 #include "parser/parser.h"
 #include "compiler/compiler.h"
 #include "vm/vm.h"
+#include "loader/loader.h"
+#include "aot/aot.h"
+#include "jit/jit.h"
 
-#define BYTECODE_MARKER "MONKEY_BYTECODE"
 #include "vm_stub_embed.h"
 
 #define VERSION "0.1.0"
@@ -36,6 +43,9 @@ typedef struct {
   char *input_file;
   char *output_file;
   char *error_message;
+  bool snapshot;
+  bool aot;
+  bool noJit;
 } ParsedArgs;
 
 // --- Helper to read a file into memory ---
@@ -69,13 +79,139 @@ char *readFile(const char *filename) {
   return buffer;
 }
 
-#define CONST_INTEGER 1
-#define CONST_STRING  2
-#define CONST_COMPILED_FUNCTION 3
-#define CONST_BOOLEAN 4
-#define CONST_NULL 5
-#define CONST_ARRAY 6
-#define CONST_HASH 7
+// a source file as the lexer sees it: mapped straight from the page cache
+// when possible, so big scripts are never copied onto the heap
+typedef struct {
+  char *data;
+  size_t length;
+  bool mapped;
+} SourceText;
+
+static bool openSource(const char *filename, SourceText *out) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  if (st.st_size > INT_MAX) {
+    fprintf(stderr, "❌ %s is too large (%lld bytes)\n", filename,
+            (long long)st.st_size);
+    close(fd);
+    return false;
+  }
+
+  if (S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      posix_madvise(data, st.st_size, POSIX_MADV_SEQUENTIAL);
+      close(fd);
+      out->data = data;
+      out->length = st.st_size;
+      out->mapped = true;
+      return true;
+    }
+  }
+  close(fd);
+
+  // empty files and anything mmap refuses are read the ordinary way
+  out->data = readFile(filename);
+  if (!out->data) {
+    return false;
+  }
+  out->length = strlen(out->data);
+  out->mapped = false;
+  return true;
+}
+
+static void closeSource(SourceText *source) {
+  if (source->mapped) {
+    munmap(source->data, source->length);
+  } else {
+    free(source->data);
+  }
+  source->data = NULL;
+}
+
+// compiles the source one top-level statement at a time: each statement is
+// parsed into an arena that is reset once it has been compiled, so the tree
+// never holds more than the largest single statement (or, while function
+// bodies are queued for the compiler's threads, one batch of them).
+//
+// leadingLets is the number of `let` statements at the top of the program up
+// to the first whose initializer calls a function (its side effects have to
+// happen when the program runs, not when a snapshot is taken) and
+// entryPosition the instruction offset right after them, which is where
+// snapshots are taken. returns NULL after reporting parse errors
+static Compiler *compileSource(char *input, size_t length, int *leadingLets,
+                               int *entryPosition) {
+  Lexer *lexer = newLexerWithLength(input, (int)length);
+  Parser *parser = newParser(lexer);
+  parser->arena = newAstArena();
+  Compiler *compiler = newCompiler();
+
+  bool inLets = true;
+  bool compileFailed = false;
+  int lets = 0;
+  int entry = 0;
+
+  Statement *stmt;
+  while ((stmt = parseNextStatement(parser)) != NULL) {
+    // after an error the rest is only parsed, to report every parse error
+    if (parser->errorCount == 0 && !compileFailed) {
+      if (inLets && (stmt->type != NODE_LET_STATEMENT ||
+                     expressionCalls(stmt->letStatement->value))) {
+        inLets = false;
+        entry = getByteCodeInstructionsLength(compiler);
+      }
+      if (inLets) {
+        lets++;
+      }
+      // the bytecode holds its own copies of everything it needs from the tree
+      compileFailed = compileStatement(compiler, stmt) != 0;
+    }
+    if (compiler->jobCount == 0) {
+      astArenaReset(parser->arena);
+    }
+  }
+  if (inLets) {
+    entry = getByteCodeInstructionsLength(compiler);
+  }
+
+  bool ok = parser->errorCount == 0;
+  if (!ok) {
+    printf("Parser errors found:\n");
+    for (int i = 0; i < parser->errorCount; i++) {
+      printf("  %s\n", parser->errors[i]);
+    }
+  } else if (compileFailed) {
+    // as with compileProgram, a compile error leaves the bytecode emitted
+    // so far and skips the final fix-up
+    compileFlush(compiler);
+  } else {
+    compileFinish(compiler);
+  }
+
+  // queued bodies are compiled by now
+  freeAstArena(parser->arena);
+  freeParser(parser);
+  free(lexer);
+
+  if (!ok) {
+    return NULL;
+  }
+  if (leadingLets) {
+    *leadingLets = lets;
+  }
+  if (entryPosition) {
+    *entryPosition = entry;
+  }
+  return compiler;
+}
 
 // Little-endian encoding/decoding helpers
 static void write_le32(unsigned char *buf, uint32_t val) {
@@ -104,7 +240,7 @@ static size_t calculateObjectSize(Object *obj) {
   if (strcmp(obj->type, "Integer") == 0) {
     return 1 + sizeof(int64_t); // tag + value
   } else if (strcmp(obj->type, "String") == 0) {
-    return 1 + sizeof(int32_t) + strlen(obj->string->value); // tag + length + content
+    return 1 + sizeof(int32_t) + obj->string->length; // tag + length + content
   } else if (strcmp(obj->type, "Boolean") == 0) {
     return 1 + 1; // tag + bool value (1 byte)
   } else if (strcmp(obj->type, "Null") == 0) {
@@ -112,19 +248,18 @@ static size_t calculateObjectSize(Object *obj) {
   } else if (strcmp(obj->type, "Array") == 0) {
     size_t size = 1 + sizeof(int32_t); // tag + count
     for (int i = 0; i < obj->array->count; i++) {
-      size += calculateObjectSize(&obj->array->elements[i]);
+      Integer box;
+      Object element = arrayGetValue(obj->array, i, &box);
+      size += calculateObjectSize(&element);
     }
     return size;
   } else if (strcmp(obj->type, "Hash") == 0) {
     size_t size = 1 + sizeof(int32_t); // tag + pair count
-    // Iterate through all buckets to count pairs
-    for (int i = 0; i < obj->hash->bucketCount; i++) {
-      HashEntry *entry = obj->hash->buckets[i];
-      while (entry != NULL) {
-        size += calculateObjectSize(&entry->key);
-        size += calculateObjectSize(&entry->value);
-        entry = entry->next;
-      }
+    int cursor = 0;
+    HashEntry *entry;
+    while ((entry = hashNext(obj->hash, &cursor)) != NULL) {
+      size += calculateObjectSize(&entry->key);
+      size += calculateObjectSize(&entry->value);
     }
     return size;
   } else if (strcmp(obj->type, "CompiledFunction") == 0) {
@@ -147,12 +282,12 @@ static size_t serializeObject(Object *obj, unsigned char *buf, size_t offset) {
     
   } else if (strcmp(obj->type, "String") == 0) {
     uint8_t tag = CONST_STRING;
-    int32_t len = strlen(obj->string->value);
+    int32_t len = obj->string->length;
     memcpy(buf + offset, &tag, 1);
     offset += 1;
     write_le32(buf + offset, len);
     offset += sizeof(int32_t);
-    memcpy(buf + offset, obj->string->value, len);
+    memcpy(buf + offset, stringValue(obj->string), len);
     offset += len;
     
   } else if (strcmp(obj->type, "Boolean") == 0) {
@@ -175,7 +310,9 @@ static size_t serializeObject(Object *obj, unsigned char *buf, size_t offset) {
     write_le32(buf + offset, obj->array->count);
     offset += sizeof(int32_t);
     for (int i = 0; i < obj->array->count; i++) {
-      offset = serializeObject(&obj->array->elements[i], buf, offset);
+      Integer box;
+      Object element = arrayGetValue(obj->array, i, &box);
+      offset = serializeObject(&element, buf, offset);
     }
     
   } else if (strcmp(obj->type, "Hash") == 0) {
@@ -185,13 +322,11 @@ static size_t serializeObject(Object *obj, unsigned char *buf, size_t offset) {
     write_le32(buf + offset, obj->hash->size); // number of key-value pairs
     offset += sizeof(int32_t);
     // Serialize all key-value pairs
-    for (int i = 0; i < obj->hash->bucketCount; i++) {
-      HashEntry *entry = obj->hash->buckets[i];
-      while (entry != NULL) {
-        offset = serializeObject(&entry->key, buf, offset);
-        offset = serializeObject(&entry->value, buf, offset);
-        entry = entry->next;
-      }
+    int cursor = 0;
+    HashEntry *entry;
+    while ((entry = hashNext(obj->hash, &cursor)) != NULL) {
+      offset = serializeObject(&entry->key, buf, offset);
+      offset = serializeObject(&entry->value, buf, offset);
     }
     
   } else if (strcmp(obj->type, "CompiledFunction") == 0) {
@@ -211,7 +346,58 @@ static size_t serializeObject(Object *obj, unsigned char *buf, size_t offset) {
   return offset;
 }
 
-SerializedBytecode serializeBytecode(ByteCode *bc) {
+// the function held by obj if it has a line table, else NULL
+static CompiledFunction *functionWithLines(Object *obj) {
+  if (strcmp(obj->type, "CompiledFunction") != 0 ||
+      !obj->compiledFunction->lineTable) {
+    return NULL;
+  }
+  return obj->compiledFunction;
+}
+
+// one line table record per function in objects that has a table; returns
+// the new offset, or with buf NULL only adds up the size
+static size_t serializeLineRecords(Object *objects, int count, uint8_t owner,
+                                   unsigned char *buf, size_t offset) {
+  for (int i = 0; i < count; i++) {
+    CompiledFunction *fn = functionWithLines(&objects[i]);
+    if (!fn) {
+      continue;
+    }
+    if (buf) {
+      buf[offset] = owner;
+      write_le32(buf + offset + 1, i);
+      write_le32(buf + offset + 1 + sizeof(int32_t), fn->lineTableLength);
+      memcpy(buf + offset + 1 + 2 * sizeof(int32_t), fn->lineTable,
+             fn->lineTableLength);
+    }
+    offset += 1 + 2 * sizeof(int32_t) + fn->lineTableLength;
+  }
+  return offset;
+}
+
+// the line section payload, see SECTION_LINES; with buf NULL only its size
+static size_t serializeLines(ByteCode *bc, Snapshot *snapshot,
+                             unsigned char *buf, size_t offset) {
+  if (buf) {
+    write_le32(buf + offset, bc->lineTableLength);
+    if (bc->lineTable) {
+      memcpy(buf + offset + sizeof(int32_t), bc->lineTable,
+             bc->lineTableLength);
+    }
+  }
+  offset += sizeof(int32_t) + bc->lineTableLength;
+
+  offset = serializeLineRecords(bc->constants, bc->constantsCount,
+                                LINES_CONSTANT, buf, offset);
+  if (snapshot) {
+    offset = serializeLineRecords(snapshot->globals, snapshot->globalCount,
+                                  LINES_GLOBAL, buf, offset);
+  }
+  return offset;
+}
+
+SerializedBytecode serializeBytecode(ByteCode *bc, Snapshot *snapshot) {
   int instr_len = bc->instructionCount;
   int const_count = bc->constantsCount;
   size_t size = 0;
@@ -234,6 +420,19 @@ SerializedBytecode serializeBytecode(ByteCode *bc) {
     }
   }
 
+  size_t snapshotSize = 0;
+  if (snapshot) {
+    snapshotSize += sizeof(int32_t); // entry position
+    snapshotSize += sizeof(int32_t); // global count
+    for (int i = 0; i < snapshot->globalCount; i++) {
+      snapshotSize += calculateObjectSize(&snapshot->globals[i]);
+    }
+    size += 1 + sizeof(int32_t) + snapshotSize; // tag + length + payload
+  }
+
+  size_t linesSize = serializeLines(bc, snapshot, NULL, 0);
+  size += 1 + sizeof(int32_t) + linesSize;
+
   printf("🧮 Total size to serialize: %zu bytes\n", size);
 
   unsigned char *buf = malloc(size);
@@ -269,7 +468,7 @@ SerializedBytecode serializeBytecode(ByteCode *bc) {
         printf("   ↳ INTEGER value = %lld (%zu bytes)\n", obj->integer->value, obj_size);
       } else if (strcmp(obj->type, "String") == 0) {
         printf("   ↳ STRING length = %d, value = \"%s\" (%zu bytes)\n", 
-               (int)strlen(obj->string->value), obj->string->value, obj_size);
+               obj->string->length, stringValue(obj->string), obj_size);
       } else if (strcmp(obj->type, "Boolean") == 0) {
         printf("   ↳ BOOLEAN value = %s (%zu bytes)\n", 
                obj->boolean->value ? "true" : "false", obj_size);
@@ -287,6 +486,29 @@ SerializedBytecode serializeBytecode(ByteCode *bc) {
     }
   }
 
+  if (snapshot) {
+    printf("📸 Snapshot: %d globals, entry at %d (%zu bytes)\n",
+           snapshot->globalCount, snapshot->entryPosition, snapshotSize);
+    buf[offset] = SECTION_SNAPSHOT;
+    offset += 1;
+    write_le32(buf + offset, snapshotSize);
+    offset += sizeof(int32_t);
+    write_le32(buf + offset, snapshot->entryPosition);
+    offset += sizeof(int32_t);
+    write_le32(buf + offset, snapshot->globalCount);
+    offset += sizeof(int32_t);
+    for (int i = 0; i < snapshot->globalCount; i++) {
+      offset = serializeObject(&snapshot->globals[i], buf, offset);
+    }
+  }
+
+  printf("📍 Line tables: %zu bytes\n", linesSize);
+  buf[offset] = SECTION_LINES;
+  offset += 1;
+  write_le32(buf + offset, linesSize);
+  offset += sizeof(int32_t);
+  offset = serializeLines(bc, snapshot, buf, offset);
+
   printf("✅ Final serialized size: %zu bytes\n", offset);
 
   SerializedBytecode sb;
@@ -295,21 +517,79 @@ SerializedBytecode serializeBytecode(ByteCode *bc) {
   return sb;
 }
 
-void buildExecutable(const char *sourcePath, const char *outputPath) {
-  char *input = readFile(sourcePath);
-  if (!input) {
+// run the initializers up to the snapshot point inside the compiler process
+// and capture the resulting globals; returns false if the snapshot cannot be
+// taken, in which case the program is built without one
+static bool takeSnapshot(ByteCode *bc, int entryPosition, int globalCount,
+                         Snapshot *out) {
+  ByteCode prefix = *bc;
+  prefix.instructionCount = entryPosition;
+
+  VM *vm = newVM(&prefix);
+  if (!vm) {
+    return false;
+  }
+
+  if (run(vm) != 0) {
+    fprintf(stderr, "⚠️ Snapshot initializers failed, building without snapshot\n");
+    freeVM(vm);
+    return false;
+  }
+
+  for (int i = 0; i < globalCount; i++) {
+    if (calculateObjectSize(&vm->globals[i]) == 0) {
+      fprintf(stderr, "⚠️ Global %d has unsupported type %s, building without snapshot\n",
+              i, vm->globals[i].type);
+      freeVM(vm);
+      return false;
+    }
+  }
+
+  out->present = 1;
+  out->entryPosition = entryPosition;
+  out->globalCount = globalCount;
+  out->globals = malloc(sizeof(Object) * globalCount);
+  memcpy(out->globals, vm->globals, sizeof(Object) * globalCount);
+
+  freeVM(vm);
+  return true;
+}
+
+void buildExecutable(const char *sourcePath, const char *outputPath, bool snapshot,
+                     bool aot) {
+  SourceText source;
+  if (!openSource(sourcePath, &source)) {
     fprintf(stderr, "Failed to read %s\n", sourcePath);
     exit(1);
   }
 
-  Lexer *lexer = newLexer(input);
-  Parser *parser = newParser(lexer);
-  Program *program = parseProgram(parser);
+  int leadingLets = 0;
+  int entryPosition = 0;
+  Compiler *compiler =
+      compileSource(source.data, source.length, &leadingLets, &entryPosition);
+  closeSource(&source);
+  if (!compiler) {
+    exit(1);
+  }
 
-  Compiler *compiler = newCompiler();
-  compileProgram(compiler, program);
+  ByteCode *bytecode = getByteCode(compiler);
+  Snapshot snap;
+  bool haveSnapshot = false;
+  if (snapshot && leadingLets > 0) {
+    haveSnapshot = takeSnapshot(bytecode, entryPosition,
+                                compiler->symbolTable->numDefinitions, &snap);
+  }
 
-  SerializedBytecode sb = serializeBytecode(getByteCode(compiler));
+  SerializedBytecode sb = serializeBytecode(bytecode, haveSnapshot ? &snap : NULL);
+
+  if (aot) {
+    if (aotBuild(bytecode, sb.data, sb.length, haveSnapshot ? entryPosition : 0,
+                 outputPath) != 0) {
+      exit(1);
+    }
+    printf("✅ Built %s (native)\n", outputPath);
+    return;
+  }
 
   FILE *out = fopen(outputPath, "wb");
   if (!out) {
@@ -338,23 +618,12 @@ void buildExecutable(const char *sourcePath, const char *outputPath) {
 
 
 // --- Run in interpreter mode ---
-void runSource(char *input) {
-  Lexer *lexer = newLexer(input);
-  Parser *parser = newParser(lexer);
-  Program *program = parseProgram(parser);
-
-  // Check for parser errors
-  if (parser->errors && parser->errorCount > 0) {
-    printf("Parser errors found:\n");
-    for (int i = 0; i < parser->errorCount; i++) {
-      printf("  %s\n", parser->errors[i]);
-    }
+void runSource(char *input, size_t length) {
+  Compiler *compiler = compileSource(input, length, NULL, NULL);
+  if (!compiler) {
     return;
   }
 
-  Compiler *compiler = newCompiler();
-  compileProgram(compiler, program);
-
   ByteCode *bytecode = getByteCode(compiler);
   printf("Bytecode generated: %d instructions, %d constants\n", 
          bytecode->instructionCount, bytecode->constantsCount);
@@ -367,6 +636,9 @@ void runSource(char *input) {
 
   printf("running vm...\n");
   int result = run(vm);
+  if (result != 0) {
+    reportRuntimeError(vm);
+  }
   printf("ran vm... (result: %d)\n", result);
   printf("Stack pointer: %d\n", vm->sp);
   
@@ -391,7 +663,7 @@ void repl() {
     printf(">> ");
     if (!fgets(line, sizeof(line), stdin)) break;
     if (strncmp(line, "exit", 4) == 0) break;
-    runSource(line);
+    runSource(line, strlen(line));
   }
 }
 
@@ -400,20 +672,31 @@ void printUsage(const char *program_name) {
   printf("monkeyc programming language v%s\n\n", VERSION);
   printf("USAGE:\n");
   printf("  %s                           Start interactive REPL\n", program_name);
-  printf("  %s <file.mon>                Run a MonkeyC script\n", program_name);
+  printf("  %s <file.mon> [options]      Run a MonkeyC script\n", program_name);
   printf("  %s build <file.mon> [options] Compile to executable\n", program_name);
   printf("  %s help                      Show this help message\n", program_name);
   printf("  %s version                   Show version information\n\n", program_name);
 
+  printf("RUN OPTIONS:\n");
+  printf("  --no-jit                     Interpret every function (built executables\n");
+  printf("                               honour MONKEYC_JIT=0 instead)\n\n");
+
   printf("BUILD OPTIONS:\n");
   printf("  -o <output>                  Specify output filename\n");
-  printf("                               (default: input filename without extension)\n\n");
+  printf("                               (default: input filename without extension)\n");
+  printf("  --snapshot                   Run the leading top-level `let` statements at\n");
+  printf("                               build time and embed the resulting globals\n");
+  printf("                               (up to the first one that calls a function)\n");
+  printf("  --aot                        Translate the bytecode to C and compile it to a\n");
+  printf("                               native binary (compiler: $MONKEYC_CC, default clang)\n\n");
 
   printf("EXAMPLES:\n");
   printf("  %s                           # Start REPL\n", program_name);
   printf("  %s hello.mon                 # Run hello.mon\n", program_name);
   printf("  %s build hello.mon           # Compile to 'hello'\n", program_name);
   printf("  %s build hello.mon -o app    # Compile to 'app'\n", program_name);
+  printf("  %s build hello.mon --snapshot # Compile with pre-initialized globals\n", program_name);
+  printf("  %s build hello.mon --aot     # Compile to native code\n", program_name);
 }
 
 // --- Print version information ---
@@ -462,6 +745,23 @@ ParsedArgs parseArgs(int argc, char **argv) {
     return args;
   }
 
+  if (argc >= 3 && strcmp(argv[1], "build") != 0) {
+    args.type = CMD_RUN;
+    args.input_file = argv[1];
+
+    // Parse run options
+    for (int i = 2; i < argc; i++) {
+      if (strcmp(argv[i], "--no-jit") == 0) {
+        args.noJit = true;
+      } else {
+        args.type = CMD_INVALID;
+        args.error_message = "Error: Unknown run option";
+        return args;
+      }
+    }
+    return args;
+  }
+
   if (argc >= 3 && strcmp(argv[1], "build") == 0) {
     args.type = CMD_BUILD;
     args.input_file = argv[2];
@@ -470,13 +770,17 @@ ParsedArgs parseArgs(int argc, char **argv) {
     for (int i = 3; i < argc; i++) {
       if (strcmp(argv[i], "-o") == 0) {
         if (i + 1 < argc) {
-          args.output_file = argv[i + 1];
+          args.output_file = strdup(argv[i + 1]);
           i++; // Skip the next argument
         } else {
           args.type = CMD_INVALID;
           args.error_message = "Error: -o option requires an output filename";
           return args;
         }
+      } else if (strcmp(argv[i], "--snapshot") == 0) {
+        args.snapshot = true;
+      } else if (strcmp(argv[i], "--aot") == 0) {
+        args.aot = true;
       } else {
         args.type = CMD_INVALID;
         args.error_message = "Error: Unknown build option";
@@ -534,15 +838,19 @@ int main(int argc, char **argv) {
         return 1;
       }
 
-      char *input = readFile(args.input_file);
-      if (!input) {
+      SourceText source;
+      if (!openSource(args.input_file, &source)) {
         fprintf(stderr, "Error: Failed to read file '%s'\n", args.input_file);
         return 1;
       }
 
+      if (args.noJit) {
+        jitSetEnabled(false);
+      }
+
       printf("Running '%s'...\n", args.input_file);
-      runSource(input);
-      free(input);
+      runSource(source.data, source.length);
+      closeSource(&source);
       break;
     }
 
@@ -555,7 +863,7 @@ int main(int argc, char **argv) {
       }
 
       printf("Building '%s' -> '%s'...\n", args.input_file, args.output_file);
-      buildExecutable(args.input_file, args.output_file);
+      buildExecutable(args.input_file, args.output_file, args.snapshot, args.aot);
       printf("✅ Build completed successfully!\n");
 
       if (args.output_file && args.output_file != args.input_file) {
@@ -0,0 +1,198 @@
+#include "ints.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__))
+#define INTS_X86 1
+#include <immintrin.h>
+#endif
+
+typedef struct {
+  int64_t (*sum)(const int64_t *values, int count);
+  int64_t (*min)(const int64_t *values, int count);
+  int64_t (*max)(const int64_t *values, int count);
+  int64_t (*dot)(const int64_t *a, const int64_t *b, int count);
+} Reducers;
+
+// ===== SCALAR =====
+// sums and products go through uint64_t so wrapping around is defined
+
+static int64_t scalarSum(const int64_t *values, int count) {
+  uint64_t sum = 0;
+  for (int i = 0; i < count; i++) {
+    sum += (uint64_t)values[i];
+  }
+  return (int64_t)sum;
+}
+
+static int64_t scalarMin(const int64_t *values, int count) {
+  int64_t min = values[0];
+  for (int i = 1; i < count; i++) {
+    min = values[i] < min ? values[i] : min;
+  }
+  return min;
+}
+
+static int64_t scalarMax(const int64_t *values, int count) {
+  int64_t max = values[0];
+  for (int i = 1; i < count; i++) {
+    max = values[i] > max ? values[i] : max;
+  }
+  return max;
+}
+
+static int64_t scalarDot(const int64_t *a, const int64_t *b, int count) {
+  uint64_t sum = 0;
+  for (int i = 0; i < count; i++) {
+    sum += (uint64_t)a[i] * (uint64_t)b[i];
+  }
+  return (int64_t)sum;
+}
+
+static const Reducers scalarReducers = {scalarSum, scalarMin, scalarMax,
+                                        scalarDot};
+
+#ifdef INTS_X86
+
+// ===== AVX2 =====
+// four lanes of 64 bits, two vectors per step so consecutive adds do not
+// wait on each other. leftovers past the last full step go through the
+// scalar loops
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static int64_t addLanes(__m256i x) {
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, x);
+  return (int64_t)((uint64_t)lanes[0] + (uint64_t)lanes[1] +
+                   (uint64_t)lanes[2] + (uint64_t)lanes[3]);
+}
+
+AVX2 static int64_t avx2Sum(const int64_t *values, int count) {
+  __m256i a = _mm256_setzero_si256();
+  __m256i b = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    a = _mm256_add_epi64(a, _mm256_loadu_si256((const __m256i *)(values + i)));
+    b = _mm256_add_epi64(b,
+                         _mm256_loadu_si256((const __m256i *)(values + i + 4)));
+  }
+  uint64_t rest = (uint64_t)scalarSum(values + i, count - i);
+  return (int64_t)((uint64_t)addLanes(_mm256_add_epi64(a, b)) + rest);
+}
+
+// there is no 64-bit min or max before avx-512, so compare and blend
+AVX2 static __m256i min64(__m256i a, __m256i b) {
+  return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+AVX2 static __m256i max64(__m256i a, __m256i b) {
+  return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+#define AVX2_EXTREME(name, pick, scalar)                                       \
+  AVX2 static int64_t name(const int64_t *values, int count) {                 \
+    if (count < 8) {                                                           \
+      return scalar(values, count);                                            \
+    }                                                                          \
+    __m256i a = _mm256_loadu_si256((const __m256i *)values);                   \
+    __m256i b = _mm256_loadu_si256((const __m256i *)(values + 4));             \
+    int i = 8;                                                                 \
+    for (; i + 8 <= count; i += 8) {                                           \
+      a = pick(a, _mm256_loadu_si256((const __m256i *)(values + i)));          \
+      b = pick(b, _mm256_loadu_si256((const __m256i *)(values + i + 4)));      \
+    }                                                                          \
+    int64_t lanes[4];                                                          \
+    _mm256_storeu_si256((__m256i *)lanes, pick(a, b));                         \
+    int64_t result = scalar(lanes, 4);                                         \
+    if (i < count) {                                                           \
+      lanes[0] = result;                                                       \
+      lanes[1] = scalar(values + i, count - i);                                \
+      result = scalar(lanes, 2);                                               \
+    }                                                                          \
+    return result;                                                             \
+  }
+
+AVX2_EXTREME(avx2Min, min64, scalarMin)
+AVX2_EXTREME(avx2Max, max64, scalarMax)
+
+// the low 64 bits of each product, from 32-bit multiplies: the high halves
+// only reach the low 64 bits through the two cross terms
+AVX2 static __m256i mullo64(__m256i a, __m256i b) {
+  __m256i low = _mm256_mul_epu32(a, b);
+  __m256i cross =
+      _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                       _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+  return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+}
+
+AVX2 static int64_t avx2Dot(const int64_t *a, const int64_t *b, int count) {
+  __m256i even = _mm256_setzero_si256();
+  __m256i odd = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    even = _mm256_add_epi64(
+        even, mullo64(_mm256_loadu_si256((const __m256i *)(a + i)),
+                      _mm256_loadu_si256((const __m256i *)(b + i))));
+    odd = _mm256_add_epi64(
+        odd, mullo64(_mm256_loadu_si256((const __m256i *)(a + i + 4)),
+                     _mm256_loadu_si256((const __m256i *)(b + i + 4))));
+  }
+  uint64_t rest = (uint64_t)scalarDot(a + i, b + i, count - i);
+  return (int64_t)((uint64_t)addLanes(_mm256_add_epi64(even, odd)) + rest);
+}
+
+static const Reducers avx2Reducers = {avx2Sum, avx2Min, avx2Max, avx2Dot};
+
+#endif
+
+// ===== DISPATCH =====
+
+static const Reducers *active = NULL;
+static IntsLevel activeLevel = INTS_SCALAR;
+
+IntsLevel intsSetLevel(IntsLevel level) {
+#ifdef INTS_X86
+  __builtin_cpu_init();
+  if (level == INTS_AVX2 && __builtin_cpu_supports("avx2")) {
+    activeLevel = INTS_AVX2;
+    active = &avx2Reducers;
+    return activeLevel;
+  }
+#endif
+  activeLevel = INTS_SCALAR;
+  active = &scalarReducers;
+  return activeLevel;
+}
+
+static const Reducers *reducers() {
+  if (!active) {
+    char *value = getenv("MONKEYC_SIMD");
+    int scalar = value && (strcmp(value, "scalar") == 0 ||
+                           strcmp(value, "sse2") == 0);
+    intsSetLevel(scalar ? INTS_SCALAR : INTS_AVX2);
+  }
+  return active;
+}
+
+IntsLevel intsGetLevel() {
+  reducers();
+  return activeLevel;
+}
+
+int64_t intsSum(const int64_t *values, int count) {
+  return reducers()->sum(values, count);
+}
+
+int64_t intsMin(const int64_t *values, int count) {
+  return reducers()->min(values, count);
+}
+
+int64_t intsMax(const int64_t *values, int count) {
+  return reducers()->max(values, count);
+}
+
+int64_t intsDot(const int64_t *a, const int64_t *b, int count) {
+  return reducers()->dot(a, b, count);
+}
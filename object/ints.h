@@ -0,0 +1,25 @@
+#ifndef INTS_H
+#define INTS_H
+
+#include <stdint.h>
+
+// reductions over packed integer arrays, for the sum, min, max and dot
+// builtins. arithmetic wraps around on overflow, as the vm's does.
+//
+// the implementation is picked once at runtime: avx2 when the cpu has it,
+// plain c otherwise. MONKEYC_SIMD=scalar (or sse2, which has no 64-bit
+// compares to offer here) keeps it on plain c
+typedef enum { INTS_SCALAR, INTS_AVX2 } IntsLevel;
+
+int64_t intsSum(const int64_t *values, int count);
+// count must be at least 1
+int64_t intsMin(const int64_t *values, int count);
+int64_t intsMax(const int64_t *values, int count);
+int64_t intsDot(const int64_t *a, const int64_t *b, int count);
+
+// selects the implementation; avx2 falls back to plain c when the cpu
+// lacks it. returns the level now in use
+IntsLevel intsSetLevel(IntsLevel level);
+IntsLevel intsGetLevel();
+
+#endif
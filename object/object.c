@@ -1,9 +1,15 @@
 #include "object.h"
+#include "ints.h"
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define HASH_SSE2 1
+#include <emmintrin.h>
+#endif
+
 // === Environment Implementation ===
 // environments use linear search for simplicity - good for small scopes
 
@@ -73,12 +79,17 @@ char *inspect(Object *obj) {
   } else if (strcmp(obj->type, NullObj) == 0) {
     snprintf(buf, sizeof(buf), "null");
   } else if (strcmp(obj->type, StringObj) == 0) {
-    snprintf(buf, sizeof(buf), "%s", obj->string->value);
+    // whole, however long
+    char *copy = malloc(obj->string->length + 1);
+    memcpy(copy, stringValue(obj->string), obj->string->length + 1);
+    return copy;
   } else if (strcmp(obj->type, ArrayObj) == 0) {
     // Build a simple comma-separated list of element representations.
     strcpy(buf, "[");
     for (int i = 0; i < obj->array->count; i++) {
-      char *elemRepr = inspect(&obj->array->elements[i]);
+      Integer box;
+      Object element = arrayGetValue(obj->array, i, &box);
+      char *elemRepr = inspect(&element);
       strncat(buf, elemRepr, sizeof(buf) - strlen(buf) - 1);
       free(elemRepr);
       if (i < obj->array->count - 1) {
@@ -124,7 +135,7 @@ Object *builtin_len(Object **args, int argCount) {
     Object *rv = malloc(sizeof(Object));
     rv->type = IntegerObj;
     rv->integer = malloc(sizeof(Integer));
-    rv->integer->value = strlen(args[0]->string->value);
+    rv->integer->value = args[0]->string->length;
     return rv;
   }
   if (strcmp(args[0]->type, ArrayObj) == 0) {
@@ -134,15 +145,33 @@ Object *builtin_len(Object **args, int argCount) {
     rv->integer->value = args[0]->array->count;
     return rv;
   }
+  if (strcmp(args[0]->type, HashObj) == 0) {
+    Object *rv = malloc(sizeof(Object));
+    rv->type = IntegerObj;
+    rv->integer = malloc(sizeof(Integer));
+    rv->integer->value = args[0]->hash->size;
+    return rv;
+  }
   return newError("argument to `len` not supported");
 }
 
+// the element as a builtin's result: its own slot, or for a packed array a
+// new Integer, as any builtin returning a number makes
+static Object *elementResult(Array *array, int index) {
+  if (!array->packed) {
+    return arrayGet(array, index);
+  }
+  Object *rv = malloc(sizeof(Object));
+  *rv = arrayGetValue(array, index, malloc(sizeof(Integer)));
+  return rv;
+}
+
 Object *builtin_first(Object **args, int argCount) {
   if (argCount != 1 || strcmp(args[0]->type, ArrayObj) != 0) {
     return newError("wrong arguments to `first`");
   }
   if (args[0]->array->count > 0) {
-    return &args[0]->array->elements[0];
+    return elementResult(args[0]->array, 0);
   }
   Object *nullObj = malloc(sizeof(Object));
   nullObj->type = NullObj;
@@ -156,7 +185,7 @@ Object *builtin_last(Object **args, int argCount) {
   }
   int cnt = args[0]->array->count;
   if (cnt > 0) {
-    return &args[0]->array->elements[cnt - 1];
+    return elementResult(args[0]->array, cnt - 1);
   }
   Object *nullObj = malloc(sizeof(Object));
   nullObj->type = NullObj;
@@ -177,11 +206,7 @@ Object *builtin_rest(Object **args, int argCount) {
   }
   Object *newArr = malloc(sizeof(Object));
   newArr->type = ArrayObj;
-  newArr->array = malloc(sizeof(Array));
-  newArr->array->count = cnt - 1;
-  newArr->array->elements = malloc(sizeof(Object) * (cnt - 1));
-  memcpy(newArr->array->elements, &args[0]->array->elements[1],
-         sizeof(Object) * (cnt - 1));
+  newArr->array = arrayRest(args[0]->array, 1);
   return newArr;
 }
 
@@ -189,15 +214,9 @@ Object *builtin_push(Object **args, int argCount) {
   if (argCount != 2 || strcmp(args[0]->type, ArrayObj) != 0) {
     return newError("wrong arguments to `push`");
   }
-  int cnt = args[0]->array->count;
   Object *newArr = malloc(sizeof(Object));
   newArr->type = ArrayObj;
-  newArr->array = malloc(sizeof(Array));
-  newArr->array->count = cnt + 1;
-  newArr->array->elements = malloc(sizeof(Object) * (cnt + 1));
-  memcpy(newArr->array->elements, &args[0]->array->elements[0],
-         sizeof(Object) * cnt);
-  newArr->array->elements[cnt] = *args[1];
+  newArr->array = arrayPush(args[0]->array, args[1]);
   return newArr;
 }
 
@@ -213,6 +232,99 @@ Object *builtin_puts(Object **args, int argCount) {
   return nullObj;
 }
 
+Object *builtin_set(Object **args, int argCount) {
+  if (argCount != 3 || strcmp(args[0]->type, HashObj) != 0) {
+    return newError("wrong arguments to `set`");
+  }
+  if (!isHashable(args[1])) {
+    return newError("unusable as hash key");
+  }
+  Object *rv = malloc(sizeof(Object));
+  rv->type = HashObj;
+  rv->hash = hashWith(args[0]->hash, args[1], args[2]);
+  return rv;
+}
+
+Object *builtin_delete(Object **args, int argCount) {
+  if (argCount != 2 || strcmp(args[0]->type, HashObj) != 0) {
+    return newError("wrong arguments to `delete`");
+  }
+  if (!isHashable(args[1])) {
+    return newError("unusable as hash key");
+  }
+  Object *rv = malloc(sizeof(Object));
+  rv->type = HashObj;
+  rv->hash = hashWithout(args[0]->hash, args[1]);
+  return rv;
+}
+
+// the values of an array of integers: a packed array's own, or for any
+// other array a copy left in *owned for the caller to free. NULL when an
+// element is not an integer
+static int64_t *arrayInts(Array *array, int64_t **owned);
+
+// sum, min and max of one array of integers; min and max of none are null
+static Object *reduceInts(Object **args, int argCount, char *error,
+                          int64_t (*reduce)(const int64_t *, int)) {
+  if (argCount != 1 || strcmp(args[0]->type, ArrayObj) != 0) {
+    return newError(error);
+  }
+  int64_t *owned = NULL;
+  int64_t *values = arrayInts(args[0]->array, &owned);
+  if (!values) {
+    return newError(error);
+  }
+
+  Object *rv = malloc(sizeof(Object));
+  int count = args[0]->array->count;
+  if (count == 0 && reduce != intsSum) {
+    rv->type = NullObj;
+    rv->null = malloc(sizeof(Null));
+  } else {
+    rv->type = IntegerObj;
+    rv->integer = malloc(sizeof(Integer));
+    rv->integer->value = reduce(values, count);
+  }
+  free(owned);
+  return rv;
+}
+
+Object *builtin_sum(Object **args, int argCount) {
+  return reduceInts(args, argCount, "wrong arguments to `sum`", intsSum);
+}
+
+Object *builtin_min(Object **args, int argCount) {
+  return reduceInts(args, argCount, "wrong arguments to `min`", intsMin);
+}
+
+Object *builtin_max(Object **args, int argCount) {
+  return reduceInts(args, argCount, "wrong arguments to `max`", intsMax);
+}
+
+Object *builtin_dot(Object **args, int argCount) {
+  if (argCount != 2 || strcmp(args[0]->type, ArrayObj) != 0 ||
+      strcmp(args[1]->type, ArrayObj) != 0 ||
+      args[0]->array->count != args[1]->array->count) {
+    return newError("wrong arguments to `dot`");
+  }
+  int64_t *ownedA = NULL;
+  int64_t *ownedB = NULL;
+  int64_t *a = arrayInts(args[0]->array, &ownedA);
+  int64_t *b = arrayInts(args[1]->array, &ownedB);
+  Object *rv;
+  if (a && b) {
+    rv = malloc(sizeof(Object));
+    rv->type = IntegerObj;
+    rv->integer = malloc(sizeof(Integer));
+    rv->integer->value = intsDot(a, b, args[0]->array->count);
+  } else {
+    rv = newError("wrong arguments to `dot`");
+  }
+  free(ownedA);
+  free(ownedB);
+  return rv;
+}
+
 // builtin function registry - maps names to function pointers
 BuiltinEntry builtins[] = {
     {BuiltinFuncNameLen, &(Builtin){.function = builtin_len}},
@@ -221,6 +333,12 @@ BuiltinEntry builtins[] = {
     {BuiltinFuncNameRest, &(Builtin){.function = builtin_rest}},
     {BuiltinFuncNamePush, &(Builtin){.function = builtin_push}},
     {BuiltinFuncNamePuts, &(Builtin){.function = builtin_puts}},
+    {BuiltinFuncNameSet, &(Builtin){.function = builtin_set}},
+    {BuiltinFuncNameDelete, &(Builtin){.function = builtin_delete}},
+    {BuiltinFuncNameSum, &(Builtin){.function = builtin_sum}},
+    {BuiltinFuncNameMin, &(Builtin){.function = builtin_min}},
+    {BuiltinFuncNameMax, &(Builtin){.function = builtin_max}},
+    {BuiltinFuncNameDot, &(Builtin){.function = builtin_dot}},
 };
 
 const int builtinsCount = sizeof(builtins) / sizeof(BuiltinEntry);
@@ -234,15 +352,153 @@ Builtin *getBuiltinByName(char *name) {
   return NULL;
 }
 
-uint64_t fnv1aHash(const char *str) {
+uint64_t fnv1aHash(const char *str, int length) {
   uint64_t hash = 14695981039346656037ULL;
-  while (*str) {
-    hash ^= (unsigned char)(*str++);
+  for (int i = 0; i < length; i++) {
+    hash ^= (unsigned char)str[i];
     hash *= 1099511628211ULL;
   }
   return hash;
 }
 
+// takes ownership of value, which holds length bytes plus a nul
+String *newString(char *value, int length) {
+  String *string = malloc(sizeof(String));
+  string->value = value;
+  string->length = length;
+  string->hash = 0;
+  string->hashed = false;
+  string->left = NULL;
+  string->right = NULL;
+  return string;
+}
+
+// ===== ROPES =====
+// concatenating into a fresh buffer copies the left operand every time, so
+// building a string with repeated + is quadratic. results longer than
+// ROPE_MIN_LENGTH are rope nodes instead, and short pieces added to either
+// end of a rope are merged into its outer leaf so leaves stay that long
+
+#define ROPE_MIN_LENGTH 64
+
+static String *newRope(String *left, String *right) {
+  String *rope = newString(NULL, left->length + right->length);
+  rope->left = left;
+  rope->right = right;
+  return rope;
+}
+
+String *concatStrings(String *left, String *right) {
+  int length = left->length + right->length;
+  if (left->length == 0) {
+    return right;
+  }
+  if (right->length == 0) {
+    return left;
+  }
+
+  if (length <= ROPE_MIN_LENGTH) {
+    char *value = malloc(length + 1);
+    memcpy(value, stringValue(left), left->length);
+    memcpy(value + left->length, stringValue(right), right->length);
+    value[length] = '\0';
+    return newString(value, length);
+  }
+
+  if (!left->value && left->right->value &&
+      left->right->length + right->length <= ROPE_MIN_LENGTH) {
+    return newRope(left->left, concatStrings(left->right, right));
+  }
+  if (!right->value && right->left->value &&
+      left->length + right->left->length <= ROPE_MIN_LENGTH) {
+    return newRope(concatStrings(left, right->left), right->right);
+  }
+  return newRope(left, right);
+}
+
+typedef struct {
+  String *node;
+  int offset;
+} RopeSpan;
+
+// copies every leaf to its offset in one buffer. ropes built by appending
+// are as deep as they are long, so the walk is a loop that follows one
+// child and only keeps the other on a stack when both are unflattened
+static void flattenRope(String *rope) {
+  char *buffer = malloc(rope->length + 1);
+  RopeSpan *pending = NULL;
+  int pendingCount = 0;
+  int pendingCapacity = 0;
+
+  String *node = rope;
+  int offset = 0;
+  for (;;) {
+    if (node->value) {
+      memcpy(buffer + offset, node->value, node->length);
+      if (pendingCount == 0) {
+        break;
+      }
+      pendingCount--;
+      node = pending[pendingCount].node;
+      offset = pending[pendingCount].offset;
+      continue;
+    }
+
+    String *left = node->left;
+    String *right = node->right;
+    int rightOffset = offset + left->length;
+    if (left->value) {
+      memcpy(buffer + offset, left->value, left->length);
+      node = right;
+      offset = rightOffset;
+      continue;
+    }
+    if (right->value) {
+      memcpy(buffer + rightOffset, right->value, right->length);
+    } else {
+      if (pendingCount == pendingCapacity) {
+        pendingCapacity = pendingCapacity ? pendingCapacity * 2 : 16;
+        pending = realloc(pending, sizeof(RopeSpan) * pendingCapacity);
+      }
+      pending[pendingCount++] = (RopeSpan){right, rightOffset};
+    }
+    node = left;
+  }
+  free(pending);
+
+  buffer[rope->length] = '\0';
+  rope->value = buffer;
+  rope->left = NULL;
+  rope->right = NULL;
+}
+
+char *stringValue(String *string) {
+  if (!string->value) {
+    flattenRope(string);
+  }
+  return string->value;
+}
+
+uint64_t stringHash(String *string) {
+  if (!string->hashed) {
+    string->hash = fnv1aHash(stringValue(string), string->length);
+    string->hashed = true;
+  }
+  return string->hash;
+}
+
+// lengths first, then cached hashes when both are known, and only then
+// the bytes
+bool stringsEqual(String *a, String *b) {
+  if (a->length != b->length) {
+    return false;
+  }
+  if (a->hashed && b->hashed && a->hash != b->hash) {
+    return false;
+  }
+  return memcmp(stringValue(a), stringValue(b), a->length) == 0;
+}
+
 HashKey getHashKey(Object *object) {
   HashKey key;
   key.type = object->type;
@@ -252,7 +508,7 @@ HashKey getHashKey(Object *object) {
   } else if (strcmp(object->type, BooleanObj) == 0) {
     key.value = object->boolean->value ? 1 : 0;
   } else if (strcmp(object->type, StringObj) == 0) {
-    key.value = fnv1aHash(object->string->value);
+    key.value = stringHash(object->string);
   } else {
     fprintf(stderr, "Unhashable type: %s\n", object->type);
     exit(1);
@@ -261,33 +517,82 @@ HashKey getHashKey(Object *object) {
   return key;
 }
 
-// hash table implementation with O(1) average lookup
-#define INITIAL_BUCKET_COUNT 16
-#define LOAD_FACTOR_THRESHOLD 0.75
+// ===== HASH TABLE =====
+// see struct Hash. there is no removal, so entries never has holes and a
+// probe can stop at the first group with an empty slot: a pair is always
+// indexed from the first empty slot its probe sequence reaches
+
+#define HASH_GROUP 16
+#define HASH_INITIAL_SLOTS 16
+#define HASH_EMPTY 0x80 // control byte of an empty slot; full ones are 0-127
+
+// bit i set when control byte i of the group at control equals byte
+static unsigned groupMatch(const uint8_t *control, uint8_t byte) {
+#ifdef HASH_SSE2
+  __m128i group = _mm_loadu_si128((const __m128i *)control);
+  return (unsigned)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte)));
+#else
+  unsigned mask = 0;
+  for (int i = 0; i < HASH_GROUP; i++) {
+    mask |= (unsigned)(control[i] == byte) << i;
+  }
+  return mask;
+#endif
+}
+
+static int lowestBit(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(mask);
+#else
+  int bit = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+// integer keys are their own HashKey value, so spread their bits before
+// taking 7 of them for the control byte and the rest for the group
+static uint64_t mixHash(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// a fresh, empty index; entries is sized by the caller
+static void allocSlots(Hash *hash, int slotCount) {
+  hash->slotCount = slotCount;
+  hash->capacity = slotCount - slotCount / 8; // grow at 7/8 full
+  hash->control = malloc(slotCount);
+  memset(hash->control, HASH_EMPTY, slotCount);
+  hash->index = malloc(sizeof(int32_t) * slotCount);
+}
 
 // create new hash table
 Hash *newHash() {
   Hash *hash = malloc(sizeof(Hash));
-  hash->bucketCount = INITIAL_BUCKET_COUNT;
   hash->size = 0;
-  hash->capacity = (int)(INITIAL_BUCKET_COUNT * LOAD_FACTOR_THRESHOLD);
-  hash->buckets = calloc(hash->bucketCount, sizeof(HashEntry*));
+  allocSlots(hash, HASH_INITIAL_SLOTS);
+  hash->entries = malloc(sizeof(HashEntry) * hash->capacity);
+  hash->shape = NULL;
+  hash->trie = NULL;
   return hash;
 }
 
-// free hash table and all entries
+// free hash table and all entries. trie nodes may be shared with other
+// hashes and are left alone
 void freeHash(Hash *hash) {
   if (!hash) return;
 
-  for (int i = 0; i < hash->bucketCount; i++) {
-    HashEntry *entry = hash->buckets[i];
-    while (entry) {
-      HashEntry *next = entry->next;
-      free(entry);
-      entry = next;
-    }
-  }
-  free(hash->buckets);
+  free(hash->control);
+  free(hash->index);
+  free(hash->entries);
   free(hash);
 }
 
@@ -302,83 +607,658 @@ int hashKeysEqual(Object *key1, Object *key2) {
   } else if (strcmp(key1->type, BooleanObj) == 0) {
     return key1->boolean->value == key2->boolean->value;
   } else if (strcmp(key1->type, StringObj) == 0) {
-    return strcmp(key1->string->value, key2->string->value) == 0;
+    return stringsEqual(key1->string, key2->string);
   }
 
   return 0;
 }
 
-// resize hash table when load factor exceeds threshold
-void hashResize(Hash *hash) {
-  int oldBucketCount = hash->bucketCount;
-  HashEntry **oldBuckets = hash->buckets;
-
-  // double the bucket count
-  hash->bucketCount *= 2;
-  hash->capacity = (int)(hash->bucketCount * LOAD_FACTOR_THRESHOLD);
-  hash->buckets = calloc(hash->bucketCount, sizeof(HashEntry*));
-  hash->size = 0;
+// whether entry holds key, whose hash is h. integer and boolean keys are
+// their own HashKey value and mixHash is a bijection, so for them equal
+// hashes and types are enough and the key's payload is never loaded
+static bool entryHasKey(HashEntry *entry, Object *key, uint64_t h) {
+  if (entry->hash != h || strcmp(entry->key.type, key->type) != 0) {
+    return false;
+  }
+  return strcmp(key->type, StringObj) != 0 ||
+         stringsEqual(entry->key.string, key->string);
+}
 
-  // rehash all existing entries
-  for (int i = 0; i < oldBucketCount; i++) {
-    HashEntry *entry = oldBuckets[i];
-    while (entry) {
-      HashEntry *next = entry->next;
-      hashSet(hash, &entry->key, &entry->value);
-      free(entry);
-      entry = next;
+// the slot holding key, whose hash is h, with *found set; when the key is
+// missing (or NULL), the empty slot it would go in. groups are visited in triangular
+// steps, which reaches every group of a power of 2 table
+static int findSlot(Hash *hash, Object *key, uint64_t h, bool *found) {
+  size_t groupMask = hash->slotCount / HASH_GROUP - 1;
+  size_t group = (h >> 7) & groupMask;
+  uint8_t tag = h & 0x7f;
+  for (size_t step = 1;; step++) {
+    const uint8_t *control = hash->control + group * HASH_GROUP;
+    unsigned match = key ? groupMatch(control, tag) : 0;
+    for (; match; match &= match - 1) {
+      int slot = group * HASH_GROUP + lowestBit(match);
+      if (entryHasKey(&hash->entries[hash->index[slot]], key, h)) {
+        *found = true;
+        return slot;
+      }
+    }
+    unsigned empty = groupMatch(control, HASH_EMPTY);
+    if (empty) {
+      *found = false;
+      return group * HASH_GROUP + lowestBit(empty);
     }
+    group = (group + step) & groupMask;
   }
+}
+
+// points slot at entries[position], whose hash is h
+static void indexEntry(Hash *hash, int slot, int position, uint64_t h) {
+  hash->control[slot] = h & 0x7f;
+  hash->index[slot] = position;
+}
+
+// doubles the slots and rebuilds the index from the stored hashes. the
+// pairs keep their positions, so entries only has to grow in place
+static void growHash(Hash *hash) {
+  free(hash->control);
+  free(hash->index);
+  allocSlots(hash, hash->slotCount * 2);
+  hash->entries = realloc(hash->entries, sizeof(HashEntry) * hash->capacity);
 
-  free(oldBuckets);
+  for (int i = 0; i < hash->size; i++) {
+    // the keys are known to be distinct, so only look for a free slot
+    bool found;
+    int slot = findSlot(hash, NULL, hash->entries[i].hash, &found);
+    indexEntry(hash, slot, i, hash->entries[i].hash);
+  }
 }
 
 // set key-value pair in hash table
 int hashSet(Hash *hash, Object *key, Object *value) {
+  uint64_t h = mixHash(getHashKey(key).value);
+
+  bool found;
+  int slot = findSlot(hash, key, h, &found);
+  if (found) {
+    hash->entries[hash->index[slot]].value = *value; // update existing value
+    return 0;
+  }
+
   if (hash->size >= hash->capacity) {
-    hashResize(hash);
+    growHash(hash);
+    slot = findSlot(hash, NULL, h, &found);
   }
+  hash->entries[hash->size] = (HashEntry){*key, *value, h};
+  indexEntry(hash, slot, hash->size, h);
+  hash->size++;
+  return 0;
+}
 
-  HashKey hashKey = getHashKey(key);
-  int bucketIndex = hashKey.value & (hash->bucketCount - 1);  // fast modulo for power of 2
+static HashEntry *trieGet(HashTrie *node, Object *key, uint64_t h);
+
+// get value from hash table
+Object *hashGet(Hash *hash, Object *key) {
+  if (!hash->control) {
+    HashEntry *entry = trieGet(hash->trie, key, mixHash(getHashKey(key).value));
+    return entry ? &entry->value : NULL;
+  }
+  int position = hashFind(hash, key);
+  return position >= 0 ? &hash->entries[position].value : NULL;
+}
+
+int hashFind(Hash *hash, Object *key) {
+  bool found;
+  int slot = findSlot(hash, key, mixHash(getHashKey(key).value), &found);
+  return found ? hash->index[slot] : -1;
+}
+
+// the index and the pairs are copied as they are, so nothing is hashed
+Hash *newHashWithShape(Hash *shape) {
+  Hash *hash = malloc(sizeof(Hash));
+  hash->slotCount = shape->slotCount;
+  hash->size = shape->size;
+  hash->capacity = shape->capacity;
+  hash->control = malloc(shape->slotCount);
+  memcpy(hash->control, shape->control, shape->slotCount);
+  hash->index = malloc(sizeof(int32_t) * shape->slotCount);
+  memcpy(hash->index, shape->index, sizeof(int32_t) * shape->slotCount);
+  hash->entries = malloc(sizeof(HashEntry) * shape->capacity);
+  memcpy(hash->entries, shape->entries, sizeof(HashEntry) * shape->size);
+  hash->shape = shape;
+  hash->trie = NULL;
+  return hash;
+}
+
+static void flattenTrie(HashTrie *node, HashEntry *out, int *count);
+
+HashEntry *hashNext(Hash *hash, int *cursor) {
+  if (*cursor >= hash->size) {
+    return NULL;
+  }
+  if (!hash->entries) {
+    // a trie hash being iterated for the first time; it never changes, so
+    // its pairs are laid out once
+    int count = 0;
+    hash->entries = malloc(sizeof(HashEntry) * hash->size);
+    flattenTrie(hash->trie, hash->entries, &count);
+  }
+  return &hash->entries[(*cursor)++];
+}
 
-  HashEntry *entry = hash->buckets[bucketIndex];
+// ===== PERSISTENT HASH =====
+// a hash array mapped trie: each level covers 5 more bits of a key's hash,
+// with one bitmap for the positions holding a pair and one for those
+// holding a subtrie. an update copies only the nodes on the way to its key,
+// so the new hash shares everything else with the old one. pairs whose
+// whole 64-bit hashes are equal meet in a collision node at the bottom.
+// every subtrie holds at least two pairs, so a delete that leaves one pair
+// in a subtrie moves it up into the parent
 
-  // check if key already exists
-  while (entry) {
-    if (hashKeysEqual(&entry->key, key)) {
-      entry->value = *value;  // update existing value
-      return 0;
+#define TRIE_BITS 5
+#define TRIE_MASK 31
+#define TRIE_MAX_SHIFT 64 // collision nodes live at this shift
+
+struct HashTrie {
+  uint32_t entryMap;   // positions holding a pair; 0 in collision nodes
+  uint32_t childMap;   // positions holding a subtrie
+  int entryCount;
+  int childCount;
+  HashEntry *entries;  // in position order, allocated with the node
+  HashTrie **children; // in position order, allocated with the node
+};
+
+static int bitCount(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcount(mask);
+#else
+  int count = 0;
+  for (; mask; mask &= mask - 1) {
+    count++;
+  }
+  return count;
+#endif
+}
+
+static uint32_t trieBit(uint64_t h, int shift) {
+  return 1u << ((h >> shift) & TRIE_MASK);
+}
+
+static HashTrie *newTrie(int entryCount, int childCount) {
+  HashTrie *node = malloc(sizeof(HashTrie) + sizeof(HashEntry) * entryCount +
+                          sizeof(HashTrie *) * childCount);
+  node->entryMap = 0;
+  node->childMap = 0;
+  node->entryCount = entryCount;
+  node->childCount = childCount;
+  node->entries = (HashEntry *)(node + 1);
+  node->children = (HashTrie **)(node->entries + entryCount);
+  return node;
+}
+
+// a copy of node whose position bit holds entry, child or, with both NULL,
+// nothing
+static HashTrie *editTrie(HashTrie *node, uint32_t bit, HashEntry *entry,
+                          HashTrie *child) {
+  uint32_t entryMap = (node->entryMap & ~bit) | (entry ? bit : 0);
+  uint32_t childMap = (node->childMap & ~bit) | (child ? bit : 0);
+  HashTrie *copy = newTrie(bitCount(entryMap), bitCount(childMap));
+  copy->entryMap = entryMap;
+  copy->childMap = childMap;
+
+  int count = 0;
+  for (uint32_t map = entryMap; map; map &= map - 1) {
+    uint32_t at = map & -map;
+    copy->entries[count++] =
+        at == bit ? *entry
+                  : node->entries[bitCount(node->entryMap & (at - 1))];
+  }
+  count = 0;
+  for (uint32_t map = childMap; map; map &= map - 1) {
+    uint32_t at = map & -map;
+    copy->children[count++] =
+        at == bit ? child
+                  : node->children[bitCount(node->childMap & (at - 1))];
+  }
+  return copy;
+}
+
+// the subtrie at shift holding just a and b
+static HashTrie *trieOfPair(HashEntry *a, HashEntry *b, int shift) {
+  if (shift >= TRIE_MAX_SHIFT) {
+    HashTrie *node = newTrie(2, 0);
+    node->entries[0] = *a;
+    node->entries[1] = *b;
+    return node;
+  }
+
+  uint32_t bitA = trieBit(a->hash, shift);
+  uint32_t bitB = trieBit(b->hash, shift);
+  if (bitA == bitB) {
+    HashTrie *node = newTrie(0, 1);
+    node->childMap = bitA;
+    node->children[0] = trieOfPair(a, b, shift + TRIE_BITS);
+    return node;
+  }
+  HashTrie *node = newTrie(2, 0);
+  node->entryMap = bitA | bitB;
+  node->entries[bitA < bitB ? 0 : 1] = *a;
+  node->entries[bitA < bitB ? 1 : 0] = *b;
+  return node;
+}
+
+static HashEntry *trieGet(HashTrie *node, Object *key, uint64_t h) {
+  for (int shift = 0; shift < TRIE_MAX_SHIFT; shift += TRIE_BITS) {
+    uint32_t bit = trieBit(h, shift);
+    if (node->entryMap & bit) {
+      HashEntry *entry = &node->entries[bitCount(node->entryMap & (bit - 1))];
+      return entryHasKey(entry, key, h) ? entry : NULL;
     }
-    entry = entry->next;
+    if (!(node->childMap & bit)) {
+      return NULL;
+    }
+    node = node->children[bitCount(node->childMap & (bit - 1))];
   }
 
-  // create new entry
-  HashEntry *newEntry = malloc(sizeof(HashEntry));
-  newEntry->key = *key;
-  newEntry->value = *value;
-  newEntry->next = hash->buckets[bucketIndex];
-  hash->buckets[bucketIndex] = newEntry;
-  hash->size++;
+  for (int i = 0; i < node->entryCount; i++) {
+    if (entryHasKey(&node->entries[i], key, h)) {
+      return &node->entries[i];
+    }
+  }
+  return NULL;
+}
 
-  return 0;
+// node with entry's key set to its value; *added tells whether the key is
+// new. a key that is already there keeps its original key object
+static HashTrie *trieWith(HashTrie *node, HashEntry *entry, int shift,
+                          bool *added) {
+  if (shift >= TRIE_MAX_SHIFT) {
+    int count = node->entryCount;
+    for (int i = 0; i < count; i++) {
+      if (entryHasKey(&node->entries[i], &entry->key, entry->hash)) {
+        HashTrie *copy = newTrie(count, 0);
+        memcpy(copy->entries, node->entries, sizeof(HashEntry) * count);
+        copy->entries[i].value = entry->value;
+        *added = false;
+        return copy;
+      }
+    }
+    HashTrie *copy = newTrie(count + 1, 0);
+    memcpy(copy->entries, node->entries, sizeof(HashEntry) * count);
+    copy->entries[count] = *entry;
+    *added = true;
+    return copy;
+  }
+
+  uint32_t bit = trieBit(entry->hash, shift);
+  if (node->childMap & bit) {
+    HashTrie *child = node->children[bitCount(node->childMap & (bit - 1))];
+    return editTrie(node, bit, NULL,
+                    trieWith(child, entry, shift + TRIE_BITS, added));
+  }
+  if (!(node->entryMap & bit)) {
+    *added = true;
+    return editTrie(node, bit, entry, NULL);
+  }
+
+  HashEntry *existing = &node->entries[bitCount(node->entryMap & (bit - 1))];
+  if (entryHasKey(existing, &entry->key, entry->hash)) {
+    HashEntry updated = *existing;
+    updated.value = entry->value;
+    *added = false;
+    return editTrie(node, bit, &updated, NULL);
+  }
+  *added = true;
+  return editTrie(node, bit, NULL,
+                  trieOfPair(existing, entry, shift + TRIE_BITS));
 }
 
-// get value from hash table
-Object *hashGet(Hash *hash, Object *key) {
-  HashKey hashKey = getHashKey(key);
-  int bucketIndex = hashKey.value & (hash->bucketCount - 1);  // fast modulo for power of 2
+// node without key, whose hash is h; node itself when key is not in it
+static HashTrie *trieWithout(HashTrie *node, Object *key, uint64_t h,
+                             int shift) {
+  if (shift >= TRIE_MAX_SHIFT) {
+    for (int i = 0; i < node->entryCount; i++) {
+      if (entryHasKey(&node->entries[i], key, h)) {
+        HashTrie *copy = newTrie(node->entryCount - 1, 0);
+        memcpy(copy->entries, node->entries, sizeof(HashEntry) * i);
+        memcpy(copy->entries + i, node->entries + i + 1,
+               sizeof(HashEntry) * (node->entryCount - i - 1));
+        return copy;
+      }
+    }
+    return node;
+  }
+
+  uint32_t bit = trieBit(h, shift);
+  if (node->entryMap & bit) {
+    HashEntry *entry = &node->entries[bitCount(node->entryMap & (bit - 1))];
+    return entryHasKey(entry, key, h) ? editTrie(node, bit, NULL, NULL) : node;
+  }
+  if (!(node->childMap & bit)) {
+    return node;
+  }
+
+  HashTrie *child = node->children[bitCount(node->childMap & (bit - 1))];
+  HashTrie *smaller = trieWithout(child, key, h, shift + TRIE_BITS);
+  if (smaller == child) {
+    return node;
+  }
+  if (smaller->entryCount == 1 && smaller->childCount == 0) {
+    return editTrie(node, bit, &smaller->entries[0], NULL);
+  }
+  return editTrie(node, bit, NULL, smaller);
+}
+
+static void flattenTrie(HashTrie *node, HashEntry *out, int *count) {
+  memcpy(out + *count, node->entries, sizeof(HashEntry) * node->entryCount);
+  *count += node->entryCount;
+  for (int i = 0; i < node->childCount; i++) {
+    flattenTrie(node->children[i], out, count);
+  }
+}
+
+// the trie holding hash's pairs, built from its table on first use
+static HashTrie *hashTrie(Hash *hash) {
+  if (!hash->trie) {
+    HashTrie *trie = newTrie(0, 0);
+    for (int i = 0; i < hash->size; i++) {
+      bool added;
+      trie = trieWith(trie, &hash->entries[i], 0, &added);
+    }
+    hash->trie = trie;
+  }
+  return hash->trie;
+}
+
+static Hash *newTrieHash(HashTrie *trie, int size) {
+  Hash *hash = malloc(sizeof(Hash));
+  hash->control = NULL;
+  hash->index = NULL;
+  hash->entries = NULL;
+  hash->slotCount = 0;
+  hash->size = size;
+  hash->capacity = 0;
+  hash->shape = NULL;
+  hash->trie = trie;
+  return hash;
+}
+
+Hash *hashWith(Hash *hash, Object *key, Object *value) {
+  HashEntry entry = {*key, *value, mixHash(getHashKey(key).value)};
+  bool added;
+  HashTrie *trie = trieWith(hashTrie(hash), &entry, 0, &added);
+  return newTrieHash(trie, hash->size + added);
+}
+
+Hash *hashWithout(Hash *hash, Object *key) {
+  HashTrie *trie = hashTrie(hash);
+  HashTrie *smaller = trieWithout(trie, key, mixHash(getHashKey(key).value), 0);
+  if (smaller == trie) {
+    return hash; // nothing to remove, and hashes never change
+  }
+  return newTrieHash(smaller, hash->size - 1);
+}
 
-  HashEntry *entry = hash->buckets[bucketIndex];
+bool isHashable(Object *key) {
+  return strcmp(key->type, IntegerObj) == 0 ||
+         strcmp(key->type, BooleanObj) == 0 ||
+         strcmp(key->type, StringObj) == 0;
+}
+
+// ===== PERSISTENT VECTOR =====
+// a bit-partitioned trie of 32-way nodes over the elements, with the last
+// block kept out of it in a tail. pushes fill the tail, and only a full
+// tail is copied into the trie, along with the path from the root to it
+
+#define ARRAY_BITS 5
+#define ARRAY_WIDTH (1 << ARRAY_BITS)
+#define ARRAY_MASK (ARRAY_WIDTH - 1)
+
+// children are ArrayNodes above the lowest level and leaves of ARRAY_WIDTH
+// Objects at it. leaves of a vector pushed from a flat array point into
+// that array's elements
+struct ArrayNode {
+  void *children[ARRAY_WIDTH];
+};
+
+// used counts the slots written by every version sharing the tail, so only
+// a push onto the longest of them fills the next slot in place
+struct ArrayTail {
+  int used;
+  Object elements[ARRAY_WIDTH];
+};
+
+// the raw values behind packed arrays. like a tail, pushes onto the array
+// that ends at used write in place until capacity runs out
+struct PackedInts {
+  int used;
+  int capacity;
+  int64_t values[];
+};
+
+Array *newArray(Object *elements, int count) {
+  Array *array = malloc(sizeof(Array));
+  array->elements = elements;
+  array->count = count;
+  array->root = NULL;
+  array->shift = 0;
+  array->tail = NULL;
+  array->start = 0;
+  array->packed = NULL;
+  return array;
+}
+
+static PackedInts *newPacked(int capacity) {
+  PackedInts *packed =
+      malloc(sizeof(PackedInts) + sizeof(int64_t) * (capacity ? capacity : 1));
+  packed->used = 0;
+  packed->capacity = capacity;
+  return packed;
+}
+
+Array *newArrayOf(Object *elements, int count) {
+  for (int i = 0; i < count; i++) {
+    if (strcmp(elements[i].type, IntegerObj) != 0) {
+      return newArray(elements, count);
+    }
+  }
+  Array *array = newArray(NULL, count);
+  array->packed = newPacked(count);
+  for (int i = 0; i < count; i++) {
+    array->packed->values[i] = elements[i].integer->value;
+  }
+  array->packed->used = count;
+  free(elements);
+  return array;
+}
 
-  while (entry) {
-    if (hashKeysEqual(&entry->key, key)) {
-      return &entry->value;
+static int64_t *arrayInts(Array *array, int64_t **owned) {
+  if (array->packed) {
+    return array->packed->values + array->start;
+  }
+  int64_t *values = malloc(sizeof(int64_t) * (array->count ? array->count : 1));
+  for (int i = 0; i < array->count; i++) {
+    Object *element = arrayGet(array, i);
+    if (strcmp(element->type, IntegerObj) != 0) {
+      free(values);
+      return NULL;
     }
-    entry = entry->next;
+    values[i] = element->integer->value;
+  }
+  *owned = values;
+  return values;
+}
+
+// the elements boxed into a flat array, for a push of something else
+static Array *unpack(Array *array) {
+  int count = array->count ? array->count : 1;
+  Object *elements = malloc(sizeof(Object) * count);
+  Integer *ints = malloc(sizeof(Integer) * count);
+  int64_t *values = array->packed->values + array->start;
+  for (int i = 0; i < array->count; i++) {
+    ints[i].value = values[i];
+    elements[i] = (Object){.type = IntegerObj, .integer = &ints[i]};
+  }
+  return newArray(elements, array->count);
+}
+
+// appends in place when array ends where the buffer's used values do: no
+// other version can see that slot, as each one (shared constants included)
+// keeps its own start and count and only appends past them
+static Array *packedPush(Array *array, int64_t value) {
+  Array *result = malloc(sizeof(Array));
+  *result = *array;
+  PackedInts *packed = array->packed;
+  if (array->start + array->count != packed->used ||
+      packed->used == packed->capacity) {
+    // an older version, or no room left: move to a buffer twice the size
+    int capacity = array->count < 8 ? 16 : array->count * 2;
+    result->packed = newPacked(capacity);
+    memcpy(result->packed->values, packed->values + array->start,
+           sizeof(int64_t) * array->count);
+    result->packed->used = array->count;
+    result->start = 0;
   }
+  result->packed->values[result->packed->used++] = value;
+  result->count++;
+  return result;
+}
+
+// index of the first element in the tail of a vector of count elements
+static int tailOffset(int count) {
+  return count < ARRAY_WIDTH ? 0 : ((count - 1) >> ARRAY_BITS) << ARRAY_BITS;
+}
 
-  return NULL;  // key not found
+Object *arrayGet(Array *array, int index) {
+  if (!array->tail) {
+    return &array->elements[index];
+  }
+  index += array->start;
+  int offset = tailOffset(array->start + array->count);
+  if (index >= offset) {
+    return &array->tail->elements[index - offset];
+  }
+  void *node = array->root;
+  for (int level = array->shift; level > 0; level -= ARRAY_BITS) {
+    node = ((ArrayNode *)node)->children[(index >> level) & ARRAY_MASK];
+  }
+  return &((Object *)node)[index & ARRAY_MASK];
+}
+
+Object arrayGetValue(Array *array, int index, Integer *box) {
+  if (!array->packed) {
+    return *arrayGet(array, index);
+  }
+  box->value = array->packed->values[array->start + index];
+  return (Object){.type = IntegerObj, .integer = box};
+}
+
+static ArrayTail *newTail(Object *elements, int count) {
+  ArrayTail *tail = malloc(sizeof(ArrayTail));
+  memcpy(tail->elements, elements, sizeof(Object) * count);
+  tail->used = count;
+  return tail;
+}
+
+// a chain of single-child nodes from level down to leaf
+static void *newPath(int level, Object *leaf) {
+  if (level == 0) {
+    return leaf;
+  }
+  ArrayNode *node = calloc(1, sizeof(ArrayNode));
+  node->children[0] = newPath(level - ARRAY_BITS, leaf);
+  return node;
+}
+
+// a copy of parent (NULL for an empty one) with leaf added below it,
+// where lastIndex is the index of the leaf's last element
+static ArrayNode *pushLeaf(int level, ArrayNode *parent, int lastIndex,
+                           Object *leaf) {
+  ArrayNode *node = malloc(sizeof(ArrayNode));
+  if (parent) {
+    memcpy(node, parent, sizeof(ArrayNode));
+  } else {
+    memset(node, 0, sizeof(ArrayNode));
+  }
+
+  int slot = (lastIndex >> level) & ARRAY_MASK;
+  if (level == ARRAY_BITS) {
+    node->children[slot] = leaf;
+  } else if (node->children[slot]) {
+    node->children[slot] =
+        pushLeaf(level - ARRAY_BITS, node->children[slot], lastIndex, leaf);
+  } else {
+    node->children[slot] = newPath(level - ARRAY_BITS, leaf);
+  }
+  return node;
+}
+
+static void addLeaf(Array *vector, Object *leaf, int lastIndex) {
+  // a full root gets a new root above it
+  if ((lastIndex >> ARRAY_BITS) + 1 > (1 << vector->shift)) {
+    ArrayNode *root = calloc(1, sizeof(ArrayNode));
+    root->children[0] = vector->root;
+    root->children[1] = newPath(vector->shift, leaf);
+    vector->root = root;
+    vector->shift += ARRAY_BITS;
+  } else {
+    vector->root = pushLeaf(vector->shift, vector->root, lastIndex, leaf);
+  }
+}
+
+// the same elements as a vector, whose leaves are the flat array's own
+// blocks; only the tail is copied
+static Array vectorOf(Array *flat) {
+  Array vector = {.count = flat->count, .shift = ARRAY_BITS};
+  int offset = tailOffset(flat->count);
+  for (int start = 0; start < offset; start += ARRAY_WIDTH) {
+    addLeaf(&vector, flat->elements + start, start + ARRAY_WIDTH - 1);
+  }
+  vector.tail = newTail(flat->elements + offset, flat->count - offset);
+  return vector;
+}
+
+Array *arrayPush(Array *array, Object *value) {
+  if (array->packed) {
+    if (strcmp(value->type, IntegerObj) == 0) {
+      return packedPush(array, value->integer->value);
+    }
+    array = unpack(array);
+  }
+  Array *result = malloc(sizeof(Array));
+  *result = array->tail ? *array : vectorOf(array);
+  int length = result->start + result->count;
+  int tailCount = length - tailOffset(length);
+
+  if (tailCount == ARRAY_WIDTH) {
+    addLeaf(result, result->tail->elements, length - 1);
+    result->tail = newTail(value, 1);
+  } else if (result->tail->used == tailCount) {
+    // no version reaches past this one's end, so the slot is unseen and
+    // can be written in place; every version (shared constants included)
+    // only ever appends past its own count
+    result->tail->elements[tailCount] = *value;
+    result->tail->used++;
+  } else {
+    // an older version: the slot is taken by a longer one
+    result->tail = newTail(result->tail->elements, tailCount);
+    result->tail->elements[tailCount] = *value;
+    result->tail->used++;
+  }
+  result->count++;
+  return result;
+}
+
+// the view keeps its own start and count over array's storage. it is safe
+// to share because nothing is written below a version's end: a push on the
+// view either writes past the end of every version or copies first
+Array *arrayRest(Array *array, int dropped) {
+  if (!array->tail && !array->packed) {
+    return newArray(array->elements + dropped, array->count - dropped);
+  }
+  Array *rest = malloc(sizeof(Array));
+  *rest = *array;
+  rest->start += dropped;
+  rest->count -= dropped;
+  return rest;
 }
 
 void printObject(Object *object) {
@@ -394,7 +1274,7 @@ void printObject(Object *object) {
   } else if (strcmp(object->type, NullObj) == 0) {
     printf("null\n");
   } else if (strcmp(object->type, StringObj) == 0) {
-    printf("\"%s\"\n", object->string->value);
+    printf("\"%s\"\n", stringValue(object->string));
   } else if (strcmp(object->type, ArrayObj) == 0) {
     printf("array[%d]\n", object->array->count);
   } else if (strcmp(object->type, HashObj) == 0) {
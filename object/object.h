@@ -23,6 +23,12 @@
 #define BuiltinFuncNameRest "rest"
 #define BuiltinFuncNamePush "push"
 #define BuiltinFuncNamePuts "puts"
+#define BuiltinFuncNameSet "set"
+#define BuiltinFuncNameDelete "delete"
+#define BuiltinFuncNameSum "sum"
+#define BuiltinFuncNameMin "min"
+#define BuiltinFuncNameMax "max"
+#define BuiltinFuncNameDot "dot"
 
 typedef char *ObjectType;
 typedef struct Object Object;
@@ -37,11 +43,20 @@ typedef struct Builtin Builtin;
 typedef struct Array Array;
 typedef struct Hash Hash;
 typedef struct HashKey HashKey;
+typedef struct HashTrie HashTrie;
+typedef struct ArrayNode ArrayNode;
+typedef struct ArrayTail ArrayTail;
+typedef struct PackedInts PackedInts;
 typedef struct CompiledFunction CompiledFunction;
 typedef struct Environment Environment;
 typedef struct EnvironmentTableEntry EnvironmentTableEntry;
 typedef struct BuiltinEntry BuiltinEntry;
 typedef Object *(*BuiltinFunction)(Object **args, int argCount);
+// natively compiled function body; called with its locals already reserved
+// from basePointer on the vm stack, leaves the return value in place of the
+// callee like OpReturnValue
+struct VM;
+typedef int (*NativeFunction)(struct VM *vm, int basePointer);
 
 struct Object {
   ObjectType type;
@@ -70,28 +85,56 @@ struct HashKey {
   uint64_t value;
 };
 
-// hash table bucket entry - forms a linked list for collision handling
+// one key-value pair of a hash table. the key's hash is kept next to it,
+// so growing the table never hashes a key again and most mismatches are
+// found without looking at the key
 typedef struct HashEntry HashEntry;
 struct HashEntry {
   Object key;
   Object value;
-  HashEntry *next;  // for collision chaining
+  uint64_t hash;
 };
 
-// hash table with buckets for O(1) average lookup
+// a compact dict: the pairs live in a dense array in insertion order, and
+// an open addressing index in the style of swiss tables maps hashes to
+// positions in it. index slots come in groups of 16, each with a control
+// byte that is either empty or 7 bits of the hash of the pair it points
+// at. a probe checks a whole group's control bytes at once and only
+// compares the pairs whose bits match
 struct Hash {
-  HashEntry **buckets;  // array of bucket pointers
-  int bucketCount;      // number of buckets (power of 2)
-  int size;            // number of key-value pairs stored
-  int capacity;        // current capacity before resize
+  uint8_t *control;   // one byte per slot
+  int32_t *index;     // per slot, the position in entries of its pair
+  HashEntry *entries; // the pairs in insertion order, room for capacity
+  int slotCount;      // power of 2, a whole number of groups
+  int size;           // number of key-value pairs stored
+  int capacity;       // size at which the table grows
+  // the constant hash this one shares its key layout with, so a key found
+  // at some position of one is at that position of all of them; NULL for
+  // hashes built pair by pair at runtime
+  Hash *shape;
+  // hashes made by set() and delete() keep their pairs in a persistent trie
+  // shared with the hash they came from, and have no table (control is
+  // NULL). a table hash builds its trie the first time it is updated
+  HashTrie *trie;
 };
 
 struct Integer {
   int64_t value;
 };
 
+// length is stored so len() and concatenation never scan for the nul;
+// hash is filled in by stringHash the first time the string is used as a
+// hash key and reused from then on
+// a string built by concatenation starts out as a rope: value is NULL and
+// the bytes are those of left followed by right. stringValue joins them on
+// first use and drops the children
 struct String {
   char *value;
+  int length;
+  uint64_t hash;
+  bool hashed;
+  String *left;
+  String *right;
 };
 
 struct Boolean {
@@ -114,9 +157,25 @@ struct Function {
   Environment *environment;
 };
 
+// arrays built in one go are flat: elements holds them all and tail is
+// NULL. push makes a persistent vector instead, sharing all but a path of
+// the array it extends: the leading blocks of 32 elements are the leaves of
+// a trie under root, shift bits of the index above the leaves, and the last
+// 1-32 elements are in tail. rest shares storage too: a flat rest points
+// into the same elements, and a vector rest skips the first start elements
+// of its vector, which always ends where the array does.
+//
+// arrays holding only integers are packed instead, with elements and tail
+// NULL: the raw values sit from start in packed, and reading one boxes it.
+// pushing an integer keeps the array packed, anything else unpacks it
 struct Array {
   Object *elements;
   int count;
+  ArrayNode *root;
+  int shift;
+  ArrayTail *tail;
+  int start;
+  PackedInts *packed;
 };
 
 struct CompiledFunction {
@@ -124,6 +183,12 @@ struct CompiledFunction {
   int numLocals;
   int numParameters;
   int instructionCount;
+  NativeFunction native; // NULL when interpreted
+  int invocationCount;   // calls seen by the interpreter, drives the jit
+  bool jitFailed;        // jit gave up on this function, stay interpreted
+  // pc -> source line, see encodeLineTable; NULL when there is none
+  unsigned char *lineTable;
+  int lineTableLength;
 };
 
 struct EnvironmentTableEntry {
@@ -151,10 +216,52 @@ extern BuiltinEntry builtins[];
 
 char *inspect(Object *object);
 HashKey getHashKey(Object *object);
+String *newString(char *value, int length);
+// short results are copied, longer ones share both operands in a rope
+String *concatStrings(String *left, String *right);
+// the nul-terminated bytes, flattening a rope first
+char *stringValue(String *string);
+uint64_t stringHash(String *string);
+bool stringsEqual(String *a, String *b);
 Hash *newHash();
 void freeHash(Hash *hash);
+// adds to a table hash while it is being built
 int hashSet(Hash *hash, Object *key, Object *value);
+// the value is stored in the table and moves when it grows
 Object *hashGet(Hash *hash, Object *key);
+// position of key in the entries of a table hash, -1 when missing
+int hashFind(Hash *hash, Object *key);
+// a new hash with key set to value, or without key; both share all but
+// O(log n) of their storage with hash, which is left as it was
+Hash *hashWith(Hash *hash, Object *key, Object *value);
+Hash *hashWithout(Hash *hash, Object *key);
+// integers, booleans and strings
+bool isHashable(Object *key);
+
+// a flat array owning elements
+Array *newArray(Object *elements, int count);
+// a packed array of the elements when they are all integers, which are
+// copied out, and otherwise a flat array owning them
+Array *newArrayOf(Object *elements, int count);
+// index must be in range; O(log32 n) for vectors. the element's own slot,
+// so not for packed arrays, which hold no objects (see arrayGetValue)
+Object *arrayGet(Array *array, int index);
+// the element at index by value, for any kind of array. a packed element is
+// written to *box and the result points at it, so box must live as long as
+// the result does; it is not touched otherwise and may be NULL for arrays
+// that are not packed
+Object arrayGetValue(Array *array, int index, Integer *box);
+// array with value appended, in amortized O(1). array is left as it was
+Array *arrayPush(Array *array, Object *value);
+// the elements after the first dropped, in O(1) and sharing array's storage
+Array *arrayRest(Array *array, int dropped);
+// a hash with the keys of shape at the same positions and its values,
+// for the caller to overwrite
+Hash *newHashWithShape(Hash *shape);
+// steps through the pairs, in insertion order for table hashes and in hash
+// order for trie hashes; start with *cursor = 0, NULL once every pair has
+// been seen
+HashEntry *hashNext(Hash *hash, int *cursor);
 int hashKeysEqual(Object *key1, Object *key2);
 Environment *newEnviroment();
 Environment *newEnclosedEnvironment(Environment *environment);
@@ -35,6 +35,41 @@ Definition definitions[MAX_OPCODE + 1] = {
     [OpSetLocal] = {"OpSetLocal", {1, 0}, 1},
     [OpGetBuiltin] = {"OpGetBuiltin", {1, 0}, 1},
     [OpGetFree] = {"OpGetFree", {1, 0}, 1},
+    [OpRecord] = {"OpRecord", {2, 0}, 1},
+    [OpGetField] = {"OpGetField", {2, 0}, 1},
+};
+
+const unsigned char instructionLengths[MAX_OPCODE + 1] = {
+    [OpConstant] = 3,
+    [OpPop] = 1,
+    [OpAdd] = 1,
+    [OpSub] = 1,
+    [OpMul] = 1,
+    [OpDiv] = 1,
+    [OpTrue] = 1,
+    [OpFalse] = 1,
+    [OpEqual] = 1,
+    [OpNotEqual] = 1,
+    [OpGreaterThan] = 1,
+    [OpMinus] = 1,
+    [OpBang] = 1,
+    [OpJumpNotTruthy] = 3,
+    [OpJump] = 3,
+    [OpNull] = 1,
+    [OpGetGlobal] = 3,
+    [OpSetGlobal] = 3,
+    [OpArray] = 3,
+    [OpHash] = 3,
+    [OpIndex] = 1,
+    [OpCall] = 2,
+    [OpReturnValue] = 1,
+    [OpReturn] = 1,
+    [OpGetLocal] = 2,
+    [OpSetLocal] = 2,
+    [OpGetBuiltin] = 2,
+    [OpGetFree] = 2,
+    [OpRecord] = 3,
+    [OpGetField] = 3,
 };
 
 // fast opcode lookup with bounds checking
@@ -174,3 +209,84 @@ char *instructionsToString(Instructions instructions, int length) {
 
   return output;
 }
+
+// ===== LINE TABLES =====
+
+static int writeUleb(unsigned char *out, unsigned int value) {
+  int n = 0;
+  do {
+    unsigned char byte = value & 0x7f;
+    value >>= 7;
+    out[n++] = value ? byte | 0x80 : byte;
+  } while (value);
+  return n;
+}
+
+// returns the bytes read, 0 if the value runs past end
+static int readUleb(const unsigned char *in, const unsigned char *end,
+                    unsigned int *value) {
+  unsigned int result = 0;
+  int n = 0;
+  for (int shift = 0; in + n < end && shift < 32; shift += 7) {
+    unsigned char byte = in[n++];
+    result |= (unsigned int)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      *value = result;
+      return n;
+    }
+  }
+  return 0;
+}
+
+unsigned char *encodeLineTable(const LineEntry *entries, int count,
+                               int *length) {
+  *length = 0;
+  if (count == 0) {
+    return NULL;
+  }
+
+  // two five byte varints at most per entry
+  unsigned char *table = malloc((size_t)count * 10);
+  int pc = 0;
+  int line = 0;
+  for (int i = 0; i < count; i++) {
+    int delta = entries[i].line - line;
+    *length += writeUleb(table + *length, (unsigned int)(entries[i].pc - pc));
+    *length += writeUleb(table + *length,
+                         ((unsigned int)delta << 1) ^ (unsigned int)(delta >> 31));
+    pc = entries[i].pc;
+    line = entries[i].line;
+  }
+  return realloc(table, *length);
+}
+
+int lineForOffset(const unsigned char *table, int length, int pc) {
+  if (!table) {
+    return 0;
+  }
+
+  const unsigned char *at = table;
+  const unsigned char *end = table + length;
+  int entryPc = 0;
+  int line = 0;
+  int found = 0;
+  while (at < end) {
+    unsigned int pcDelta = 0;
+    unsigned int lineBits = 0;
+    int n = readUleb(at, end, &pcDelta);
+    int m = n ? readUleb(at + n, end, &lineBits) : 0;
+    if (!m) {
+      break; // malformed, keep what was found so far
+    }
+    at += n + m;
+
+    entryPc += (int)pcDelta;
+    if (entryPc > pc) {
+      break;
+    }
+    line += (int)(lineBits >> 1) ^ -(int)(lineBits & 1);
+    found = line;
+  }
+  return found;
+}
+
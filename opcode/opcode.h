@@ -32,6 +32,11 @@ typedef char *Instructions;
 #define OpSetLocal 25
 #define OpGetBuiltin 26
 #define OpGetFree 27
+// builds a hash from the constant hash at operand, whose string keys it
+// shares, and the values on the stack in key order
+#define OpRecord 28
+// indexes the top of the stack with the string constant at operand
+#define OpGetField 29
 
 typedef struct {
   const char *name;
@@ -39,13 +44,33 @@ typedef struct {
   int operandCount;
 } Definition;
 
-#define MAX_OPCODE 27
+#define MAX_OPCODE 29
 extern Definition definitions[MAX_OPCODE + 1];
 
+// encoded length of each instruction, opcode byte included; the same
+// information as the operand widths in definitions, without the summing
+extern const unsigned char instructionLengths[MAX_OPCODE + 1];
+
 int lookupOpCode(char opCode, Definition *out);
 Instructions makeInstruction(char opCode, int *operands, int operandCount);
 int readOperands(Definition *definition, Instructions instructions,
                  int instructionLength, int *operands, int *offset);
 char *instructionsToString(Instructions instructions, int length);
 
+// pc -> source line tables. an entry says the instructions from pc up to
+// the next entry's pc came from line; entries are in pc order. encoded, each
+// entry is its pc delta as an unsigned leb128 followed by its line delta as
+// a zigzag leb128, both relative to the entry before (or to pc 0, line 0),
+// so a line change usually costs two bytes
+typedef struct {
+  int pc;
+  int line;
+} LineEntry;
+
+// returns a malloc'd table and its size in *length, NULL when count is 0
+unsigned char *encodeLineTable(const LineEntry *entries, int count,
+                               int *length);
+// the line of the instruction at pc, 0 if the table has none
+int lineForOffset(const unsigned char *table, int length, int pc);
+
 #endif
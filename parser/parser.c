@@ -13,27 +13,32 @@
 #define PREC_CALL 7
 #define PREC_INDEX 8
 
-typedef struct {
-  const char *tokenType;
-  int precedence;
-} PrecedenceEntry;
-
-// precedence table mapping token types to their precedence levels
-static PrecedenceEntry precedenceTable[] = {
-    {EQ, PREC_EQUALS},      {NOT_EQ, PREC_EQUALS},    {LT, PREC_LESSGREATER},
-    {GT, PREC_LESSGREATER}, {PLUS, PREC_SUM},         {MINUS, PREC_SUM},
-    {SLASH, PREC_PRODUCT},  {ASTERISK, PREC_PRODUCT}, {LPAREN, PREC_CALL},
-    {LBRACKET, PREC_INDEX},
+// precedence of each token in infix position, indexed by token type;
+// tokens without an entry bind at PREC_LOWEST
+static const int precedenceTable[TOKEN_TYPE_COUNT] = {
+    [EQ] = PREC_EQUALS,      [NOT_EQ] = PREC_EQUALS,    [LT] = PREC_LESSGREATER,
+    [GT] = PREC_LESSGREATER, [PLUS] = PREC_SUM,         [MINUS] = PREC_SUM,
+    [SLASH] = PREC_PRODUCT,  [ASTERISK] = PREC_PRODUCT, [LPAREN] = PREC_CALL,
+    [LBRACKET] = PREC_INDEX,
 };
 
+static int precedenceOf(TokenType type) {
+  int precedence = precedenceTable[type];
+  return precedence ? precedence : PREC_LOWEST;
+}
+
 // create a new parser with registered parsing functions
 Parser *newParser(Lexer *lexer) {
   Parser *parser = malloc(sizeof(Parser));
   parser->lexer = lexer;
   parser->errors = NULL;
   parser->errorCount = 0;
-  parser->prefixCount = 0;
-  parser->infixCount = 0;
+  memset(parser->prefixFns, 0, sizeof(parser->prefixFns));
+  memset(parser->infixFns, 0, sizeof(parser->infixFns));
+  parser->arena = NULL;
+  parser->scratch = NULL;
+  parser->scratchCount = 0;
+  parser->scratchCapacity = 0;
 
   // register prefix parsing functions
   registerPrefix(parser, IDENTIFIER, parseIdentifier);
@@ -71,6 +76,7 @@ void freeParser(Parser *parser) {
   for (int i = 0; i < parser->errorCount; i++)
     free(parser->errors[i]);
   free(parser->errors);
+  free(parser->scratch);
   free(parser);
 }
 
@@ -86,28 +92,39 @@ void parserAddError(Parser *parser, const char *message) {
   parser->errors[parser->errorCount++] = strdup(message);
 }
 
-void registerPrefix(Parser *parser, const char *tokenType, PrefixParseFn fn) {
-  parser->prefixFns[parser->prefixCount++] = (PrefixEntry){tokenType, fn};
+static void scratchPush(Parser *parser, void *node) {
+  if (parser->scratchCount == parser->scratchCapacity) {
+    parser->scratchCapacity =
+        parser->scratchCapacity ? parser->scratchCapacity * 2 : 64;
+    parser->scratch =
+        realloc(parser->scratch, sizeof(void *) * parser->scratchCapacity);
+  }
+  parser->scratch[parser->scratchCount++] = node;
 }
 
-void registerInfix(Parser *parser, const char *tokenType, InfixParseFn fn) {
-  parser->infixFns[parser->infixCount++] = (InfixEntry){tokenType, fn};
+// moves the entries pushed since mark into the arena and pops them
+static void *scratchFinish(Parser *parser, int mark, int *count) {
+  *count = parser->scratchCount - mark;
+  void *list = astCopy(parser->arena, parser->scratch + mark,
+                       sizeof(void *) * *count);
+  parser->scratchCount = mark;
+  return list;
 }
 
-PrefixParseFn getPrefixFn(Parser *parser, const char *tokenType) {
-  for (int i = 0; i < parser->prefixCount; i++) {
-    if (strcmp(parser->prefixFns[i].tokenType, tokenType) == 0)
-      return parser->prefixFns[i].fn;
-  }
-  return NULL;
+void registerPrefix(Parser *parser, TokenType tokenType, PrefixParseFn fn) {
+  parser->prefixFns[tokenType] = fn;
 }
 
-InfixParseFn getInfixFn(Parser *parser, const char *tokenType) {
-  for (int i = 0; i < parser->infixCount; i++) {
-    if (strcmp(parser->infixFns[i].tokenType, tokenType) == 0)
-      return parser->infixFns[i].fn;
-  }
-  return NULL;
+void registerInfix(Parser *parser, TokenType tokenType, InfixParseFn fn) {
+  parser->infixFns[tokenType] = fn;
+}
+
+PrefixParseFn getPrefixFn(Parser *parser, TokenType tokenType) {
+  return parser->prefixFns[tokenType];
+}
+
+InfixParseFn getInfixFn(Parser *parser, TokenType tokenType) {
+  return parser->infixFns[tokenType];
 }
 
 void nextTokenParser(Parser *parser) {
@@ -115,63 +132,61 @@ void nextTokenParser(Parser *parser) {
   parser->peekToken = nextToken(parser->lexer);
 }
 
-int currentTokenIs(Parser *parser, const char *type) {
-  return strcmp(parser->currentToken.type, type) == 0;
+int currentTokenIs(Parser *parser, TokenType type) {
+  return parser->currentToken.type == type;
 }
 
-int peekTokenIs(Parser *parser, const char *type) {
-  return strcmp(parser->peekToken.type, type) == 0;
+int peekTokenIs(Parser *parser, TokenType type) {
+  return parser->peekToken.type == type;
 }
 
-int expectPeek(Parser *parser, const char *type) {
+int expectPeek(Parser *parser, TokenType type) {
   if (peekTokenIs(parser, type)) {
     nextTokenParser(parser);
     return 1;
   } else {
-    char msg[128];
-    snprintf(msg, sizeof(msg), "expected next token to be %s, got %s instead",
-             type, parser->peekToken.type);
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "line %d, column %d: expected next token to be %s, got %s instead",
+             parser->peekToken.line,
+             tokenColumn(parser->peekToken, parser->lexer->input),
+             tokenTypeName(type), tokenTypeName(parser->peekToken.type));
     parserAddError(parser, msg);
     return 0;
   }
 }
 
 int peekPrecedence(Parser *parser) {
-  for (size_t i = 0; i < sizeof(precedenceTable) / sizeof(PrecedenceEntry);
-       i++) {
-    if (strcmp(parser->peekToken.type, precedenceTable[i].tokenType) == 0)
-      return precedenceTable[i].precedence;
-  }
-  return PREC_LOWEST;
+  return precedenceOf(parser->peekToken.type);
 }
 
 int currentPrecedence(Parser *parser) {
-  for (size_t i = 0; i < sizeof(precedenceTable) / sizeof(PrecedenceEntry);
-       i++) {
-    if (strcmp(parser->currentToken.type, precedenceTable[i].tokenType) == 0)
-      return precedenceTable[i].precedence;
-  }
-  return PREC_LOWEST;
+  return precedenceOf(parser->currentToken.type);
 }
 
 Program *parseProgram(Parser *parser) {
-  Program *program = malloc(sizeof(Program));
-  program->type = NODE_PROGRAM;
-  program->statementCount = 0;
-  program->statements = NULL;
+  parser->arena = newAstArena();
+  Program *program = newProgram(parser->arena);
+  int mark = parser->scratchCount;
 
+  Statement *stmt;
+  while ((stmt = parseNextStatement(parser)) != NULL) {
+    scratchPush(parser, stmt);
+  }
+
+  program->statements = scratchFinish(parser, mark, &program->statementCount);
+  return program;
+}
+
+Statement *parseNextStatement(Parser *parser) {
   while (!currentTokenIs(parser, EOF_TOK)) {
     Statement *stmt = parseStatement(parser);
+    nextTokenParser(parser);
     if (stmt != NULL) {
-      program->statements =
-          realloc(program->statements,
-                  sizeof(Statement *) * (program->statementCount + 1));
-      program->statements[program->statementCount++] = stmt;
+      return stmt;
     }
-    nextTokenParser(parser);
   }
-
-  return program;
+  return NULL;
 }
 
 Statement *parseStatement(Parser *parser) {
@@ -192,7 +207,7 @@ Statement *parseLetStatement(Parser *parser) {
   }
 
   Identifier *name =
-      newIdentifier(parser->currentToken, parser->currentToken.literal);
+      newIdentifierFromToken(parser->arena, parser->currentToken);
 
   if (!expectPeek(parser, ASSIGN)) {
     return NULL;
@@ -205,7 +220,8 @@ Statement *parseLetStatement(Parser *parser) {
     nextTokenParser(parser);
   }
 
-  return wrapLetStatement(newLetStatement(letToken, name, value));
+  return wrapLetStatement(
+      parser->arena, newLetStatement(parser->arena, letToken, name, value));
 }
 
 Statement *parseReturnStatement(Parser *parser) {
@@ -218,7 +234,9 @@ Statement *parseReturnStatement(Parser *parser) {
     nextTokenParser(parser);
   }
 
-  return wrapReturnStatement(newReturnStatement(returnToken, returnValue));
+  return wrapReturnStatement(
+      parser->arena,
+      newReturnStatement(parser->arena, returnToken, returnValue));
 }
 
 Statement *parseExpressionStatement(Parser *parser) {
@@ -229,15 +247,19 @@ Statement *parseExpressionStatement(Parser *parser) {
     nextTokenParser(parser);
   }
 
-  return wrapExpressionStatement(newExpressionStatement(token, expression));
+  return wrapExpressionStatement(
+      parser->arena, newExpressionStatement(parser->arena, token, expression));
 }
 
 Expression *parseExpression(Parser *parser, int precedence) {
   PrefixParseFn prefixFn = getPrefixFn(parser, parser->currentToken.type);
   if (prefixFn == NULL) {
-    char msg[128];
-    snprintf(msg, sizeof(msg), "no prefix parse function for %s found",
-             parser->currentToken.type);
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "line %d, column %d: no prefix parse function for %s found",
+             parser->currentToken.line,
+             tokenColumn(parser->currentToken, parser->lexer->input),
+             tokenTypeName(parser->currentToken.type));
     parserAddError(parser, msg);
     return NULL;
   }
@@ -260,33 +282,46 @@ Expression *parseExpression(Parser *parser, int precedence) {
 
 Expression *parseIdentifier(Parser *parser) {
   return wrapIdentifier(
-      newIdentifier(parser->currentToken, parser->currentToken.literal));
+      parser->arena,
+      newIdentifierFromToken(parser->arena, parser->currentToken));
 }
 
 Expression *parseIntegerLiteral(Parser *parser) {
-  long long value = atoi(parser->currentToken.literal);
-  return wrapIntegerLiteral(newIntegerLiteral(parser->currentToken, value));
+  // the literal is a digit-only slice of the source
+  Token token = parser->currentToken;
+  long long value = 0;
+  for (int i = 0; i < token.length; i++) {
+    value = value * 10 + (token.start[i] - '0');
+  }
+  return wrapIntegerLiteral(parser->arena,
+                            newIntegerLiteral(parser->arena, token, value));
 }
 
 Expression *parsePrefixExpression(Parser *parser) {
   Token token = parser->currentToken;
-  char *op = strdup(parser->currentToken.literal);
+  // operators are at most two characters; the node keeps its own copy
+  char op[3];
+  snprintf(op, sizeof(op), "%.*s", token.length, token.start);
 
   nextTokenParser(parser);
   Expression *right = parseExpression(parser, PREC_PREFIX);
 
-  return wrapPrefixExpression(newPrefixExpression(token, op, right));
+  return wrapPrefixExpression(
+      parser->arena, newPrefixExpression(parser->arena, token, op, right));
 }
 
 Expression *parseInfixExpression(Parser *parser, Expression *left) {
   Token token = parser->currentToken;
-  char *op = strdup(parser->currentToken.literal);
+  // operators are at most two characters; the node keeps its own copy
+  char op[3];
+  snprintf(op, sizeof(op), "%.*s", token.length, token.start);
   int precedence = currentPrecedence(parser);
 
   nextTokenParser(parser);
   Expression *right = parseExpression(parser, precedence);
 
-  return wrapInfixExpression(newInfixExpression(token, left, op, right));
+  return wrapInfixExpression(
+      parser->arena, newInfixExpression(parser->arena, token, left, op, right));
 }
 
 Expression *parseGroupedExpression(Parser *parser) {
@@ -331,27 +366,28 @@ Expression *parseIfExpression(Parser *parser) {
     alternative = parseBlockStatement(parser);
   }
 
-  return wrapIfExpression(
-      newIfExpression(token, condition, consequence, alternative));
+  return wrapIfExpression(parser->arena,
+                          newIfExpression(parser->arena, token, condition,
+                                          consequence, alternative));
 }
 
 BlockStatement *parseBlockStatement(Parser *parser) {
   Token token = parser->currentToken;
-  Statement **statements = NULL;
-  int count = 0;
+  int mark = parser->scratchCount;
 
   nextTokenParser(parser);
 
   while (!currentTokenIs(parser, RBRACE) && !currentTokenIs(parser, EOF_TOK)) {
     Statement *stmt = parseStatement(parser);
     if (stmt != NULL) {
-      statements = realloc(statements, sizeof(Statement *) * (count + 1));
-      statements[count++] = stmt;
+      scratchPush(parser, stmt);
     }
     nextTokenParser(parser);
   }
 
-  return newBlockStatement(token, statements, count);
+  int count;
+  Statement **statements = scratchFinish(parser, mark, &count);
+  return newBlockStatement(parser->arena, token, statements, count);
 }
 
 Expression *parseFunctionLiteral(Parser *parser) {
@@ -361,76 +397,61 @@ Expression *parseFunctionLiteral(Parser *parser) {
     return NULL;
   }
 
-  Identifier **parameters = NULL;
-  int count = 0;
+  int mark = parser->scratchCount;
 
   if (peekTokenIs(parser, RPAREN)) {
     nextTokenParser(parser);
   } else {
     nextTokenParser(parser);
 
-    parameters = realloc(parameters, sizeof(Identifier *) * (count + 1));
-    parameters[count++] =
-        newIdentifier(parser->currentToken, parser->currentToken.literal);
+    scratchPush(parser,
+                newIdentifierFromToken(parser->arena, parser->currentToken));
 
     while (peekTokenIs(parser, COMMA)) {
       nextTokenParser(parser);
       nextTokenParser(parser);
-      parameters = realloc(parameters, sizeof(Identifier *) * (count + 1));
-      parameters[count++] =
-          newIdentifier(parser->currentToken, parser->currentToken.literal);
+      scratchPush(parser,
+                  newIdentifierFromToken(parser->arena, parser->currentToken));
     }
 
     if (!expectPeek(parser, RPAREN)) {
-      free(parameters);
+      parser->scratchCount = mark;
       return NULL;
     }
   }
 
+  int count;
+  Identifier **parameters = scratchFinish(parser, mark, &count);
+
   if (!expectPeek(parser, LBRACE)) {
-    free(parameters);
     return NULL;
   }
 
   BlockStatement *body = parseBlockStatement(parser);
 
   return wrapFunctionLiteral(
-      newFunctionLiteral(token, parameters, count, body));
+      parser->arena,
+      newFunctionLiteral(parser->arena, token, parameters, count, body));
 }
 
 Expression *parseCallExpression(Parser *parser, Expression *function) {
   Token token = parser->currentToken;
 
-  Expression **args = NULL;
   int count = 0;
-
-  if (peekTokenIs(parser, RPAREN)) {
-    nextTokenParser(parser);
-  } else {
-    nextTokenParser(parser);
-
-    args = realloc(args, sizeof(Expression *) * (count + 1));
-    args[count++] = parseExpression(parser, PREC_LOWEST);
-
-    while (peekTokenIs(parser, COMMA)) {
-      nextTokenParser(parser);
-      nextTokenParser(parser);
-      args = realloc(args, sizeof(Expression *) * (count + 1));
-      args[count++] = parseExpression(parser, PREC_LOWEST);
-    }
-
-    if (!expectPeek(parser, RPAREN)) {
-      free(args);
-      return NULL;
-    }
+  Expression **args = parseExpressionList(parser, RPAREN, &count);
+  if (count < 0) {
+    return NULL;
   }
 
-  return wrapCallExpression(newCallExpression(token, function, args, count));
+  return wrapCallExpression(
+      parser->arena,
+      newCallExpression(parser->arena, token, function, args, count));
 }
 
 Expression *parseStringLiteral(Parser *parser) {
   return wrapStringLiteral(
-      newStringLiteral(parser->currentToken, parser->currentToken.literal));
+      parser->arena,
+      newStringLiteralFromToken(parser->arena, parser->currentToken));
 }
 
 Expression *parseArrayLiteral(Parser *parser) {
@@ -438,43 +459,56 @@ Expression *parseArrayLiteral(Parser *parser) {
 
   int count = 0;
   Expression **elements = parseExpressionList(parser, RBRACKET, &count);
-  return wrapArrayLiteral(newArrayLiteral(token, elements, count));
+  if (count < 0) {
+    return NULL;
+  }
+  return wrapArrayLiteral(
+      parser->arena, newArrayLiteral(parser->arena, token, elements, count));
 }
 
 Expression *parseHashLiteral(Parser *parser) {
   Token token = parser->currentToken;
 
-  Expression **keys = NULL;
-  Expression **values = NULL;
-  int count = 0;
+  int mark = parser->scratchCount;
 
   while (!peekTokenIs(parser, RBRACE) && !peekTokenIs(parser, EOF_TOK)) {
     nextTokenParser(parser);
     Expression *key = parseExpression(parser, PREC_LOWEST);
 
     if (!expectPeek(parser, COLON)) {
+      parser->scratchCount = mark;
       return NULL;
     }
 
     nextTokenParser(parser);
     Expression *value = parseExpression(parser, PREC_LOWEST);
 
-    keys = realloc(keys, sizeof(Expression *) * (count + 1));
-    values = realloc(values, sizeof(Expression *) * (count + 1));
-    keys[count] = key;
-    values[count] = value;
-    count++;
+    scratchPush(parser, key);
+    scratchPush(parser, value);
 
     if (!peekTokenIs(parser, RBRACE) && !expectPeek(parser, COMMA)) {
+      parser->scratchCount = mark;
       return NULL;
     }
   }
 
   if (!expectPeek(parser, RBRACE)) {
+    parser->scratchCount = mark;
     return NULL;
   }
 
-  return wrapHashLiteral(newHashLiteral(token, keys, values, count));
+  // pairs were pushed interleaved; split them into the two arrays
+  int count = (parser->scratchCount - mark) / 2;
+  Expression **keys = astAlloc(parser->arena, sizeof(Expression *) * count);
+  Expression **values = astAlloc(parser->arena, sizeof(Expression *) * count);
+  for (int i = 0; i < count; i++) {
+    keys[i] = parser->scratch[mark + 2 * i];
+    values[i] = parser->scratch[mark + 2 * i + 1];
+  }
+  parser->scratchCount = mark;
+
+  return wrapHashLiteral(
+      parser->arena, newHashLiteral(parser->arena, token, keys, values, count));
 }
 Expression *parseIndexExpression(Parser *parser, Expression *left) {
   Token token = parser->currentToken;
@@ -486,41 +520,43 @@ Expression *parseIndexExpression(Parser *parser, Expression *left) {
     return NULL;
   }
 
-  return wrapIndexExpression(newIndexExpression(token, left, index));
+  return wrapIndexExpression(
+      parser->arena, newIndexExpression(parser->arena, token, left, index));
 }
 
 Expression *parseBoolean(Parser *parser) {
-  int value = strcmp(parser->currentToken.type, TRUE_TOK) == 0 ? 1 : 0;
-  return wrapBooleanLiteral(newBooleanLiteral(parser->currentToken, value));
+  int value = parser->currentToken.type == TRUE_TOK;
+  return wrapBooleanLiteral(
+      parser->arena,
+      newBooleanLiteral(parser->arena, parser->currentToken, value));
 }
 
-Expression **parseExpressionList(Parser *parser, const char *endToken,
+Expression **parseExpressionList(Parser *parser, TokenType endToken,
                                  int *count) {
-  Expression **args = NULL;
+  int mark = parser->scratchCount;
   *count = 0;
 
   if (peekTokenIs(parser, endToken)) {
     nextTokenParser(parser);
-    return args;
+    return NULL;
   }
 
   nextTokenParser(parser);
-  args = realloc(args, sizeof(Expression *) * (*count + 1));
-  args[(*count)++] = parseExpression(parser, PREC_LOWEST);
+  scratchPush(parser, parseExpression(parser, PREC_LOWEST));
 
   while (peekTokenIs(parser, COMMA)) {
     nextTokenParser(parser);
     nextTokenParser(parser);
-
-    args = realloc(args, sizeof(Expression *) * (*count + 1));
-    args[(*count)++] = parseExpression(parser, PREC_LOWEST);
+    scratchPush(parser, parseExpression(parser, PREC_LOWEST));
   }
 
   if (!expectPeek(parser, endToken)) {
+    *count = -1;
+    parser->scratchCount = mark;
     return NULL;
   }
 
-  return args;
+  return scratchFinish(parser, mark, count);
 }
 
 void printExpression(Expression *expr, int level, int isLast,
@@ -574,7 +610,7 @@ void printStatement(Statement *stmt, int level, int isLast,
 
   parentLevels[level - 1] = !isLast;
 
-  if (strcmp(stmt->type, NODE_LET_STATEMENT) == 0) {
+  if (stmt->type == NODE_LET_STATEMENT) {
     printIndent(level, isLast, parentLevels);
     printf("LetStatement\n");
 
@@ -584,21 +620,21 @@ void printStatement(Statement *stmt, int level, int isLast,
     if (stmt->letStatement->value) {
       printExpression(stmt->letStatement->value, level + 1, 1, parentLevels);
     }
-  } else if (strcmp(stmt->type, NODE_RETURN_STATEMENT) == 0) {
+  } else if (stmt->type == NODE_RETURN_STATEMENT) {
     printIndent(level, isLast, parentLevels);
     printf("ReturnStatement\n");
     if (stmt->returnStatement->return_value) {
       printExpression(stmt->returnStatement->return_value, level + 1, 1,
                       parentLevels);
     }
-  } else if (strcmp(stmt->type, NODE_EXPRESSION_STATEMENT) == 0) {
+  } else if (stmt->type == NODE_EXPRESSION_STATEMENT) {
     printIndent(level, isLast, parentLevels);
     printf("ExpressionStatement\n");
     if (stmt->expressionStatement->expression) {
       printExpression(stmt->expressionStatement->expression, level + 1, 1,
                       parentLevels);
     }
-  } else if (strcmp(stmt->type, NODE_BLOCK_STATEMENT) == 0) {
+  } else if (stmt->type == NODE_BLOCK_STATEMENT) {
     printIndent(level, isLast, parentLevels);
     printf("BlockStatement\n");
     for (int i = 0; i < stmt->blockStatement->count; i++) {
@@ -616,19 +652,19 @@ void printExpression(Expression *expr, int level, int isLast,
 
   parentLevels[level - 1] = !isLast;
 
-  if (strcmp(expr->type, NODE_IDENTIFIER) == 0) {
+  if (expr->type == NODE_IDENTIFIER) {
     printIndent(level, isLast, parentLevels);
     printf("Identifier: %s\n", expr->identifier->value);
-  } else if (strcmp(expr->type, NODE_INTEGER_LITERAL) == 0) {
+  } else if (expr->type == NODE_INTEGER_LITERAL) {
     printIndent(level, isLast, parentLevels);
     printf("IntegerLiteral: %lld\n", expr->integerLiteral->value);
-  } else if (strcmp(expr->type, NODE_STRING_LITERAL) == 0) {
+  } else if (expr->type == NODE_STRING_LITERAL) {
     printIndent(level, isLast, parentLevels);
     printf("StringLiteral: \"%s\"\n", expr->stringLiteral->value);
-  } else if (strcmp(expr->type, NODE_BOOLEAN) == 0) {
+  } else if (expr->type == NODE_BOOLEAN) {
     printIndent(level, isLast, parentLevels);
     printf("Boolean: %s\n", expr->booleanLiteral->value ? "true" : "false");
-  } else if (strcmp(expr->type, NODE_PREFIX_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_PREFIX_EXPRESSION) {
     printIndent(level, isLast, parentLevels);
     printf("PrefixExpression\n");
 
@@ -636,7 +672,7 @@ void printExpression(Expression *expr, int level, int isLast,
     printf("Operator: %s\n", expr->prefixExpression->op);
 
     printExpression(expr->prefixExpression->right, level + 1, 1, parentLevels);
-  } else if (strcmp(expr->type, NODE_INFIX_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_INFIX_EXPRESSION) {
     printIndent(level, isLast, parentLevels);
     printf("InfixExpression\n");
 
@@ -646,7 +682,7 @@ void printExpression(Expression *expr, int level, int isLast,
     printf("Operator: %s\n", expr->infixExpression->op);
 
     printExpression(expr->infixExpression->right, level + 1, 1, parentLevels);
-  } else if (strcmp(expr->type, NODE_IF_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_IF_EXPRESSION) {
     printIndent(level, isLast, parentLevels);
     printf("IfExpression\n");
 
@@ -666,7 +702,7 @@ void printExpression(Expression *expr, int level, int isLast,
       printBlockStatement(expr->ifExpression->alternative, level + 2, 1,
                          parentLevels);
     }
-  } else if (strcmp(expr->type, NODE_FUNCTION_LITERAL) == 0) {
+  } else if (expr->type == NODE_FUNCTION_LITERAL) {
     printIndent(level, isLast, parentLevels);
     printf("FunctionLiteral\n");
 
@@ -683,7 +719,7 @@ void printExpression(Expression *expr, int level, int isLast,
     printIndent(level + 1, 1, parentLevels);
     printf("Body:\n");
     printBlockStatement(expr->functionLiteral->body, level + 2, 1, parentLevels);
-  } else if (strcmp(expr->type, NODE_CALL_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_CALL_EXPRESSION) {
     printIndent(level, isLast, parentLevels);
     printf("CallExpression\n");
 
@@ -701,7 +737,7 @@ void printExpression(Expression *expr, int level, int isLast,
                         argIsLast, parentLevels);
       }
     }
-  } else if (strcmp(expr->type, NODE_ARRAY_LITERAL) == 0) {
+  } else if (expr->type == NODE_ARRAY_LITERAL) {
     printIndent(level, isLast, parentLevels);
     printf("ArrayLiteral\n");
     for (int i = 0; i < expr->arrayLiteral->count; i++) {
@@ -709,12 +745,12 @@ void printExpression(Expression *expr, int level, int isLast,
       printExpression(expr->arrayLiteral->elements[i], level + 1, arrayIsLast,
                       parentLevels);
     }
-  } else if (strcmp(expr->type, NODE_INDEX_EXPRESSION) == 0) {
+  } else if (expr->type == NODE_INDEX_EXPRESSION) {
     printIndent(level, isLast, parentLevels);
     printf("IndexExpression\n");
     printExpression(expr->indexExpression->left, level + 1, 0, parentLevels);
     printExpression(expr->indexExpression->index, level + 1, 1, parentLevels);
-  } else if (strcmp(expr->type, NODE_HASH_LITERAL) == 0) {
+  } else if (expr->type == NODE_HASH_LITERAL) {
     printIndent(level, isLast, parentLevels);
     printf("HashLiteral\n");
     for (int i = 0; i < expr->hashLiteral->count; i++) {
@@ -8,44 +8,41 @@ typedef struct Parser Parser;
 typedef Expression *(*PrefixParseFn)(Parser *);
 typedef Expression *(*InfixParseFn)(Parser *, Expression *);
 
-typedef struct {
-  const char *tokenType;
-  PrefixParseFn fn;
-} PrefixEntry;
-
-typedef struct {
-  const char *tokenType;
-  InfixParseFn fn;
-} InfixEntry;
-
-#define MAX_PARSE_FN_ENTRIES 64
-
 struct Parser {
   Lexer *lexer;
   Token currentToken;
   Token peekToken;
 
-  PrefixEntry prefixFns[MAX_PARSE_FN_ENTRIES];
-  int prefixCount;
-
-  InfixEntry infixFns[MAX_PARSE_FN_ENTRIES];
-  int infixCount;
+  // parse functions indexed by token type; NULL where none is registered
+  PrefixParseFn prefixFns[TOKEN_TYPE_COUNT];
+  InfixParseFn infixFns[TOKEN_TYPE_COUNT];
 
   char **errors;
   int errorCount;
+
+  // arena of the program being parsed
+  AstArena *arena;
+  // stack of child nodes for lists still being parsed; a finished list is
+  // copied into the arena in one piece, so nothing grows by realloc there
+  void **scratch;
+  int scratchCount;
+  int scratchCapacity;
 };
 
 Parser *newParser(Lexer *lexer);
 Program *parseProgram(Parser *parser);
+// parses one top-level statement into parser->arena, which the caller sets
+// up (and may reset between calls); returns NULL at the end of the input
+Statement *parseNextStatement(Parser *parser);
 char **parserErrors(Parser *parser, int *count);
-void registerPrefix(Parser *parser, const char *tokenType, PrefixParseFn fn);
-void registerInfix(Parser *parser, const char *tokenType, InfixParseFn fn);
-PrefixParseFn getPrefixFn(Parser *parser, const char *tokenType);
-InfixParseFn getInfixFn(Parser *parser, const char *tokenType);
+void registerPrefix(Parser *parser, TokenType tokenType, PrefixParseFn fn);
+void registerInfix(Parser *parser, TokenType tokenType, InfixParseFn fn);
+PrefixParseFn getPrefixFn(Parser *parser, TokenType tokenType);
+InfixParseFn getInfixFn(Parser *parser, TokenType tokenType);
 void nextTokenParser(Parser *parser);
-int currentTokenIs(Parser *parser, const char *type);
-int peekTokenIs(Parser *parser, const char *type);
-int expectPeek(Parser *parser, const char *type);
+int currentTokenIs(Parser *parser, TokenType type);
+int peekTokenIs(Parser *parser, TokenType type);
+int expectPeek(Parser *parser, TokenType type);
 void parserAddError(Parser *parser, const char *message);
 int peekPrecedence(Parser *parser);
 int currentPrecedence(Parser *parser);
@@ -68,7 +65,7 @@ Expression *parseStringLiteral(Parser *parser);
 Expression *parseArrayLiteral(Parser *parser);
 Expression *parseIndexExpression(Parser *parser, Expression *left);
 Expression *parseHashLiteral(Parser *parser);
-Expression **parseExpressionList(Parser *parser, const char *endToken,
+Expression **parseExpressionList(Parser *parser, TokenType endToken,
                                  int *count);
 void freeParser(Parser *parser);
 void printProgram(Program *program);
@@ -1,9 +1,12 @@
 #include "symbol.h"
+#include "../intern/intern.h"
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-// initial capacities for dynamic arrays
+// initial capacities for dynamic arrays; the store is an open-addressing
+// hash table, so its capacity stays a power of two
 #define INITIAL_STORE_CAPACITY 8
 #define INITIAL_FREE_CAPACITY 4
 
@@ -11,7 +14,7 @@
 SymbolTable *newSymbolTable() {
   SymbolTable *table = malloc(sizeof(SymbolTable));
   table->outer = NULL;
-  table->store = malloc(sizeof(SymbolStoreEntry) * INITIAL_STORE_CAPACITY);
+  table->store = calloc(INITIAL_STORE_CAPACITY, sizeof(SymbolStoreEntry));
   table->storeCount = 0;
   table->storeCapacity = INITIAL_STORE_CAPACITY;
   table->freeSymbols = malloc(sizeof(Symbol) * INITIAL_FREE_CAPACITY);
@@ -27,70 +30,105 @@ SymbolTable *newEnclosedSymbolTable(SymbolTable *outer) {
   return table;
 }
 
-// define a new symbol in the table with automatic scope detection
-Symbol define(SymbolTable *symbolTable, char *name) {
-  Symbol symbol;
-  symbol.name = strdup(name);
-  symbol.scope = symbolTable->outer ? LocalScope : GlobalScope;
-  symbol.index = symbolTable->numDefinitions++;
+// keys are interned, so the pointer itself is hashed
+static size_t hashKey(const char *key) {
+  uint64_t h = (uint64_t)(uintptr_t)key * 0x9e3779b97f4a7c15ull;
+  return (size_t)(h >> 32);
+}
+
+// the entry holding key, or the empty slot where it would go
+static SymbolStoreEntry *findEntry(SymbolStoreEntry *store, int capacity,
+                                   const char *key) {
+  size_t mask = capacity - 1;
+  for (size_t i = hashKey(key) & mask;; i = (i + 1) & mask) {
+    if (store[i].key == key || store[i].key == NULL) {
+      return &store[i];
+    }
+  }
+}
 
-  if (symbolTable->storeCount >= symbolTable->storeCapacity) {
-    symbolTable->storeCapacity *= 2;
-    symbolTable->store =
-        realloc(symbolTable->store,
-                sizeof(SymbolStoreEntry) * symbolTable->storeCapacity);
+static void growStore(SymbolTable *symbolTable) {
+  SymbolStoreEntry *old = symbolTable->store;
+  int oldCapacity = symbolTable->storeCapacity;
+
+  symbolTable->storeCapacity *= 2;
+  symbolTable->store =
+      calloc(symbolTable->storeCapacity, sizeof(SymbolStoreEntry));
+  for (int i = 0; i < oldCapacity; i++) {
+    if (old[i].key) {
+      *findEntry(symbolTable->store, symbolTable->storeCapacity, old[i].key) =
+          old[i];
+    }
   }
+  free(old);
+}
 
-  symbolTable->store[symbolTable->storeCount].key = strdup(name);
-  symbolTable->store[symbolTable->storeCount].value = symbol;
-  symbolTable->storeCount++;
+// adds the symbol, replacing an earlier one of the same name
+static void storeSymbol(SymbolTable *symbolTable, Symbol symbol) {
+  // keep the load factor at or below 1/2
+  if ((symbolTable->storeCount + 1) * 2 > symbolTable->storeCapacity) {
+    growStore(symbolTable);
+  }
 
+  SymbolStoreEntry *entry = findEntry(
+      symbolTable->store, symbolTable->storeCapacity, symbol.name);
+  if (!entry->key) {
+    entry->key = symbol.name;
+    symbolTable->storeCount++;
+  }
+  entry->value = symbol;
+}
+
+static SymbolStoreEntry *lookup(SymbolTable *symbolTable, const char *name) {
+  SymbolStoreEntry *entry =
+      findEntry(symbolTable->store, symbolTable->storeCapacity, name);
+  return entry->key ? entry : NULL;
+}
+
+// define a new symbol in the table with automatic scope detection
+Symbol defineInterned(SymbolTable *symbolTable, const char *name) {
+  Symbol symbol;
+  symbol.name = name;
+  symbol.scope = symbolTable->outer ? LocalScope : GlobalScope;
+  symbol.index = symbolTable->numDefinitions++;
+  storeSymbol(symbolTable, symbol);
   return symbol;
 }
 
-Symbol defineBuiltin(SymbolTable *symbolTable, char *name, int index) {
+Symbol define(SymbolTable *symbolTable, const char *name) {
+  return defineInterned(symbolTable, internString(name));
+}
+
+Symbol defineBuiltin(SymbolTable *symbolTable, const char *name, int index) {
   Symbol symbol;
-  symbol.name = strdup(name);
+  symbol.name = internString(name);
   symbol.scope = BuiltinScope;
   symbol.index = index;
-
-  if (symbolTable->storeCount >= symbolTable->storeCapacity) {
-    symbolTable->storeCapacity *= 2;
-    symbolTable->store =
-        realloc(symbolTable->store,
-                sizeof(SymbolStoreEntry) * symbolTable->storeCapacity);
-  }
-
-  symbolTable->store[symbolTable->storeCount].key = strdup(name);
-  symbolTable->store[symbolTable->storeCount].value = symbol;
-  symbolTable->storeCount++;
-
+  storeSymbol(symbolTable, symbol);
   return symbol;
 }
 
-int resolve(SymbolTable *symbolTable, char *name, Symbol *out) {
-  for (int i = 0; i < symbolTable->storeCount; i++) {
-    if (strcmp(symbolTable->store[i].key, name) == 0) {
-      *out = symbolTable->store[i].value;
-      return 0;
-    }
+int resolveInterned(SymbolTable *symbolTable, const char *name, Symbol *out) {
+  SymbolStoreEntry *entry = lookup(symbolTable, name);
+  if (entry) {
+    *out = entry->value;
+    return 0;
   }
   if (symbolTable->outer != NULL) {
     // First check if the symbol exists directly in the immediate outer scope
-    for (int i = 0; i < symbolTable->outer->storeCount; i++) {
-      if (strcmp(symbolTable->outer->store[i].key, name) == 0) {
-        Symbol directSymbol = symbolTable->outer->store[i].value;
-        if (strcmp(directSymbol.scope, GlobalScope) == 0 ||
-            strcmp(directSymbol.scope, BuiltinScope) == 0) {
-          *out = directSymbol;
-          return 0;
-        }
+    SymbolStoreEntry *direct = lookup(symbolTable->outer, name);
+    if (direct) {
+      Symbol directSymbol = direct->value;
+      if (strcmp(directSymbol.scope, GlobalScope) == 0 ||
+          strcmp(directSymbol.scope, BuiltinScope) == 0) {
+        *out = directSymbol;
+        return 0;
       }
     }
-    
+
     // If not found directly, resolve recursively
     Symbol outerSymbol;
-    if (resolve(symbolTable->outer, name, &outerSymbol) == 0) {
+    if (resolveInterned(symbolTable->outer, name, &outerSymbol) == 0) {
       if (strcmp(outerSymbol.scope, BuiltinScope) == 0) {
         *out = outerSymbol;
         return 0;
@@ -104,9 +142,18 @@ int resolve(SymbolTable *symbolTable, char *name, Symbol *out) {
   return -1; // not found
 }
 
+int resolve(SymbolTable *symbolTable, const char *name, Symbol *out) {
+  // a name that was never interned cannot have been defined anywhere
+  const char *interned = internLookup(name, strlen(name));
+  if (!interned) {
+    return -1;
+  }
+  return resolveInterned(symbolTable, interned, out);
+}
+
 Symbol defineFree(SymbolTable *symbolTable, Symbol original) {
   Symbol sym;
-  sym.name = strdup(original.name);
+  sym.name = original.name;
   sym.scope = FreeScope;
   sym.index = symbolTable->freeSymbolCount;
 
@@ -118,7 +165,7 @@ Symbol defineFree(SymbolTable *symbolTable, Symbol original) {
   }
 
   Symbol originalCopy;
-  originalCopy.name = strdup(original.name);
+  originalCopy.name = original.name;
   originalCopy.scope = original.scope;
   originalCopy.index = original.index;
   symbolTable->freeSymbols[symbolTable->freeSymbolCount++] = originalCopy;
@@ -127,14 +174,8 @@ Symbol defineFree(SymbolTable *symbolTable, Symbol original) {
 }
 
 void freeSymbolTable(SymbolTable *table) {
-  for (int i = 0; i < table->storeCount; i++) {
-    free(table->store[i].key);
-    free(table->store[i].value.name);
-  }
+  // names belong to the interner
   free(table->store);
-  for (int i = 0; i < table->freeSymbolCount; i++) {
-    free(table->freeSymbols[i].name);
-  }
   free(table->freeSymbols);
   free(table);
 }
@@ -8,14 +8,15 @@ typedef char *SymbolScope;
 #define BuiltinScope "Builtin"
 #define FreeScope "Free"
 
+// names are interned (see intern/intern.h), so symbols compare them with ==
 typedef struct {
-  char *name;
+  const char *name;
   SymbolScope scope;
   int index;
 } Symbol;
 
 typedef struct {
-  char *key;
+  const char *key;
   Symbol value;
 } SymbolStoreEntry;
 
@@ -24,6 +25,8 @@ typedef struct SymbolTable SymbolTable;
 struct SymbolTable {
   SymbolTable *outer;
 
+  // open-addressing hash table keyed by the interned name; a NULL key
+  // marks an empty slot
   SymbolStoreEntry *store;
   int storeCount;
   int storeCapacity;
@@ -37,9 +40,15 @@ struct SymbolTable {
 
 SymbolTable *newSymbolTable();
 SymbolTable *newEnclosedSymbolTable(SymbolTable *outer);
-Symbol define(SymbolTable *symbolTable, char *name);
-Symbol defineBuiltin(SymbolTable *symbolTable, char *name, int index);
-int resolve(SymbolTable *symbolTable, char *name, Symbol *out);
+// name must already be interned, as the parser's identifiers are; it is
+// stored and compared as is, by pointer
+Symbol defineInterned(SymbolTable *symbolTable, const char *name);
+int resolveInterned(SymbolTable *symbolTable, const char *name, Symbol *out);
+// for names that may not be interned yet, which are looked up in the
+// interner first
+Symbol define(SymbolTable *symbolTable, const char *name);
+Symbol defineBuiltin(SymbolTable *symbolTable, const char *name, int index);
+int resolve(SymbolTable *symbolTable, const char *name, Symbol *out);
 Symbol defineFree(SymbolTable *symbolTable, Symbol original);
 void freeSymbolTable(SymbolTable *table);
 
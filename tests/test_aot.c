@@ -0,0 +1,87 @@
+#include "../aot/aot.h"
+#include "../compiler/compiler.h"
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char *generate(char *input, int *result) {
+  Lexer *lexer = newLexer(input);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+
+  Compiler *compiler = newCompiler();
+  assert(compileProgram(compiler, program) == 0);
+  ByteCode *bytecode = getByteCode(compiler);
+
+  unsigned char serialized[] = {0, 0, 0, 0};
+  FILE *out = tmpfile();
+  assert(out != NULL);
+  *result = aotGenerate(out, bytecode, serialized, sizeof(serialized), 0);
+
+  long size = ftell(out);
+  rewind(out);
+  char *source = calloc(size + 1, 1);
+  assert(fread(source, 1, size, out) == (size_t)size);
+  fclose(out);
+  return source;
+}
+
+void testGenerateStraightLine() {
+  printf("Testing aot straight-line code...\n");
+
+  int result;
+  char *source = generate("1 + 2", &result);
+  assert(result == 0);
+
+  assert(strstr(source, "#include \"aot_runtime.h\"") != NULL);
+  assert(strstr(source, "static int fn_main(struct VM *vm, int bp)") != NULL);
+  assert(strstr(source, "executeConstant(vm, 0)") != NULL);
+  assert(strstr(source, "executeConstant(vm, 1)") != NULL);
+  assert(strstr(source, "executeBinaryOperation(vm, 2)") != NULL);
+  assert(strstr(source, "goto") == NULL);
+
+  free(source);
+  printf("✓ Straight-line code test passed\n");
+}
+
+void testGenerateJumpsAndFunctions() {
+  printf("Testing aot jumps and functions...\n");
+
+  int result;
+  char *source = generate("let f = fn(x) { if (x > 1) { x } else { 1 } }; f(3)",
+                          &result);
+  assert(result == 0);
+
+  // the function literal is constant 2 after the literals 1 and 1
+  assert(strstr(source, "static int fn_2(struct VM *vm, int bp)") != NULL);
+  assert(strstr(source, "aotRegister(vm, 2, fn_2);") != NULL);
+  assert(strstr(source, "if (!executeJumpCondition(vm)) goto L_") != NULL);
+  assert(strstr(source, "return executeReturnValue(vm, bp);") != NULL);
+  assert(strstr(source, "executeGetLocal(vm, bp, 0)") != NULL);
+  assert(strstr(source, "runCall(vm, 1)") != NULL);
+
+  // every goto has a matching label
+  char *p = source;
+  while ((p = strstr(p, "goto L_")) != NULL) {
+    int target = atoi(p + strlen("goto L_"));
+    char label[32];
+    snprintf(label, sizeof(label), "L_%d:;", target);
+    assert(strstr(source, label) != NULL);
+    p++;
+  }
+
+  free(source);
+  printf("✓ Jumps and functions test passed\n");
+}
+
+int main() {
+  printf("🚀 Starting AOT tests...\n\n");
+  testGenerateStraightLine();
+  testGenerateJumpsAndFunctions();
+
+  printf("\n🎉 All AOT tests passed!\n");
+  return 0;
+}
@@ -5,29 +5,32 @@
 
 #include "../ast/ast.h"
 #include "../lexer/lexer.h"
+#include "../parser/parser.h"
 #include "../token/token.h"
 
-Token makeToken(const char *type, const char *literal) {
+Token makeToken(TokenType type, const char *literal) {
   Token tok;
-  tok.type = (char *)type;
-  tok.literal = strdup(literal);
+  tok.type = type;
+  tok.start = strdup(literal);
+  tok.length = strlen(literal);
   return tok;
 }
 
 void testLetStatement() {
+  AstArena *arena = newAstArena();
   Token tok = makeToken(LET, "let");
   Token nameTok = makeToken(IDENTIFIER, "myVar");
   Token valTok = makeToken(INT, "5");
 
-  Identifier *name = newIdentifier(nameTok, "myVar");
-  IntegerLiteral *value = newIntegerLiteral(valTok, 5);
-  LetStatement *letStmt = newLetStatement(tok, name, wrapIntegerLiteral(value));
+  Identifier *name = newIdentifier(arena, nameTok, "myVar");
+  IntegerLiteral *value = newIntegerLiteral(arena, valTok, 5);
+  LetStatement *letStmt =
+      newLetStatement(arena, tok, name, wrapIntegerLiteral(arena, value));
 
-  Program *program = malloc(sizeof(Program));
-  program->type = NODE_PROGRAM;
+  Program *program = newProgram(arena);
   program->statementCount = 1;
-  program->statements = malloc(sizeof(Statement *) * 1);
-  program->statements[0] = wrapLetStatement(letStmt);
+  program->statements = astAlloc(arena, sizeof(Statement *) * 1);
+  program->statements[0] = wrapLetStatement(arena, letStmt);
 
   char *out = programToString(program);
   printf("✅ LetStatement: %s\n", out);
@@ -38,17 +41,18 @@ void testLetStatement() {
 }
 
 void testReturnStatement() {
+  AstArena *arena = newAstArena();
   Token tok = makeToken(RETURN, "return");
   Token valTok = makeToken(INT, "10");
 
-  IntegerLiteral *value = newIntegerLiteral(valTok, 10);
-  ReturnStatement *ret = newReturnStatement(tok, wrapIntegerLiteral(value));
+  IntegerLiteral *value = newIntegerLiteral(arena, valTok, 10);
+  ReturnStatement *ret =
+      newReturnStatement(arena, tok, wrapIntegerLiteral(arena, value));
 
-  Program *program = malloc(sizeof(Program));
-  program->type = NODE_PROGRAM;
+  Program *program = newProgram(arena);
   program->statementCount = 1;
-  program->statements = malloc(sizeof(Statement *) * 1);
-  program->statements[0] = wrapReturnStatement(ret);
+  program->statements = astAlloc(arena, sizeof(Statement *) * 1);
+  program->statements[0] = wrapReturnStatement(arena, ret);
 
   char *out = programToString(program);
   printf("✅ ReturnStatement: %s\n", out);
@@ -59,24 +63,27 @@ void testReturnStatement() {
 }
 
 void testInfixExpression() {
+  AstArena *arena = newAstArena();
   Token letTok = makeToken(LET, "let");
   Token nameTok = makeToken(IDENTIFIER, "result");
   Token intTokLeft = makeToken(INT, "1");
   Token intTokRight = makeToken(INT, "2");
   Token plusTok = makeToken(PLUS, "+");
 
-  Expression *left = wrapIntegerLiteral(newIntegerLiteral(intTokLeft, 1));
-  Expression *right = wrapIntegerLiteral(newIntegerLiteral(intTokRight, 2));
-  InfixExpression *infix = newInfixExpression(plusTok, left, "+", right);
+  Expression *left =
+      wrapIntegerLiteral(arena, newIntegerLiteral(arena, intTokLeft, 1));
+  Expression *right =
+      wrapIntegerLiteral(arena, newIntegerLiteral(arena, intTokRight, 2));
+  InfixExpression *infix = newInfixExpression(arena, plusTok, left, "+", right);
 
-  LetStatement *stmt = newLetStatement(letTok, newIdentifier(nameTok, "result"),
-                                       wrapInfixExpression(infix));
+  LetStatement *stmt =
+      newLetStatement(arena, letTok, newIdentifier(arena, nameTok, "result"),
+                      wrapInfixExpression(arena, infix));
 
-  Program *program = malloc(sizeof(Program));
-  program->type = NODE_PROGRAM;
+  Program *program = newProgram(arena);
   program->statementCount = 1;
-  program->statements = malloc(sizeof(Statement *));
-  program->statements[0] = wrapLetStatement(stmt);
+  program->statements = astAlloc(arena, sizeof(Statement *) * 1);
+  program->statements[0] = wrapLetStatement(arena, stmt);
 
   char *out = programToString(program);
   printf("✅ InfixExpression: %s\n", out);
@@ -87,32 +94,33 @@ void testInfixExpression() {
 }
 
 void testIfExpression() {
+  AstArena *arena = newAstArena();
   Token ifTok = makeToken(IF, "if");
   Token ltTok = makeToken(LT, "<");
   Token xTok = makeToken(IDENTIFIER, "x");
   Token yTok = makeToken(IDENTIFIER, "y");
 
-  Expression *x = wrapIdentifier(newIdentifier(xTok, "x"));
-  Expression *y = wrapIdentifier(newIdentifier(yTok, "y"));
-  InfixExpression *cond = newInfixExpression(ltTok, x, "<", y);
+  Expression *x = wrapIdentifier(arena, newIdentifier(arena, xTok, "x"));
+  Expression *y = wrapIdentifier(arena, newIdentifier(arena, yTok, "y"));
+  InfixExpression *cond = newInfixExpression(arena, ltTok, x, "<", y);
 
   Token returnTok = makeToken(RETURN, "return");
-  Expression *xRet = wrapIdentifier(newIdentifier(xTok, "x"));
-  ReturnStatement *ret = newReturnStatement(returnTok, xRet);
-  Statement **stmts = malloc(sizeof(Statement *));
-  stmts[0] = wrapReturnStatement(ret);
-  BlockStatement *block = newBlockStatement(makeToken(LBRACE, "{"), stmts, 1);
-
-  IfExpression *ifExpr =
-      newIfExpression(ifTok, wrapInfixExpression(cond), block, NULL);
+  Expression *xRet = wrapIdentifier(arena, newIdentifier(arena, xTok, "x"));
+  ReturnStatement *ret = newReturnStatement(arena, returnTok, xRet);
+  Statement **stmts = astAlloc(arena, sizeof(Statement *));
+  stmts[0] = wrapReturnStatement(arena, ret);
+  BlockStatement *block =
+      newBlockStatement(arena, makeToken(LBRACE, "{"), stmts, 1);
+
+  IfExpression *ifExpr = newIfExpression(
+      arena, ifTok, wrapInfixExpression(arena, cond), block, NULL);
   ExpressionStatement *exprStmt =
-      newExpressionStatement(ifTok, wrapIfExpression(ifExpr));
+      newExpressionStatement(arena, ifTok, wrapIfExpression(arena, ifExpr));
 
-  Program *program = malloc(sizeof(Program));
-  program->type = NODE_PROGRAM;
+  Program *program = newProgram(arena);
   program->statementCount = 1;
-  program->statements = malloc(sizeof(Statement *));
-  program->statements[0] = wrapExpressionStatement(exprStmt);
+  program->statements = astAlloc(arena, sizeof(Statement *) * 1);
+  program->statements[0] = wrapExpressionStatement(arena, exprStmt);
 
   char *out = programToString(program);
   printf("✅ IfExpression: %s\n", out);
@@ -123,33 +131,36 @@ void testIfExpression() {
 }
 
 void testFunctionLiteral() {
+  AstArena *arena = newAstArena();
   Token fnTok = makeToken(FUNCTION, "fn");
   Token xTok = makeToken(IDENTIFIER, "x");
   Token yTok = makeToken(IDENTIFIER, "y");
 
-  Identifier **params = malloc(sizeof(Identifier *) * 2);
-  params[0] = newIdentifier(xTok, "x");
-  params[1] = newIdentifier(yTok, "y");
+  Identifier **params = astAlloc(arena, sizeof(Identifier *) * 2);
+  params[0] = newIdentifier(arena, xTok, "x");
+  params[1] = newIdentifier(arena, yTok, "y");
 
   Token retTok = makeToken(RETURN, "return");
   InfixExpression *sum =
-      newInfixExpression(makeToken(PLUS, "+"), wrapIdentifier(params[0]), "+",
-                         wrapIdentifier(params[1]));
-
-  ReturnStatement *ret = newReturnStatement(retTok, wrapInfixExpression(sum));
-  Statement **stmts = malloc(sizeof(Statement *));
-  stmts[0] = wrapReturnStatement(ret);
-  BlockStatement *body = newBlockStatement(makeToken(LBRACE, "{"), stmts, 1);
-
-  FunctionLiteral *fn = newFunctionLiteral(fnTok, params, 2, body);
+      newInfixExpression(arena, makeToken(PLUS, "+"),
+                         wrapIdentifier(arena, params[0]), "+",
+                         wrapIdentifier(arena, params[1]));
+
+  ReturnStatement *ret =
+      newReturnStatement(arena, retTok, wrapInfixExpression(arena, sum));
+  Statement **stmts = astAlloc(arena, sizeof(Statement *));
+  stmts[0] = wrapReturnStatement(arena, ret);
+  BlockStatement *body =
+      newBlockStatement(arena, makeToken(LBRACE, "{"), stmts, 1);
+
+  FunctionLiteral *fn = newFunctionLiteral(arena, fnTok, params, 2, body);
   ExpressionStatement *exprStmt =
-      newExpressionStatement(fnTok, wrapFunctionLiteral(fn));
+      newExpressionStatement(arena, fnTok, wrapFunctionLiteral(arena, fn));
 
-  Program *program = malloc(sizeof(Program));
-  program->type = NODE_PROGRAM;
+  Program *program = newProgram(arena);
   program->statementCount = 1;
-  program->statements = malloc(sizeof(Statement *));
-  program->statements[0] = wrapExpressionStatement(exprStmt);
+  program->statements = astAlloc(arena, sizeof(Statement *) * 1);
+  program->statements[0] = wrapExpressionStatement(arena, exprStmt);
 
   char *out = programToString(program);
   printf("✅ FunctionLiteral: %s\n", out);
@@ -160,6 +171,7 @@ void testFunctionLiteral() {
 }
 
 void testFullProgramAst() {
+  AstArena *arena = newAstArena();
   const char *source = "let add = fn(x, y) {\n"
                        "  if (x < y) {\n"
                        "    return x;\n"
@@ -176,76 +188,80 @@ void testFullProgramAst() {
   while (1) {
     Token tok = nextToken(lexer);
     tokens[count++] = tok;
-    if (strcmp(tok.type, EOF_TOK) == 0)
+    if (tok.type == EOF_TOK)
       break;
   }
 
-  Identifier *param1 = newIdentifier(cloneToken(tokens[5]), tokens[5].literal);
-  Identifier *param2 = newIdentifier(cloneToken(tokens[7]), tokens[7].literal);
-  Identifier **params = malloc(sizeof(Identifier *) * 2);
+  Identifier *param1 = newIdentifierFromToken(arena, tokens[5]);
+  Identifier *param2 = newIdentifierFromToken(arena, tokens[7]);
+  Identifier **params = astAlloc(arena, sizeof(Identifier *) * 2);
   params[0] = param1;
   params[1] = param2;
 
   Expression *left =
-      wrapIdentifier(newIdentifier(cloneToken(tokens[12]), tokens[12].literal));
+      wrapIdentifier(arena, newIdentifierFromToken(arena, tokens[12]));
   Expression *right =
-      wrapIdentifier(newIdentifier(cloneToken(tokens[14]), tokens[14].literal));
+      wrapIdentifier(arena, newIdentifierFromToken(arena, tokens[14]));
   InfixExpression *cond =
-      newInfixExpression(cloneToken(tokens[13]), left, "<", right);
+      newInfixExpression(arena, cloneToken(tokens[13]), left, "<", right);
 
   Expression *retVal1 =
-      wrapIdentifier(newIdentifier(cloneToken(tokens[19]), tokens[19].literal));
-  ReturnStatement *ret1 = newReturnStatement(cloneToken(tokens[18]), retVal1);
-  Statement **cons = malloc(sizeof(Statement *));
-  cons[0] = wrapReturnStatement(ret1);
+      wrapIdentifier(arena, newIdentifierFromToken(arena, tokens[19]));
+  ReturnStatement *ret1 =
+      newReturnStatement(arena, cloneToken(tokens[18]), retVal1);
+  Statement **cons = astAlloc(arena, sizeof(Statement *));
+  cons[0] = wrapReturnStatement(arena, ret1);
   BlockStatement *consequence =
-      newBlockStatement(cloneToken(tokens[17]), cons, 1);
+      newBlockStatement(arena, cloneToken(tokens[17]), cons, 1);
 
   Expression *retVal2 =
-      wrapIdentifier(newIdentifier(cloneToken(tokens[26]), tokens[26].literal));
-  ReturnStatement *ret2 = newReturnStatement(cloneToken(tokens[25]), retVal2);
-  Statement **alts = malloc(sizeof(Statement *));
-  alts[0] = wrapReturnStatement(ret2);
+      wrapIdentifier(arena, newIdentifierFromToken(arena, tokens[26]));
+  ReturnStatement *ret2 =
+      newReturnStatement(arena, cloneToken(tokens[25]), retVal2);
+  Statement **alts = astAlloc(arena, sizeof(Statement *));
+  alts[0] = wrapReturnStatement(arena, ret2);
   BlockStatement *alternative =
-      newBlockStatement(cloneToken(tokens[24]), alts, 1);
+      newBlockStatement(arena, cloneToken(tokens[24]), alts, 1);
 
-  IfExpression *ifExpr =
-      newIfExpression(cloneToken(tokens[10]), wrapInfixExpression(cond),
-                      consequence, alternative);
-  Statement **bodyStmts = malloc(sizeof(Statement *));
+  IfExpression *ifExpr = newIfExpression(arena, cloneToken(tokens[10]),
+                                         wrapInfixExpression(arena, cond),
+                                         consequence, alternative);
+  Statement **bodyStmts = astAlloc(arena, sizeof(Statement *));
   bodyStmts[0] = wrapExpressionStatement(
-      newExpressionStatement(cloneToken(tokens[10]), wrapIfExpression(ifExpr)));
+      arena, newExpressionStatement(arena, cloneToken(tokens[10]),
+                                    wrapIfExpression(arena, ifExpr)));
   BlockStatement *fnBody =
-      newBlockStatement(cloneToken(tokens[9]), bodyStmts, 1);
+      newBlockStatement(arena, cloneToken(tokens[9]), bodyStmts, 1);
 
   FunctionLiteral *fn =
-      newFunctionLiteral(cloneToken(tokens[3]), params, 2, fnBody);
+      newFunctionLiteral(arena, cloneToken(tokens[3]), params, 2, fnBody);
 
   Identifier *addIdent =
-      newIdentifier(cloneToken(tokens[1]), tokens[1].literal);
-  LetStatement *let =
-      newLetStatement(cloneToken(tokens[0]), addIdent, wrapFunctionLiteral(fn));
+      newIdentifierFromToken(arena, tokens[1]);
+  LetStatement *let = newLetStatement(arena, cloneToken(tokens[0]), addIdent,
+                                      wrapFunctionLiteral(arena, fn));
 
   Token calleeTok = cloneToken(tokens[29]);
   Expression *callee =
-      wrapIdentifier(newIdentifier(calleeTok, calleeTok.literal));
+      wrapIdentifier(arena, newIdentifierFromToken(arena, calleeTok));
 
-  Expression **args = malloc(sizeof(Expression *) * 2);
+  Expression **args = astAlloc(arena, sizeof(Expression *) * 2);
   args[0] = wrapIntegerLiteral(
-      newIntegerLiteral(cloneToken(tokens[31]), atoi(tokens[31].literal)));
+      arena, newIntegerLiteral(arena, cloneToken(tokens[31]),
+                               atoi(tokens[31].start)));
   args[1] = wrapIntegerLiteral(
-      newIntegerLiteral(cloneToken(tokens[33]), atoi(tokens[33].literal)));
+      arena, newIntegerLiteral(arena, cloneToken(tokens[33]),
+                               atoi(tokens[33].start)));
   CallExpression *call =
-      newCallExpression(cloneToken(tokens[29]), callee, args, 2);
-  ExpressionStatement *callStmt =
-      newExpressionStatement(cloneToken(tokens[29]), wrapCallExpression(call));
+      newCallExpression(arena, cloneToken(tokens[29]), callee, args, 2);
+  ExpressionStatement *callStmt = newExpressionStatement(
+      arena, cloneToken(tokens[29]), wrapCallExpression(arena, call));
 
-  Program *program = malloc(sizeof(Program));
-  program->type = NODE_PROGRAM;
+  Program *program = newProgram(arena);
   program->statementCount = 2;
-  program->statements = malloc(sizeof(Statement *) * 2);
-  program->statements[0] = wrapLetStatement(let);
-  program->statements[1] = wrapExpressionStatement(callStmt);
+  program->statements = astAlloc(arena, sizeof(Statement *) * 2);
+  program->statements[0] = wrapLetStatement(arena, let);
+  program->statements[1] = wrapExpressionStatement(arena, callStmt);
 
   char *out = programToString(program);
   printf("✅ Full Program AST: %s\n", out);
@@ -256,6 +272,37 @@ void testFullProgramAst() {
   freeProgram(program);
 }
 
+// the initializer of each let, parsed from source
+void testExpressionCalls() {
+  struct {
+    const char *input;
+    bool calls;
+  } tests[] = {
+      {"let a = 1 + 2 * 3;", false},
+      {"let a = [1, -b, {\"k\": c[0]}];", false},
+      {"let a = fn(x) { puts(x) };", false},
+      {"let a = puts(\"side effect\");", true},
+      {"let a = [1, len(b)];", true},
+      {"let a = {\"k\": 1 + f()};", true},
+      {"let a = b[first(c)];", true},
+      {"let a = if (b) { 1 } else { let c = g(); c };", true},
+      {"let a = fn() { 1 }();", true},
+  };
+  int count = sizeof(tests) / sizeof(tests[0]);
+  for (int i = 0; i < count; i++) {
+    Lexer *lexer = newLexer((char *)tests[i].input);
+    Parser *parser = newParser(lexer);
+    Program *program = parseProgram(parser);
+    assert(parser->errorCount == 0);
+    assert(program->statements[0]->type == NODE_LET_STATEMENT);
+    assert(expressionCalls(program->statements[0]->letStatement->value) ==
+           tests[i].calls);
+    freeProgram(program);
+    freeParser(parser);
+  }
+  printf("✅ expressionCalls: %d initializers\n", count);
+}
+
 int main() {
   testLetStatement();
   testReturnStatement();
@@ -263,6 +310,7 @@ int main() {
   testIfExpression();
   testFunctionLiteral();
   testFullProgramAst();
+  testExpressionCalls();
   printf("✅ All AST tests passed\n");
   return 0;
 }
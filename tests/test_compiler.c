@@ -406,17 +406,9 @@ void testArrayLiterals() {
   CompilerTestCase tests[] = {
       {"[]", NULL, 0,
        (ExpectedInstruction[]){{OpArray, {0}, 1}, {OpPop, {}, 0}}, 2},
-      {"[1, 2, 3]",
-       (ExpectedConstant[]){{{IntegerObj, .integer = &(Integer){1}}},
-                            {{IntegerObj, .integer = &(Integer){2}}},
-                            {{IntegerObj, .integer = &(Integer){3}}}},
-       3,
-       (ExpectedInstruction[]){{OpConstant, {0}, 1},
-                               {OpConstant, {1}, 1},
-                               {OpConstant, {2}, 1},
-                               {OpArray, {3}, 1},
-                               {OpPop, {}, 0}},
-       5},
+      // literals of literals are built once, into the constant pool
+      {"[1, 2, 3]", (ExpectedConstant[]){{{ArrayObj}}}, 1,
+       (ExpectedInstruction[]){{OpConstant, {0}, 1}, {OpPop, {}, 0}}, 2},
       {"[1 + 2, 3 - 4, 5 * 6]",
        (ExpectedConstant[]){{{IntegerObj, .integer = &(Integer){1}}},
                             {{IntegerObj, .integer = &(Integer){2}}},
@@ -436,9 +428,25 @@ void testArrayLiterals() {
                                {OpMul, {}, 0},
                                {OpArray, {3}, 1},
                                {OpPop, {}, 0}},
-       11}};
+       11},
+      {"[1, [2, \"two\"], {true: [3]}, 4 - 5]",
+       (ExpectedConstant[]){{{IntegerObj, .integer = &(Integer){1}}},
+                            {{ArrayObj}},
+                            {{HashObj}},
+                            {{IntegerObj, .integer = &(Integer){4}}},
+                            {{IntegerObj, .integer = &(Integer){5}}}},
+       5,
+       (ExpectedInstruction[]){{OpConstant, {0}, 1},
+                               {OpConstant, {1}, 1},
+                               {OpConstant, {2}, 1},
+                               {OpConstant, {3}, 1},
+                               {OpConstant, {4}, 1},
+                               {OpSub, {}, 0},
+                               {OpArray, {4}, 1},
+                               {OpPop, {}, 0}},
+       8}};
 
-  for (int i = 0; i < 3; i++) {
+  for (int i = 0; i < 4; i++) {
     CompilerTestCase test = tests[i];
     printf("  Testing: %s\n", test.input);
 
@@ -472,25 +480,100 @@ void testHashLiterals() {
   CompilerTestCase tests[] = {
       {"{}", NULL, 0, (ExpectedInstruction[]){{OpHash, {0}, 1}, {OpPop, {}, 0}},
        2},
-      {"{1: 2, 3: 4, 5: 6}",
+      {"{1: 2, 3: 4, 5: 6}", (ExpectedConstant[]){{{HashObj}}}, 1,
+       (ExpectedInstruction[]){{OpConstant, {0}, 1}, {OpPop, {}, 0}}, 2},
+      // keys that are not literals keep the pairs on the stack
+      {"{1: 2 + 3, [4]: 5}",
        (ExpectedConstant[]){{{IntegerObj, .integer = &(Integer){1}}},
                             {{IntegerObj, .integer = &(Integer){2}}},
                             {{IntegerObj, .integer = &(Integer){3}}},
-                            {{IntegerObj, .integer = &(Integer){4}}},
-                            {{IntegerObj, .integer = &(Integer){5}}},
-                            {{IntegerObj, .integer = &(Integer){6}}}},
-       6,
+                            {{ArrayObj}},
+                            {{IntegerObj, .integer = &(Integer){5}}}},
+       5,
+       (ExpectedInstruction[]){{OpConstant, {0}, 1},
+                               {OpConstant, {1}, 1},
+                               {OpConstant, {2}, 1},
+                               {OpAdd, {}, 0},
+                               {OpConstant, {3}, 1},
+                               {OpConstant, {4}, 1},
+                               {OpHash, {4}, 1},
+                               {OpPop, {}, 0}},
+       8},
+      // string keys with runtime values share a shape constant
+      {"{\"a\": 1 + 2, \"b\": true}",
+       (ExpectedConstant[]){{{HashObj}},
+                            {{IntegerObj, .integer = &(Integer){1}}},
+                            {{IntegerObj, .integer = &(Integer){2}}}},
+       3,
+       (ExpectedInstruction[]){{OpConstant, {1}, 1},
+                               {OpConstant, {2}, 1},
+                               {OpAdd, {}, 0},
+                               {OpTrue, {}, 0},
+                               {OpRecord, {0}, 1},
+                               {OpPop, {}, 0}},
+       6},
+      // unless a key repeats
+      {"{\"a\": 1 + 2, \"a\": 3}",
+       (ExpectedConstant[]){{{StringObj}},
+                            {{IntegerObj, .integer = &(Integer){1}}},
+                            {{IntegerObj, .integer = &(Integer){2}}},
+                            {{StringObj}},
+                            {{IntegerObj, .integer = &(Integer){3}}}},
+       5,
        (ExpectedInstruction[]){{OpConstant, {0}, 1},
                                {OpConstant, {1}, 1},
                                {OpConstant, {2}, 1},
+                               {OpAdd, {}, 0},
+                               {OpConstant, {3}, 1},
+                               {OpConstant, {4}, 1},
+                               {OpHash, {4}, 1},
+                               {OpPop, {}, 0}},
+       8},
+      // literals with the same keys in the same order share one shape
+      {"[{\"a\": 1 + 2, \"b\": true}, {\"a\": true, \"b\": 3 + 4}]",
+       (ExpectedConstant[]){{{HashObj}},
+                            {{IntegerObj, .integer = &(Integer){1}}},
+                            {{IntegerObj, .integer = &(Integer){2}}},
+                            {{IntegerObj, .integer = &(Integer){3}}},
+                            {{IntegerObj, .integer = &(Integer){4}}}},
+       5,
+       (ExpectedInstruction[]){{OpConstant, {1}, 1},
+                               {OpConstant, {2}, 1},
+                               {OpAdd, {}, 0},
+                               {OpTrue, {}, 0},
+                               {OpRecord, {0}, 1},
+                               {OpTrue, {}, 0},
                                {OpConstant, {3}, 1},
                                {OpConstant, {4}, 1},
+                               {OpAdd, {}, 0},
+                               {OpRecord, {0}, 1},
+                               {OpArray, {2}, 1},
+                               {OpPop, {}, 0}},
+       12},
+      // in another order they lay out differently
+      {"[{\"a\": 1 + 2, \"b\": true}, {\"b\": true, \"a\": 3 + 4}]",
+       (ExpectedConstant[]){{{HashObj}},
+                            {{IntegerObj, .integer = &(Integer){1}}},
+                            {{IntegerObj, .integer = &(Integer){2}}},
+                            {{HashObj}},
+                            {{IntegerObj, .integer = &(Integer){3}}},
+                            {{IntegerObj, .integer = &(Integer){4}}}},
+       6,
+       (ExpectedInstruction[]){{OpConstant, {1}, 1},
+                               {OpConstant, {2}, 1},
+                               {OpAdd, {}, 0},
+                               {OpTrue, {}, 0},
+                               {OpRecord, {0}, 1},
+                               {OpTrue, {}, 0},
+                               {OpConstant, {4}, 1},
                                {OpConstant, {5}, 1},
-                               {OpHash, {6}, 1},
+                               {OpAdd, {}, 0},
+                               {OpRecord, {3}, 1},
+                               {OpArray, {2}, 1},
                                {OpPop, {}, 0}},
-       8}};
+       12}};
 
-  for (int i = 0; i < 2; i++) {
+  for (int i = 0; i < 7; i++) {
     CompilerTestCase test = tests[i];
     printf("  Testing: %s\n", test.input);
 
@@ -523,33 +606,32 @@ void testIndexExpressions() {
 
   CompilerTestCase tests[] = {
       {"[1, 2, 3][1]",
-       (ExpectedConstant[]){{{IntegerObj, .integer = &(Integer){1}}},
-                            {{IntegerObj, .integer = &(Integer){2}}},
-                            {{IntegerObj, .integer = &(Integer){3}}},
+       (ExpectedConstant[]){{{ArrayObj}},
                             {{IntegerObj, .integer = &(Integer){1}}}},
-       4,
+       2,
        (ExpectedInstruction[]){{OpConstant, {0}, 1},
                                {OpConstant, {1}, 1},
-                               {OpConstant, {2}, 1},
-                               {OpArray, {3}, 1},
-                               {OpConstant, {3}, 1},
                                {OpIndex, {}, 0},
                                {OpPop, {}, 0}},
-       7},
+       4},
       {"{1: 2}[1]",
-       (ExpectedConstant[]){{{IntegerObj, .integer = &(Integer){1}}},
-                            {{IntegerObj, .integer = &(Integer){2}}},
+       (ExpectedConstant[]){{{HashObj}},
                             {{IntegerObj, .integer = &(Integer){1}}}},
-       3,
+       2,
        (ExpectedInstruction[]){{OpConstant, {0}, 1},
                                {OpConstant, {1}, 1},
-                               {OpHash, {2}, 1},
-                               {OpConstant, {2}, 1},
                                {OpIndex, {}, 0},
                                {OpPop, {}, 0}},
-       6}};
+       4},
+      {"{\"a\": 2}[\"a\"]",
+       (ExpectedConstant[]){{{HashObj}}, {{StringObj}}},
+       2,
+       (ExpectedInstruction[]){{OpConstant, {0}, 1},
+                               {OpGetField, {1}, 1},
+                               {OpPop, {}, 0}},
+       3}};
 
-  for (int i = 0; i < 2; i++) {
+  for (int i = 0; i < 3; i++) {
     CompilerTestCase test = tests[i];
     printf("  Testing: %s\n", test.input);
 
@@ -920,6 +1002,34 @@ void testNestedScopes() {
   printf("✅ Nested scope tests passed\n");
 }
 
+void testCompileProgramWithMark() {
+  printf("📸 Testing snapshot mark position...\n");
+
+  const char *input = "let a = 1; let b = 2; a + b";
+
+  Lexer *lexer = newLexer((char *)input);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+
+  Compiler *compiler = newCompiler();
+  int markPosition = -1;
+  int result = compileProgramWithMark(compiler, program, 2, &markPosition);
+  assert(result == 0);
+
+  // two `OpConstant` + `OpSetGlobal` pairs precede the mark
+  assert(markPosition == 12);
+
+  ByteCode *bytecode = getByteCode(compiler);
+  assert(bytecode->instructions[markPosition] == OpGetGlobal);
+
+  free(bytecode);
+  freeProgram(program);
+  freeParser(parser);
+  free(lexer);
+
+  printf("✅ Snapshot mark tests passed\n");
+}
+
 void testPrintComplexProgram() {
   const char *input = "let getAge = fn(user) {\n"
                       "  return user[\"age\"];\n"
@@ -965,6 +1075,199 @@ void testPrintComplexProgram() {
   free(lexer);
 }
 
+// compiles input with the given number of threads; NULL if it fails
+static ByteCode *compileWithThreads(const char *input, int threads) {
+  Lexer *lexer = newLexer((char *)input);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+
+  Compiler *compiler = newCompiler();
+  compilerSetThreads(compiler, threads);
+  int result = compileProgram(compiler, program);
+  ByteCode *bytecode = result == 0 ? getByteCode(compiler) : NULL;
+
+  freeProgram(program);
+  freeParser(parser);
+  free(lexer);
+  return bytecode;
+}
+
+static void assertSameBytecode(ByteCode *a, ByteCode *b) {
+  assert(a->instructionCount == b->instructionCount);
+  assert(memcmp(a->instructions, b->instructions, a->instructionCount) == 0);
+  assert(a->lineTableLength == b->lineTableLength);
+  assert(memcmp(a->lineTable, b->lineTable, a->lineTableLength) == 0);
+  assert(a->constantsCount == b->constantsCount);
+
+  for (int i = 0; i < a->constantsCount; i++) {
+    Object *x = &a->constants[i];
+    Object *y = &b->constants[i];
+    assert(strcmp(x->type, y->type) == 0);
+    if (strcmp(x->type, IntegerObj) == 0) {
+      assert(x->integer->value == y->integer->value);
+    } else if (strcmp(x->type, StringObj) == 0) {
+      assert(strcmp(x->string->value, y->string->value) == 0);
+    } else if (strcmp(x->type, CompiledFunctionObj) == 0) {
+      CompiledFunction *f = x->compiledFunction;
+      CompiledFunction *g = y->compiledFunction;
+      assert(f->instructionCount == g->instructionCount);
+      assert(memcmp(f->instructions, g->instructions, f->instructionCount) ==
+             0);
+      assert(f->numLocals == g->numLocals);
+      assert(f->numParameters == g->numParameters);
+      assert(f->lineTableLength == g->lineTableLength);
+      assert(memcmp(f->lineTable, g->lineTable, f->lineTableLength) == 0);
+    }
+  }
+}
+
+void testParallelFunctionBodies() {
+  printf("🧵 Testing parallel function compilation...\n");
+
+  const char *inputs[] = {
+      // constants before, inside, between and after the bodies
+      "let a = 1; let f = fn(x) { let y = x + 2; y * \"s\" };"
+      "let g = fn() { f(a) + 3 }; [4, g(), fn() { 5 }()]",
+      // nested functions stay inside their job
+      "let h = fn(x) { let k = fn(y) { y + 6 }; k(x) + 7 }; h(8)",
+      // functions inside top-level blocks
+      "if (true) { let b = fn() { 9 }; b() } else { fn(z) { z }(10) }",
+      // a redefinition after a queued body that uses the old symbol
+      "let c = 11; let f = fn() { c }; let c = fn() { 12 }; f()",
+      // a global that shadows a builtin after a body that calls it
+      "let l = fn(s) { len(s) }; let len = 13; l(\"abc\") + len",
+      // recursion sees the function's own name
+      "let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) };"
+      "fib(15)",
+      // records in bodies and in the main scope share shapes either way
+      "let a = {\"x\": 1 + 1}; let f = fn(v) { {\"x\": v, \"y\": v} };"
+      "let b = {\"x\": f(1)[\"y\"], \"y\": 2 + 2};"
+      "let g = fn() { {\"y\": 3 + 3} }; {\"y\": g()}",
+  };
+  int count = sizeof(inputs) / sizeof(inputs[0]);
+
+  for (int i = 0; i < count; i++) {
+    printf("  Testing: %s\n", inputs[i]);
+    ByteCode *serial = compileWithThreads(inputs[i], 1);
+    ByteCode *parallel = compileWithThreads(inputs[i], 4);
+    assert(serial && parallel);
+    assertSameBytecode(serial, parallel);
+    free(serial);
+    free(parallel);
+  }
+
+  // enough bodies to flush in several batches
+  size_t capacity = 3000 * 64;
+  char *many = malloc(capacity);
+  size_t length = 0;
+  for (int i = 0; i < 3000; i++) {
+    length += snprintf(many + length, capacity - length,
+                       "let f = fn(x) { x + %d + \"%d\" }; f(%d);", i, i, i);
+  }
+  ByteCode *serial = compileWithThreads(many, 1);
+  ByteCode *parallel = compileWithThreads(many, 4);
+  assert(serial && parallel);
+  assertSameBytecode(serial, parallel);
+  free(serial);
+  free(parallel);
+  free(many);
+
+  // a body may only use globals defined before it
+  assert(compileWithThreads("let f = fn() { later }; let later = 1;", 4) ==
+         NULL);
+  assert(compileWithThreads("let f = fn() { later }; let later = 1;", 1) ==
+         NULL);
+
+  printf("✅ Parallel function compilation tests passed\n");
+}
+
+// the HashObj constants of bytecode, all record shapes in these programs
+static int countHashes(ByteCode *bytecode) {
+  int count = 0;
+  for (int i = 0; i < bytecode->constantsCount; i++) {
+    count += strcmp(bytecode->constants[i].type, HashObj) == 0;
+  }
+  return count;
+}
+
+void testRecordShapes() {
+  printf("🧩 Testing record shapes...\n");
+
+  // thousands of distinct key lists, across several batches of bodies, each
+  // body reusing an earlier key list
+  int records = 3000;
+  size_t capacity = (size_t)records * 96;
+  char *source = malloc(capacity);
+  size_t length = snprintf(source, capacity, "let x = 1;");
+  for (int i = 0; i < records; i++) {
+    length += snprintf(source + length, capacity - length,
+                       "let r = {\"k%d\": x + 1};"
+                       "let f = fn(y) { {\"k%d\": y} };",
+                       i, i / 2);
+  }
+
+  ByteCode *serial = compileWithThreads(source, 1);
+  ByteCode *parallel = compileWithThreads(source, 4);
+  assert(serial && parallel);
+  assert(countHashes(serial) == records);
+  assertSameBytecode(serial, parallel);
+  free(serial);
+  free(parallel);
+  free(source);
+
+  printf("✅ Record shape tests passed\n");
+}
+
+void testLineTables() {
+  printf("📍 Testing line tables...\n");
+
+  ByteCode *bytecode = compileWithThreads("let a = 1;\n"
+                                          "\n"
+                                          "let f = fn(x) {\n"
+                                          "  let y = x;\n"
+                                          "  y +\n"
+                                          "    a\n"
+                                          "};\n"
+                                          "f(2)",
+                                          1);
+  assert(bytecode);
+
+  // main: OpConstant 0, OpSetGlobal 0 | OpConstant 1, OpSetGlobal 1 |
+  // OpGetGlobal 1, OpConstant 2, OpCall 1
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 0) == 1);
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 3) == 1);
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 6) == 3);
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 9) == 3);
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 12) ==
+         8);
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 17) ==
+         8);
+
+  // f: OpGetLocal 0, OpSetLocal 1 | OpGetLocal 1 | OpGetGlobal 0 |
+  // OpAdd, OpReturnValue
+  CompiledFunction *f = bytecode->constants[1].compiledFunction;
+  assert(lineForOffset(f->lineTable, f->lineTableLength, 0) == 4);
+  assert(lineForOffset(f->lineTable, f->lineTableLength, 2) == 4);
+  assert(lineForOffset(f->lineTable, f->lineTableLength, 4) == 5);
+  assert(lineForOffset(f->lineTable, f->lineTableLength, 6) == 6);
+  assert(lineForOffset(f->lineTable, f->lineTableLength, 9) == 5);
+  assert(lineForOffset(f->lineTable, f->lineTableLength, 10) == 5);
+  free(bytecode);
+
+  // OpTrue, OpJumpNotTruthy | OpConstant 0 | OpJump | OpConstant 1; the
+  // OpJump takes the place of a removed OpPop from the line before
+  bytecode = compileWithThreads("if (true) {\n  1\n} else {\n  2\n}", 1);
+  assert(bytecode->instructionCount == 13);
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 1) == 1);
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 4) == 2);
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 7) == 1);
+  assert(lineForOffset(bytecode->lineTable, bytecode->lineTableLength, 12) ==
+         4);
+  free(bytecode);
+
+  printf("✅ Line table tests passed\n");
+}
+
 int main() {
   printf("🚀 Starting compiler tests...\n\n");
 
@@ -985,6 +1288,10 @@ int main() {
   testErrorHandling();
   testLocalVariables();
   testNestedScopes();
+  testCompileProgramWithMark();
+  testParallelFunctionBodies();
+  testRecordShapes();
+  testLineTables();
   testPrintComplexProgram();
 
   printf("\n🎉 All compiler tests passed!\n");
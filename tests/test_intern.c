@@ -0,0 +1,58 @@
+#include "../intern/intern.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+void testInternIsCanonical() {
+  char buffer[] = "counter";
+  const char *a = internString("counter");
+  const char *b = intern(buffer, strlen(buffer));
+  assert(a == b);
+  assert(a != buffer);
+  assert(strcmp(a, "counter") == 0);
+
+  // slices are interned by their bytes only
+  const char *c = intern("counterweight", 7);
+  assert(c == a);
+  assert(intern("count", 5) != a);
+
+  printf("✅ testInternIsCanonical passed\n");
+}
+
+void testInternLookup() {
+  assert(internLookup("neverSeenBefore", 15) == NULL);
+  int before = internCount();
+  const char *x = internString("neverSeenBefore");
+  assert(internCount() == before + 1);
+  assert(internLookup("neverSeenBefore", 15) == x);
+
+  internString("neverSeenBefore");
+  assert(internCount() == before + 1);
+
+  printf("✅ testInternLookup passed\n");
+}
+
+void testInternManyNames() {
+  // enough to grow the table and fill several string blocks
+  static const char *names[20000];
+  char name[32];
+  for (int i = 0; i < 20000; i++) {
+    int length = snprintf(name, sizeof(name), "name_%d", i);
+    names[i] = intern(name, length);
+  }
+  for (int i = 0; i < 20000; i++) {
+    int length = snprintf(name, sizeof(name), "name_%d", i);
+    assert(internLookup(name, length) == names[i]);
+    assert(strcmp(names[i], name) == 0);
+  }
+
+  printf("✅ testInternManyNames passed\n");
+}
+
+int main() {
+  testInternIsCanonical();
+  testInternLookup();
+  testInternManyNames();
+  printf("✅ All intern tests passed\n");
+  return 0;
+}
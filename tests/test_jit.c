@@ -0,0 +1,137 @@
+#include "../compiler/compiler.h"
+#include "../jit/jit.h"
+#include "../lexer/lexer.h"
+#include "../object/object.h"
+#include "../parser/parser.h"
+#include "../vm/vm.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static VM *runProgram(char *input, CompiledFunction **fn) {
+  Lexer *lexer = newLexer(input);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+
+  Compiler *compiler = newCompiler();
+  assert(compileProgram(compiler, program) == 0);
+
+  ByteCode *bytecode = getByteCode(compiler);
+  *fn = NULL;
+  for (int i = 0; i < bytecode->constantsCount; i++) {
+    if (strcmp(bytecode->constants[i].type, CompiledFunctionObj) == 0) {
+      *fn = bytecode->constants[i].compiledFunction;
+    }
+  }
+
+  VM *vm = newVM(bytecode);
+  assert(run(vm) == 0);
+  return vm;
+}
+
+void testHotFunctionIsCompiled() {
+  printf("Testing hot function compilation...\n");
+
+  jitSetEnabled(true);
+  jitSetThreshold(2);
+
+  char *input = "let fib = fn(n) { if (2 > n) { n } else { fib(n - 1) + fib(n - 2) } };"
+                "let t = {\"a\": [1, fib(3)]};"
+                "fib(15) + t[\"a\"][1]";
+  CompiledFunction *fn;
+  VM *vm = runProgram(input, &fn);
+
+  assert(fn != NULL);
+  if (jitIsEnabled()) {
+    assert(fn->native != NULL);
+  }
+
+  Object *top = stackTop(vm);
+  assert(top != NULL);
+  assert(strcmp(top->type, IntegerObj) == 0);
+  assert(top->integer->value == 612);
+
+  freeVM(vm);
+  printf("✓ Hot function compilation test passed\n");
+}
+
+void testLocalsAndGlobals() {
+  printf("Testing jit locals and globals...\n");
+
+  jitSetEnabled(true);
+  jitSetThreshold(1);
+
+  char *input = "let g = 5; let f = fn(x) { let a = x * 2; let b = a - g; [a, b][1] };"
+                "f(1); f(10)";
+  CompiledFunction *fn;
+  VM *vm = runProgram(input, &fn);
+
+  if (jitIsEnabled()) {
+    assert(fn->native != NULL);
+  }
+
+  Object *top = stackTop(vm);
+  assert(top != NULL);
+  assert(top->integer->value == 15);
+
+  freeVM(vm);
+  printf("✓ Locals and globals test passed\n");
+}
+
+void testDisabledJit() {
+  printf("Testing disabled jit...\n");
+
+  jitSetEnabled(false);
+  jitSetThreshold(1);
+
+  CompiledFunction *fn;
+  VM *vm = runProgram("let f = fn(x) { x + 1 }; f(1); f(2)", &fn);
+
+  assert(fn->native == NULL);
+  assert(stackTop(vm)->integer->value == 3);
+
+  freeVM(vm);
+  jitSetEnabled(true);
+  printf("✓ Disabled jit test passed\n");
+}
+
+void testUnsupportedOpcodeFallsBack() {
+  printf("Testing fallback on unsupported opcodes...\n");
+
+  jitSetEnabled(true);
+  jitSetThreshold(1);
+
+  int operands[] = {0};
+  Instructions getFree = makeInstruction(OpGetFree, operands, 1);
+  Instructions ret = makeInstruction(OpReturnValue, NULL, 0);
+
+  CompiledFunction fn = {0};
+  fn.instructions = malloc(3);
+  memcpy(fn.instructions, getFree, 2);
+  memcpy(fn.instructions + 2, ret, 1);
+  fn.instructionCount = 3;
+
+  assert(jitCompile(&fn) == -1);
+  assert(fn.native == NULL);
+
+  jitMaybeCompile(&fn);
+  assert(fn.native == NULL);
+  if (jitIsEnabled()) {
+    assert(fn.jitFailed);
+  }
+
+  free(fn.instructions);
+  printf("✓ Unsupported opcode fallback test passed\n");
+}
+
+int main() {
+  printf("🚀 Starting JIT tests...\n\n");
+  testHotFunctionIsCompiled();
+  testLocalsAndGlobals();
+  testDisabledJit();
+  testUnsupportedOpcodeFallsBack();
+
+  printf("\n🎉 All JIT tests passed!\n");
+  return 0;
+}
@@ -1,4 +1,5 @@
 #include "../lexer/lexer.h"
+#include "../lexer/scan.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -54,20 +55,116 @@ void testNextToken() {
 
   Lexer *lexer = newLexer((char *)input);
 
-  for (int i = 0; strcmp(tests[i].type, EOF_TOK) != 0; i++) {
+  for (int i = 0; tests[i].type != EOF_TOK; i++) {
     Token tok = nextToken(lexer);
     assert(tok.type == tests[i].type);
-    assert(strcmp(tok.literal, tests[i].literal) == 0);
-    printf("✅ Token %d passed: type=%s, literal=%s\n", i, tok.type,
-           tok.literal);
-    free(tok.literal);
+    assert(tokenLiteralIs(tok, tests[i].literal));
+    printf("✅ Token %d passed: type=%s, literal=%.*s\n", i, tokenTypeName(tok.type),
+           tok.length, tok.start);
   }
 
   printf("✅ testNextToken passed\n");
 }
 
+// runs of every class at lengths around the 16 and 32 byte vector widths,
+// each ended by a byte just outside the class
+void testScanLevelsAgree() {
+  const char *fillers[] = {" \t\r\n", "azAZ_q", "0123456789", "x y,1"};
+  const char enders[] = {'@', '`', '[', '{', '/', ':', '"', '\n', '\x80', '\xff'};
+  char buf[128];
+
+  for (int f = 0; f < 4; f++) {
+    size_t fillerLength = strlen(fillers[f]);
+    for (int length = 0; length < 80; length++) {
+      for (size_t e = 0; e < sizeof(enders); e++) {
+        for (int i = 0; i < length; i++) {
+          buf[i] = fillers[f][i % fillerLength];
+        }
+        buf[length] = enders[e];
+        buf[length + 1] = '\0';
+        int end = length + 1;
+
+        scanSetLevel(SCAN_SCALAR);
+        int ws = scanWhitespace(buf, 0, end);
+        int letters = scanLetters(buf, 0, end);
+        int digits = scanDigits(buf, 0, end);
+        int string = scanString(buf, 0, end);
+
+        for (int level = SCAN_SSE2; level <= SCAN_AVX2; level++) {
+          scanSetLevel(level);
+          assert(scanWhitespace(buf, 0, end) == ws);
+          assert(scanLetters(buf, 0, end) == letters);
+          assert(scanDigits(buf, 0, end) == digits);
+          assert(scanString(buf, 0, end) == string);
+          // never looks at or past end
+          assert(scanLetters(buf, 0, length) <= length);
+        }
+      }
+    }
+  }
+
+  // whole token streams match too
+  const char *input =
+      "let data = [\"a fairly long string literal spanning vectors\", "
+      "12345678901234567890123456789012345, identifier_with_many_letters, "
+      "{\"k\": 1}];\n\n\t\t                                  \"unterminated";
+  scanSetLevel(SCAN_SCALAR);
+  Lexer *expected = newLexer((char *)input);
+  Lexer *lexers[2];
+  for (int level = SCAN_SSE2; level <= SCAN_AVX2; level++) {
+    lexers[level - SCAN_SSE2] = newLexer((char *)input);
+  }
+  for (;;) {
+    scanSetLevel(SCAN_SCALAR);
+    Token want = nextToken(expected);
+    for (int level = SCAN_SSE2; level <= SCAN_AVX2; level++) {
+      scanSetLevel(level);
+      Token got = nextToken(lexers[level - SCAN_SSE2]);
+      assert(got.type == want.type);
+      assert(got.start == want.start && got.length == want.length);
+      assert(got.line == want.line);
+    }
+    if (want.type == EOF_TOK) {
+      break;
+    }
+  }
+
+  printf("✅ testScanLevelsAgree passed (cpu best: %s)\n",
+         scanLevelName(scanSetLevel(SCAN_AVX2)));
+}
+
+void testTokenPositions() {
+  const char *input = "let x = 5;\n"
+                      "\n"
+                      "  \"two\n"
+                      "lines\" + y\n"
+                      "\tz";
+  struct {
+    TokenType type;
+    int line;
+    int column;
+  } expected[] = {
+      {LET, 1, 1},       {IDENTIFIER, 1, 5}, {ASSIGN, 1, 7},
+      {INT, 1, 9},       {SEMICOLON, 1, 10}, {STRING, 3, 4},
+      {PLUS, 4, 8},      {IDENTIFIER, 4, 10}, {IDENTIFIER, 5, 2},
+      {EOF_TOK, 5, 3},
+  };
+
+  Lexer *lexer = newLexer((char *)input);
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+    Token tok = nextToken(lexer);
+    assert(tok.type == expected[i].type);
+    assert(tok.line == expected[i].line);
+    assert(tokenColumn(tok, input) == expected[i].column);
+  }
+  free(lexer);
+  printf("✅ testTokenPositions passed\n");
+}
+
 int main() {
   testNewLexer();
   testNextToken();
+  testTokenPositions();
+  testScanLevelsAgree();
   return 0;
 }
@@ -1,6 +1,8 @@
+#include "../object/ints.h"
 #include "../object/object.h"
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 void testIntegerObject() {
@@ -33,7 +35,7 @@ void testNullObject() {
 }
 
 void testStringObject() {
-  String value = {.value = "hello"};
+  String value = {.value = "hello", .length = 5};
   Object obj = {.type = StringObj, .string = &value};
 
   char *buf = inspect(&obj);
@@ -62,8 +64,8 @@ void testHashKeyEquality() {
 }
 
 void testStringHashKey() {
-  String s1 = {.value = "foobar"};
-  String s2 = {.value = "foobar"};
+  String s1 = {.value = "foobar", .length = 6};
+  String s2 = {.value = "foobar", .length = 6};
   Object o1 = {.type = StringObj, .string = &s1};
   Object o2 = {.type = StringObj, .string = &s2};
 
@@ -74,6 +76,441 @@ void testStringHashKey() {
   assert(k1.value == k2.value);
 }
 
+void testStringHashCaching() {
+  String *s = newString(strdup("monkey"), 6);
+  assert(!s->hashed);
+  uint64_t h = stringHash(s);
+  assert(s->hashed && s->hash == h);
+  assert(stringHash(s) == h);
+
+  // same length with different bytes, and a shorter view of the same bytes
+  String same = {.value = "monkey", .length = 6};
+  String other = {.value = "donkey", .length = 6};
+  String prefix = {.value = "monkey", .length = 3};
+  assert(stringsEqual(s, &same));
+  assert(!stringsEqual(s, &other));
+  assert(!stringsEqual(s, &prefix));
+
+  // a cached hash that differs rules the bytes out without reading them
+  stringHash(&other);
+  assert(!stringsEqual(s, &other));
+
+  Object obj = {.type = StringObj, .string = s};
+  Object *length =
+      getBuiltinByName(BuiltinFuncNameLen)->function((Object *[]){&obj}, 1);
+  assert(length->integer->value == 6);
+
+  free(s->value);
+  free(s);
+}
+
+void testRopes() {
+  // appending one byte at a time, and prepending, both past the point
+  // where results stop being copied
+  enum { COUNT = 100000 };
+  String piece = {.value = "ab", .length = 2};
+  String *appended = newString("", 0);
+  String *prepended = newString("", 0);
+  String *halfway = NULL;
+  for (int i = 0; i < COUNT; i++) {
+    appended = concatStrings(appended, &piece);
+    prepended = concatStrings(&piece, prepended);
+    if (i == COUNT / 2 - 1) {
+      halfway = appended;
+    }
+  }
+  assert(appended->length == COUNT * 2 && appended->value == NULL);
+  assert(prepended->length == COUNT * 2 && prepended->value == NULL);
+
+  // equal bytes compare and hash equal whatever shape built them
+  char *flat = malloc(COUNT * 2 + 1);
+  for (int i = 0; i < COUNT; i++) {
+    memcpy(flat + i * 2, "ab", 2);
+  }
+  flat[COUNT * 2] = '\0';
+  String *expected = newString(flat, COUNT * 2);
+  assert(stringsEqual(appended, expected));
+  assert(stringsEqual(prepended, expected));
+  assert(stringHash(appended) == stringHash(expected));
+  assert(appended->value != NULL && appended->left == NULL);
+  assert(strlen(stringValue(prepended)) == COUNT * 2);
+
+  // earlier versions share nodes with later ones and keep their own bytes
+  assert(halfway->length == COUNT);
+  assert(memcmp(stringValue(halfway), flat, COUNT) == 0);
+  assert(stringValue(halfway)[COUNT] == '\0');
+
+  // a rope of ropes, each already flattened or not
+  String *pair = concatStrings(halfway, prepended);
+  String *quad = concatStrings(pair, concatStrings(halfway, appended));
+  assert(quad->length == COUNT * 6);
+  assert(memcmp(stringValue(quad) + COUNT, flat, COUNT * 2) == 0);
+  assert(memcmp(stringValue(quad) + COUNT * 4, flat, COUNT * 2) == 0);
+
+  // short results are plain strings
+  String *small = concatStrings(&piece, &piece);
+  assert(small->value != NULL && strcmp(small->value, "abab") == 0);
+
+  Object obj = {.type = StringObj, .string = quad};
+  char *text = inspect(&obj);
+  assert(strlen(text) == COUNT * 6);
+  free(text);
+  printf("✅ testRopes passed\n");
+}
+
+void testArrayVector() {
+  // past three trie levels, keeping a few versions along the way
+  enum { COUNT = 40000 };
+  Integer *ints = malloc(sizeof(Integer) * COUNT);
+  int kept[] = {1, 32, 33, 1057};
+  Array *versions[4];
+  Array *array = newArray(NULL, 0);
+  for (int i = 0; i < COUNT; i++) {
+    ints[i].value = i;
+    Object value = {.type = IntegerObj, .integer = &ints[i]};
+    array = arrayPush(array, &value);
+    for (int v = 0; v < 4; v++) {
+      if (array->count == kept[v]) {
+        versions[v] = array;
+      }
+    }
+  }
+  assert(array->count == COUNT && array->shift == 15);
+  for (int i = 0; i < COUNT; i++) {
+    assert(arrayGet(array, i)->integer->value == i);
+  }
+  assert(versions[0]->count == 1 && versions[1]->count == 32);
+  assert(versions[2]->count == 33 && versions[3]->count == 1057);
+  assert(arrayGet(versions[3], 1056)->integer->value == 1056);
+
+  // pushing onto an older version leaves the newer ones alone
+  Integer other = {.value = -1};
+  Object otherValue = {.type = IntegerObj, .integer = &other};
+  Array *branch = arrayPush(versions[3], &otherValue);
+  assert(arrayGet(branch, 1057)->integer->value == -1);
+  assert(arrayGet(array, 1057)->integer->value == 1057);
+  Array *again = arrayPush(branch, &otherValue);
+  assert(again->count == 1059 && arrayGet(branch, 1056)->integer == &ints[1056]);
+
+  // a flat array lends its blocks to the vectors pushed from it
+  Object *elements = malloc(sizeof(Object) * 100);
+  for (int i = 0; i < 100; i++) {
+    elements[i] = (Object){.type = IntegerObj, .integer = &ints[i]};
+  }
+  Array *flat = newArray(elements, 100);
+  Array *grown = arrayPush(flat, &otherValue);
+  assert(flat->count == 100 && flat->tail == NULL);
+  assert(grown->count == 101 && arrayGet(grown, 100)->integer == &other);
+  assert(arrayGet(grown, 0) == &elements[0]);
+  assert(arrayGet(grown, 99)->integer == &ints[99]);
+
+  Object obj = {.type = ArrayObj, .array = versions[2]};
+  Object *last =
+      getBuiltinByName(BuiltinFuncNameLast)->function((Object *[]){&obj}, 1);
+  assert(last->integer->value == 32);
+
+  free(ints);
+  printf("✅ testArrayVector passed\n");
+}
+
+void testArrayRest() {
+  enum { COUNT = 1000 };
+  Integer *ints = malloc(sizeof(Integer) * COUNT);
+  Object *elements = malloc(sizeof(Object) * COUNT);
+  Array *vector = newArray(NULL, 0);
+  for (int i = 0; i < COUNT; i++) {
+    ints[i].value = i;
+    elements[i] = (Object){.type = IntegerObj, .integer = &ints[i]};
+    vector = arrayPush(vector, &elements[i]);
+  }
+  Array *flat = newArray(elements, COUNT);
+
+  // walking both down to their last element without copying any
+  Array *flatRest = flat;
+  Array *vectorRest = vector;
+  for (int i = 1; i < COUNT; i++) {
+    flatRest = arrayRest(flatRest, 1);
+    vectorRest = arrayRest(vectorRest, 1);
+    assert(flatRest->count == COUNT - i && vectorRest->count == COUNT - i);
+    assert(arrayGet(flatRest, 0) == &elements[i]);
+    assert(arrayGet(vectorRest, 0)->integer == &ints[i]);
+    assert(arrayGet(vectorRest, COUNT - i - 1)->integer == &ints[COUNT - 1]);
+  }
+  assert(flatRest->elements == &elements[COUNT - 1]);
+  assert(vectorRest->root == vector->root && vectorRest->tail == vector->tail);
+
+  // pushing onto a rest appends after the elements it shares
+  Integer extra = {.value = -1};
+  Object extraValue = {.type = IntegerObj, .integer = &extra};
+  Array *middle = arrayRest(vector, 500);
+  Array *pushed = arrayPush(middle, &extraValue);
+  assert(pushed->count == 501 && arrayGet(pushed, 0)->integer == &ints[500]);
+  assert(arrayGet(pushed, 500)->integer == &extra);
+  Array *flatPushed = arrayPush(arrayRest(flat, 990), &extraValue);
+  assert(flatPushed->count == 11);
+  assert(arrayGet(flatPushed, 0)->integer == &ints[990]);
+  assert(arrayGet(flatPushed, 10)->integer == &extra);
+  assert(flat->count == COUNT && vector->count == COUNT);
+
+  Object obj = {.type = ArrayObj, .array = middle};
+  Object *rest =
+      getBuiltinByName(BuiltinFuncNameRest)->function((Object *[]){&obj}, 1);
+  assert(rest->array->count == 499 && rest->array->start == 501);
+  Object *length =
+      getBuiltinByName(BuiltinFuncNameLen)->function((Object *[]){rest}, 1);
+  assert(length->integer->value == 499);
+
+  free(ints);
+  printf("✅ testArrayRest passed\n");
+}
+
+static int64_t intAt(Array *array, int index) {
+  Integer box;
+  return arrayGetValue(array, index, &box).integer->value;
+}
+
+void testPackedArrays() {
+  // every kernel against plain c, on lengths around the vector widths,
+  // from unaligned starts, with values that overflow when summed
+  enum { MAX_LENGTH = 70 };
+  int64_t a[MAX_LENGTH + 3];
+  int64_t b[MAX_LENGTH + 3];
+  unsigned long long state = 0x9e3779b97f4a7c15ULL;
+  for (int i = 0; i < MAX_LENGTH + 3; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    a[i] = (int64_t)state;
+    b[i] = (int64_t)(state >> (i % 40)) - (i % 3 ? 0 : INT64_MAX);
+  }
+  a[5] = INT64_MIN;
+  b[9] = INT64_MAX;
+
+  for (int start = 0; start < 3; start++) {
+    for (int length = 1; length <= MAX_LENGTH; length++) {
+      intsSetLevel(INTS_SCALAR);
+      int64_t sum = intsSum(a + start, length);
+      int64_t min = intsMin(b + start, length);
+      int64_t max = intsMax(b + start, length);
+      int64_t dot = intsDot(a + start, b + start, length);
+      intsSetLevel(INTS_AVX2);
+      assert(intsSum(a + start, length) == sum);
+      assert(intsMin(b + start, length) == min);
+      assert(intsMax(b + start, length) == max);
+      assert(intsDot(a + start, b + start, length) == dot);
+    }
+  }
+  intsSetLevel(INTS_SCALAR);
+  assert(intsSum(a, 0) == 0 && intsDot(a, b, 0) == 0);
+  intsSetLevel(INTS_AVX2);
+  assert(intsSum(a, 0) == 0 && intsDot(a, b, 0) == 0);
+
+  // integers pack, and pushing more keeps them packed
+  Integer *ints = malloc(sizeof(Integer) * 100);
+  Object *elements = malloc(sizeof(Object) * 3);
+  for (int i = 0; i < 100; i++) {
+    ints[i].value = i * 3;
+  }
+  for (int i = 0; i < 3; i++) {
+    elements[i] = (Object){.type = IntegerObj, .integer = &ints[i]};
+  }
+  Array *array = newArrayOf(elements, 3);
+  assert(array->packed != NULL && array->elements == NULL);
+  Array *older = array;
+  for (int i = 3; i < 100; i++) {
+    Object value = {.type = IntegerObj, .integer = &ints[i]};
+    array = arrayPush(array, &value);
+  }
+  assert(array->packed != NULL && array->count == 100);
+  assert(intAt(array, 99) == 297);
+  assert(older->count == 3 && intAt(older, 2) == 6);
+
+  // an older version and a rest both copy out before pushing
+  Object minus = {.type = IntegerObj, .integer = &(Integer){.value = -1}};
+  Array *branch = arrayPush(older, &minus);
+  assert(intAt(branch, 3) == -1);
+  assert(intAt(array, 3) == 9);
+  Array *rest = arrayRest(array, 98);
+  Array *grown = arrayPush(rest, &minus);
+  assert(grown->count == 3 && intAt(grown, 0) == 294);
+  assert(intAt(grown, 2) == -1);
+
+  // anything else unpacks
+  String text = {.value = "x", .length = 1};
+  Object word = {.type = StringObj, .string = &text};
+  Array *mixed = arrayPush(rest, &word);
+  assert(mixed->packed == NULL && mixed->count == 3);
+  assert(arrayGet(mixed, 1)->integer->value == 297);
+  assert(arrayGet(mixed, 2)->string == &text);
+
+  // reading a packed element boxes it into the caller's storage
+  Integer box;
+  Object element = arrayGetValue(array, 42, &box);
+  assert(element.integer == &box && box.value == 126);
+  assert(arrayGetValue(mixed, 2, NULL).string == &text);
+
+  Object obj = {.type = ArrayObj, .array = rest};
+  Object *sum =
+      getBuiltinByName(BuiltinFuncNameSum)->function((Object *[]){&obj}, 1);
+  assert(sum->integer->value == 294 + 297);
+  Object *dot = getBuiltinByName(BuiltinFuncNameDot)
+                    ->function((Object *[]){&obj, &obj}, 2);
+  assert(dot->integer->value == 294 * 294 + 297 * 297);
+
+  free(ints);
+  printf("✅ testPackedArrays passed\n");
+}
+
+void testHashTable() {
+  // enough keys to grow the table many times, with keys that only differ
+  // in their high bits and strings that share prefixes
+  enum { COUNT = 20000 };
+  Integer *ints = malloc(sizeof(Integer) * COUNT);
+  String *strings = malloc(sizeof(String) * COUNT);
+  Object *intKeys = malloc(sizeof(Object) * COUNT);
+  Object *stringKeys = malloc(sizeof(Object) * COUNT);
+
+  Hash *hash = newHash();
+  for (int i = 0; i < COUNT; i++) {
+    ints[i].value = (int64_t)i << 40;
+    intKeys[i] = (Object){.type = IntegerObj, .integer = &ints[i]};
+    strings[i].value = malloc(16);
+    strings[i].length = snprintf(strings[i].value, 16, "key%d", i);
+    strings[i].hashed = false;
+    stringKeys[i] = (Object){.type = StringObj, .string = &strings[i]};
+
+    hashSet(hash, &intKeys[i], &stringKeys[i]);
+    hashSet(hash, &stringKeys[i], &intKeys[i]);
+  }
+  assert(hash->size == 2 * COUNT);
+
+  for (int i = 0; i < COUNT; i++) {
+    Integer copy = {.value = ints[i].value};
+    Object key = {.type = IntegerObj, .integer = &copy};
+    Object *value = hashGet(hash, &key);
+    assert(value && value->string == &strings[i]);
+    value = hashGet(hash, &stringKeys[i]);
+    assert(value && value->integer == &ints[i]);
+  }
+
+  // keys of different types never match, even with equal HashKey values
+  Integer one = {.value = 1};
+  Boolean yes = {.value = true};
+  Object oneKey = {.type = IntegerObj, .integer = &one};
+  Object trueKey = {.type = BooleanObj, .boolean = &yes};
+  hashSet(hash, &oneKey, &oneKey);
+  assert(hashGet(hash, &trueKey) == NULL);
+
+  // setting an existing key replaces its value
+  hashSet(hash, &oneKey, &trueKey);
+  assert(hashGet(hash, &oneKey)->boolean == &yes);
+  assert(hash->size == 2 * COUNT + 1);
+
+  // iteration follows insertion order, and replacing a value keeps its
+  // pair where it was
+  int seen = 0;
+  int cursor = 0;
+  HashEntry *entry;
+  while ((entry = hashNext(hash, &cursor)) != NULL) {
+    if (seen < 2 * COUNT) {
+      Object *expected = seen % 2 ? &stringKeys[seen / 2] : &intKeys[seen / 2];
+      assert(entry->key.integer == expected->integer);
+    } else {
+      assert(entry->key.integer == &one && entry->value.boolean == &yes);
+    }
+    seen++;
+  }
+  assert(seen == hash->size);
+
+  freeHash(hash);
+  for (int i = 0; i < COUNT; i++) {
+    free(strings[i].value);
+  }
+  free(ints);
+  free(strings);
+  free(intKeys);
+  free(stringKeys);
+  printf("✅ testHashTable passed\n");
+}
+
+void testPersistentHash() {
+  // enough keys for several trie levels; integer 1 and true have equal
+  // hashes and share a collision node
+  enum { COUNT = 5000 };
+  Integer *ints = malloc(sizeof(Integer) * COUNT);
+  Object *keys = malloc(sizeof(Object) * COUNT);
+  Hash **versions = malloc(sizeof(Hash *) * (COUNT + 1));
+
+  versions[0] = newHash();
+  for (int i = 0; i < COUNT; i++) {
+    ints[i].value = i;
+    keys[i] = (Object){.type = IntegerObj, .integer = &ints[i]};
+    versions[i + 1] = hashWith(versions[i], &keys[i], &keys[i]);
+    assert(versions[i + 1]->size == i + 1);
+  }
+  Boolean yes = {.value = true};
+  Object trueKey = {.type = BooleanObj, .boolean = &yes};
+  Hash *full = hashWith(versions[COUNT], &trueKey, &trueKey);
+  assert(full->size == COUNT + 1);
+  assert(hashGet(full, &keys[1])->integer == &ints[1]);
+  assert(hashGet(full, &trueKey)->boolean == &yes);
+
+  // every earlier version still holds exactly its own keys
+  for (int v = 0; v <= COUNT; v += 250) {
+    for (int i = 0; i < COUNT; i += 7) {
+      assert((hashGet(versions[v], &keys[i]) != NULL) == (i < v));
+    }
+  }
+
+  // setting an existing key replaces its value without growing
+  Hash *replaced = hashWith(full, &keys[10], &trueKey);
+  assert(replaced->size == full->size);
+  assert(hashGet(replaced, &keys[10])->boolean == &yes);
+  assert(hashGet(full, &keys[10])->integer == &ints[10]);
+
+  // deleting every other key, then the rest
+  Hash *hash = full;
+  for (int i = 0; i < COUNT; i += 2) {
+    hash = hashWithout(hash, &keys[i]);
+  }
+  assert(hash->size == COUNT / 2 + 1);
+  for (int i = 0; i < COUNT; i++) {
+    assert((hashGet(hash, &keys[i]) != NULL) == (i % 2 == 1));
+  }
+  assert(hashWithout(hash, &keys[0]) == hash);
+  assert(hashGet(full, &keys[0]) != NULL);
+
+  int seen = 0;
+  int cursor = 0;
+  HashEntry *entry;
+  while ((entry = hashNext(hash, &cursor)) != NULL) {
+    assert(hashGet(hash, &entry->key) != NULL);
+    seen++;
+  }
+  assert(seen == hash->size);
+
+  for (int i = 1; i < COUNT; i += 2) {
+    hash = hashWithout(hash, &keys[i]);
+  }
+  hash = hashWithout(hash, &trueKey);
+  assert(hash->size == 0 && hashGet(hash, &keys[1]) == NULL);
+  assert(hashGet(full, &trueKey) != NULL);
+
+  // a table hash stays a table; its updates are tries over a copy of it
+  Hash *table = newHash();
+  hashSet(table, &keys[1], &keys[1]);
+  hashSet(table, &keys[2], &keys[2]);
+  Hash *updated = hashWithout(hashWith(table, &trueKey, &trueKey), &keys[1]);
+  assert(table->size == 2 && hashGet(table, &trueKey) == NULL);
+  assert(updated->size == 2 && hashGet(updated, &keys[1]) == NULL);
+  assert(hashGet(updated, &trueKey)->boolean == &yes);
+
+  free(ints);
+  free(keys);
+  free(versions);
+  printf("✅ testPersistentHash passed\n");
+}
+
 int main() {
   testIntegerObject();
   testBooleanObject();
@@ -82,6 +519,13 @@ int main() {
   testErrorObject();
   testHashKeyEquality();
   testStringHashKey();
+  testStringHashCaching();
+  testRopes();
+  testArrayVector();
+  testArrayRest();
+  testPackedArrays();
+  testHashTable();
+  testPersistentHash();
 
   printf("All object tests passed!\n");
   return 0;
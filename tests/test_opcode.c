@@ -59,7 +59,50 @@ void testInstructionsToString() {
   free(result);
 }
 
+void testInstructionLengths() {
+  // the table must agree with the operand widths
+  for (int op = 0; op <= MAX_OPCODE; op++) {
+    int length = 1;
+    for (int i = 0; i < definitions[op].operandCount; i++) {
+      length += definitions[op].operandWidths[i];
+    }
+    assert(instructionLengths[op] == length);
+  }
+  printf("✅ instructionLengths test passed\n");
+}
+
+void testLineTableEncoding() {
+  // lines may go backwards, e.g. back to an operator after its operands
+  LineEntry entries[] = {{0, 1}, {3, 2}, {5, 400}, {200, 7}, {70000, 8}};
+  int count = sizeof(entries) / sizeof(entries[0]);
+
+  int length;
+  unsigned char *table = encodeLineTable(entries, count, &length);
+  assert(table && length == 15);
+
+  assert(lineForOffset(table, length, 0) == 1);
+  assert(lineForOffset(table, length, 2) == 1);
+  assert(lineForOffset(table, length, 3) == 2);
+  assert(lineForOffset(table, length, 4) == 2);
+  assert(lineForOffset(table, length, 5) == 400);
+  assert(lineForOffset(table, length, 199) == 400);
+  assert(lineForOffset(table, length, 200) == 7);
+  assert(lineForOffset(table, length, 70000) == 8);
+  assert(lineForOffset(table, length, 1 << 20) == 8);
+
+  // a cut-off table keeps the entries before the cut
+  assert(lineForOffset(table, length - 1, 70000) == 7);
+
+  assert(encodeLineTable(entries, 0, &length) == NULL && length == 0);
+  assert(lineForOffset(NULL, 0, 0) == 0);
+
+  free(table);
+  printf("✅ line table encoding test passed\n");
+}
+
 int main() {
   testInstructionsToString();
+  testInstructionLengths();
+  testLineTableEncoding();
   return 0;
 }
@@ -32,7 +32,7 @@ void testParseLetStatementBasic() {
   assert(program->statementCount == 1);
 
   Statement *stmt = program->statements[0];
-  assert(strcmp(stmt->type, NODE_LET_STATEMENT) == 0);
+  assert(stmt->type == NODE_LET_STATEMENT);
 
   LetStatement *letStmt = stmt->letStatement;
   assert(strcmp(letStmt->name->value, "x") == 0);
@@ -44,6 +44,35 @@ void testParseLetStatementBasic() {
   free(lexer);
 }
 
+void testParseNextStatementStreaming() {
+  // only the first 13 bytes are source; the rest must never be looked at
+  char input[] = "let x = 5; 7;let broken =";
+  Lexer *lexer = newLexerWithLength(input, 13);
+  Parser *parser = newParser(lexer);
+  parser->arena = newAstArena();
+
+  Statement *stmt = parseNextStatement(parser);
+  assert(stmt != NULL);
+  assert(stmt->type == NODE_LET_STATEMENT);
+  assert(strcmp(stmt->letStatement->name->value, "x") == 0);
+  astArenaReset(parser->arena);
+
+  stmt = parseNextStatement(parser);
+  assert(stmt != NULL);
+  assert(stmt->type == NODE_EXPRESSION_STATEMENT);
+  assert(stmt->expressionStatement->expression->integerLiteral->value == 7);
+  astArenaReset(parser->arena);
+
+  assert(parseNextStatement(parser) == NULL);
+  assert(parser->errorCount == 0);
+
+  printf("✅ testParseNextStatementStreaming passed\n");
+
+  freeAstArena(parser->arena);
+  freeParser(parser);
+  free(lexer);
+}
+
 void testPrintComplexProgram() {
   const char *input = "let getAge = fn(user) {\n"
                       "  return user[\"age\"];\n"
@@ -67,6 +96,7 @@ void testPrintComplexProgram() {
 int main() {
   testParseEmptyProgram();
   testParseLetStatementBasic();
+  testParseNextStatementStreaming();
   testPrintComplexProgram();
   printf("✅ All parser tests passed\n");
   return 0;
@@ -1,3 +1,4 @@
+#include "../intern/intern.h"
 #include "../symbol/symbol.h"
 #include <assert.h>
 #include <stdio.h>
@@ -21,6 +22,9 @@ void testDefineAndResolveGlobal() {
   ok = resolve(global, "b", &out);
   assert(ok == 0 && out.index == 1 && strcmp(out.scope, GlobalScope) == 0);
 
+  // names are interned, whatever buffer they were defined from
+  assert(a.name == internString("a") && out.name == b.name);
+
   freeSymbolTable(global);
   printf("✅ testDefineAndResolveGlobal passed\n");
 }
@@ -107,12 +111,69 @@ void testShadowing() {
   printf("✅ testShadowing passed\n");
 }
 
+void testManyGlobals() {
+  SymbolTable *global = newSymbolTable();
+  char name[16];
+
+  // enough to grow the store several times
+  for (int i = 0; i < 5000; i++) {
+    snprintf(name, sizeof(name), "v%d", i);
+    Symbol symbol = define(global, name);
+    assert(symbol.index == i);
+  }
+  for (int i = 0; i < 5000; i++) {
+    snprintf(name, sizeof(name), "v%d", i);
+    Symbol out;
+    assert(resolve(global, name, &out) == 0 && out.index == i);
+  }
+
+  // a redefinition takes over the name
+  Symbol again = define(global, "v7");
+  Symbol out;
+  assert(resolve(global, "v7", &out) == 0 && out.index == again.index);
+  assert(global->storeCount == 5000);
+
+  Symbol missing;
+  assert(resolve(global, "v5000", &missing) != 0);
+
+  freeSymbolTable(global);
+  printf("✅ testManyGlobals passed\n");
+}
+
+void testInternedNames() {
+  SymbolTable *global = newSymbolTable();
+  SymbolTable *local = newEnclosedSymbolTable(global);
+  const char *name = intern("counter", 7);
+  const char *inner = intern("step", 4);
+
+  Symbol defined = defineInterned(global, name);
+  defineInterned(local, inner);
+  assert(defined.name == name);
+
+  // the interned pointer itself is the key, through every scope
+  Symbol out;
+  assert(resolveInterned(local, name, &out) == 0 && out.index == 0 &&
+         strcmp(out.scope, GlobalScope) == 0);
+  assert(resolveInterned(local, inner, &out) == 0 &&
+         strcmp(out.scope, LocalScope) == 0);
+
+  // an equal string that is not the interned copy goes through resolve
+  char copy[] = "counter";
+  assert(resolve(local, copy, &out) == 0 && out.name == name);
+
+  freeSymbolTable(local);
+  freeSymbolTable(global);
+  printf("✅ testInternedNames passed\n");
+}
+
 int main() {
   testDefineAndResolveGlobal();
   testNestedLocalScopes();
   testDefineBuiltinAndResolving();
   testFreeSymbols();
   testShadowing();
+  testManyGlobals();
+  testInternedNames();
   printf("\n✅ all symbol-table tests passed!\n");
   return 0;
 }
@@ -8,21 +8,21 @@
 void testNewToken() {
   // test creating tokens with different types
   Token intToken = newToken(INT, "42");
-  assert(strcmp(intToken.type, INT) == 0);
-  assert(strcmp(intToken.literal, "42") == 0);
+  assert(intToken.type == INT);
+  assert(tokenLiteralIs(intToken, "42"));
   
   Token identifierToken = newToken(IDENTIFIER, "myVar");
-  assert(strcmp(identifierToken.type, IDENTIFIER) == 0);
-  assert(strcmp(identifierToken.literal, "myVar") == 0);
+  assert(identifierToken.type == IDENTIFIER);
+  assert(tokenLiteralIs(identifierToken, "myVar"));
   
   Token operatorToken = newToken(PLUS, "+");
-  assert(strcmp(operatorToken.type, PLUS) == 0);
-  assert(strcmp(operatorToken.literal, "+") == 0);
+  assert(operatorToken.type == PLUS);
+  assert(tokenLiteralIs(operatorToken, "+"));
   
   // test with empty string literal
   Token emptyToken = newToken(EOF_TOK, "");
-  assert(strcmp(emptyToken.type, EOF_TOK) == 0);
-  assert(strcmp(emptyToken.literal, "") == 0);
+  assert(emptyToken.type == EOF_TOK);
+  assert(tokenLiteralIs(emptyToken, ""));
   
   printf("✅ testNewToken passed\n");
 }
@@ -30,20 +30,20 @@ void testNewToken() {
 // test keyword lookup functionality
 void testLookupIdentifier() {
   // test all keywords
-  assert(strcmp(lookupIdentifier("fn"), FUNCTION) == 0);
-  assert(strcmp(lookupIdentifier("let"), LET) == 0);
-  assert(strcmp(lookupIdentifier("true"), TRUE_TOK) == 0);
-  assert(strcmp(lookupIdentifier("false"), FALSE_TOK) == 0);
-  assert(strcmp(lookupIdentifier("if"), IF) == 0);
-  assert(strcmp(lookupIdentifier("else"), ELSE) == 0);
-  assert(strcmp(lookupIdentifier("return"), RETURN) == 0);
+  assert(lookupIdentifier("fn") == FUNCTION);
+  assert(lookupIdentifier("let") == LET);
+  assert(lookupIdentifier("true") == TRUE_TOK);
+  assert(lookupIdentifier("false") == FALSE_TOK);
+  assert(lookupIdentifier("if") == IF);
+  assert(lookupIdentifier("else") == ELSE);
+  assert(lookupIdentifier("return") == RETURN);
   
   // test non-keywords (should return IDENTIFIER)
-  assert(strcmp(lookupIdentifier("foobar"), IDENTIFIER) == 0);
-  assert(strcmp(lookupIdentifier("x"), IDENTIFIER) == 0);
-  assert(strcmp(lookupIdentifier("returnx"), IDENTIFIER) == 0);
-  assert(strcmp(lookupIdentifier("function"), IDENTIFIER) == 0);  // Not "fn"
-  assert(strcmp(lookupIdentifier("True"), IDENTIFIER) == 0);      // Case sensitive
+  assert(lookupIdentifier("foobar") == IDENTIFIER);
+  assert(lookupIdentifier("x") == IDENTIFIER);
+  assert(lookupIdentifier("returnx") == IDENTIFIER);
+  assert(lookupIdentifier("function") == IDENTIFIER);  // Not "fn"
+  assert(lookupIdentifier("True") == IDENTIFIER);      // Case sensitive
   
   printf("✅ testLookupIdentifier passed\n");
 }
@@ -51,25 +51,25 @@ void testLookupIdentifier() {
 // test edge cases and error conditions
 void testEdgeCases() {
   // test NULL input (should not crash and return IDENTIFIER)
-  assert(strcmp(lookupIdentifier(NULL), IDENTIFIER) == 0);
+  assert(lookupIdentifier(NULL) == IDENTIFIER);
   
   // test empty string
-  assert(strcmp(lookupIdentifier(""), IDENTIFIER) == 0);
+  assert(lookupIdentifier("") == IDENTIFIER);
   
   // test case sensitivity
-  assert(strcmp(lookupIdentifier("FN"), IDENTIFIER) == 0);
-  assert(strcmp(lookupIdentifier("LET"), IDENTIFIER) == 0);
-  assert(strcmp(lookupIdentifier("IF"), IDENTIFIER) == 0);
+  assert(lookupIdentifier("FN") == IDENTIFIER);
+  assert(lookupIdentifier("LET") == IDENTIFIER);
+  assert(lookupIdentifier("IF") == IDENTIFIER);
   
   // test partial matches
-  assert(strcmp(lookupIdentifier("f"), IDENTIFIER) == 0);
-  assert(strcmp(lookupIdentifier("fn_"), IDENTIFIER) == 0);
-  assert(strcmp(lookupIdentifier("_fn"), IDENTIFIER) == 0);
+  assert(lookupIdentifier("f") == IDENTIFIER);
+  assert(lookupIdentifier("fn_") == IDENTIFIER);
+  assert(lookupIdentifier("_fn") == IDENTIFIER);
   
   // test longer strings containing keywords
-  assert(strcmp(lookupIdentifier("function"), IDENTIFIER) == 0);
-  assert(strcmp(lookupIdentifier("letter"), IDENTIFIER) == 0);
-  assert(strcmp(lookupIdentifier("ifelse"), IDENTIFIER) == 0);
+  assert(lookupIdentifier("function") == IDENTIFIER);
+  assert(lookupIdentifier("letter") == IDENTIFIER);
+  assert(lookupIdentifier("ifelse") == IDENTIFIER);
   
   printf("✅ testEdgeCases passed\n");
 }
@@ -78,18 +78,18 @@ void testEdgeCases() {
 void testTokenLiterals() {
   // test with string literals
   Token stringToken = newToken(STRING, "\"hello world\"");
-  assert(strcmp(stringToken.type, STRING) == 0);
-  assert(strcmp(stringToken.literal, "\"hello world\"") == 0);
+  assert(stringToken.type == STRING);
+  assert(tokenLiteralIs(stringToken, "\"hello world\""));
   
   // test with numeric literals
   Token negativeToken = newToken(INT, "-123");
-  assert(strcmp(negativeToken.type, INT) == 0);
-  assert(strcmp(negativeToken.literal, "-123") == 0);
+  assert(negativeToken.type == INT);
+  assert(tokenLiteralIs(negativeToken, "-123"));
   
   // test with special characters
   Token specialToken = newToken(IDENTIFIER, "var_name_123");
-  assert(strcmp(specialToken.type, IDENTIFIER) == 0);
-  assert(strcmp(specialToken.literal, "var_name_123") == 0);
+  assert(specialToken.type == IDENTIFIER);
+  assert(tokenLiteralIs(specialToken, "var_name_123"));
   
   printf("✅ testTokenLiterals passed\n");
 }
@@ -101,42 +101,66 @@ void testCloneToken() {
   Token cloned = cloneToken(original);
   
   // verify the clone has the same type and literal content
-  assert(strcmp(cloned.type, original.type) == 0);
-  assert(strcmp(cloned.literal, original.literal) == 0);
+  assert(cloned.type == original.type);
+  assert(tokenLiteralIs(cloned, "myVar"));
   
-  // verify they are different memory locations (deep copy)
-  assert(cloned.literal != original.literal);
-  
-  // test cloning different token types
-  Token intToken = newToken(INT, "42");
-  Token clonedInt = cloneToken(intToken);
-  assert(strcmp(clonedInt.type, INT) == 0);
-  assert(strcmp(clonedInt.literal, "42") == 0);
-  assert(clonedInt.literal != intToken.literal);
+  // verify the clone slices the same characters (no allocation)
+  assert(cloned.start == original.start);
+  assert(cloned.length == original.length);
   
   // test cloning keyword token
   Token keywordToken = newToken(FUNCTION, "fn");
   Token clonedKeyword = cloneToken(keywordToken);
-  assert(strcmp(clonedKeyword.type, FUNCTION) == 0);
-  assert(strcmp(clonedKeyword.literal, "fn") == 0);
-  assert(clonedKeyword.literal != keywordToken.literal);
+  assert(clonedKeyword.type == FUNCTION);
+  assert(tokenLiteralIs(clonedKeyword, "fn"));
   
   // test cloning empty string
   Token emptyToken = newToken(EOF_TOK, "");
   Token clonedEmpty = cloneToken(emptyToken);
-  assert(strcmp(clonedEmpty.type, EOF_TOK) == 0);
-  assert(strcmp(clonedEmpty.literal, "") == 0);
-  assert(clonedEmpty.literal != emptyToken.literal);
-  
-  // cleanup cloned tokens (since they use strdup)
-  free((char*)cloned.literal);
-  free((char*)clonedInt.literal);
-  free((char*)clonedKeyword.literal);
-  free((char*)clonedEmpty.literal);
+  assert(clonedEmpty.type == EOF_TOK);
+  assert(clonedEmpty.length == 0);
   
   printf("✅ testCloneToken passed\n");
 }
 
+// test slices into a larger buffer
+void testTokenSlices() {
+  const char *source = "let answer = 42;";
+
+  Token name = newTokenSlice(IDENTIFIER, source + 4, 6);
+  assert(tokenLiteralIs(name, "answer"));
+  assert(!tokenLiteralIs(name, "answe"));
+  assert(!tokenLiteralIs(name, "answers"));
+
+  char *owned = tokenLiteral(name);
+  assert(strcmp(owned, "answer") == 0);
+  free(owned);
+
+  // keyword lookup works on slices that are not null-terminated
+  assert(lookupKeyword(source, 3) == LET);
+  assert(lookupKeyword(source, 2) == IDENTIFIER);
+  assert(lookupKeyword(source + 4, 6) == IDENTIFIER);
+
+  printf("✅ testTokenSlices passed\n");
+}
+
+// test keyword hash slots: words sharing a keyword's hash must not match it
+void testKeywordHash() {
+  // same first char, last char and length as a keyword
+  assert(lookupIdentifier("tree") == IDENTIFIER);
+  assert(lookupIdentifier("rotten") == IDENTIFIER);
+  assert(lookupIdentifier("eyse") == IDENTIFIER);
+  assert(lookupKeyword("letters", 3) == LET);
+  assert(lookupKeyword("returned", 6) == RETURN);
+  assert(lookupKeyword("returned", 7) == IDENTIFIER);
+
+  assert(strcmp(tokenTypeName(PLUS), "+") == 0);
+  assert(strcmp(tokenTypeName(EOF_TOK), "EOF") == 0);
+  assert(strcmp(tokenTypeName(FUNCTION), "FUNCTION") == 0);
+
+  printf("✅ testKeywordHash passed\n");
+}
+
 int main() {
   printf("running token module tests...\n\n");
   
@@ -145,6 +169,8 @@ int main() {
   testEdgeCases();
   testTokenLiterals();
   testCloneToken();
+  testTokenSlices();
+  testKeywordHash();
   
   printf("\n🎉 all token tests passed!\n");
   return 0;
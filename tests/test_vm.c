@@ -232,6 +232,190 @@ void testBasicFunctionCalls() {
   printf("✓ Basic function calls test passed\n");
 }
 
+// stands in for natively compiled code: multiplies where the bytecode adds
+static int nativeMultiply(struct VM *vm, int basePointer) {
+  executeGetLocal(vm, basePointer, 0);
+  executeGetLocal(vm, basePointer, 1);
+  executeBinaryOperation(vm, OpMul);
+  return executeReturnValue(vm, basePointer);
+}
+
+void testNativeFunctionCalls() {
+  printf("Testing native function calls...\n");
+
+  char *input = "let f = fn(a, b) { a + b }; f(3, 4);";
+  Lexer *lexer = newLexer(input);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+
+  Compiler *compiler = newCompiler();
+  int result = compileProgram(compiler, program);
+  assert(result == 0);
+
+  ByteCode *bytecode = getByteCode(compiler);
+  for (int i = 0; i < bytecode->constantsCount; i++) {
+    if (strcmp(bytecode->constants[i].type, CompiledFunctionObj) == 0) {
+      bytecode->constants[i].compiledFunction->native = nativeMultiply;
+    }
+  }
+  VM *vm = newVM(bytecode);
+
+  result = run(vm);
+  assert(result == 0);
+
+  Object *top = stackTop(vm);
+  assert(top != NULL);
+  assert(strcmp(top->type, IntegerObj) == 0);
+  assert(top->integer->value == 12);
+  assert(vm->framesIndex == 1);
+
+  freeVM(vm);
+  printf("✓ Native function calls test passed\n");
+}
+
+static VM *runInput(char *input) {
+  Lexer *lexer = newLexer(input);
+  Parser *parser = newParser(lexer);
+  Program *program = parseProgram(parser);
+
+  Compiler *compiler = newCompiler();
+  assert(compileProgram(compiler, program) == 0);
+
+  VM *vm = newVM(getByteCode(compiler));
+  assert(run(vm) == 0);
+  return vm;
+}
+
+void testRecordFields() {
+  printf("Testing record hashes and field caches...\n");
+
+  // records from one literal share a shape, and a field site keeps
+  // working when hashes of another shape come through it
+  char *input = "let make = fn(n) { {\"name\": \"rec\", \"age\": n, "
+                "\"next\": n + 1} };\n"
+                "let a = make(1);\n"
+                "let b = make(2);\n"
+                "let get = fn(r) { r[\"age\"] + r[\"next\"] };\n"
+                "get(a) + get(b) + get({\"next\": 100, \"age\": 10}) + "
+                "get(a) + {\"age\": 1000}[\"age\"]";
+  VM *vm = runInput(input);
+
+  Object *top = stackTop(vm);
+  assert(strcmp(top->type, IntegerObj) == 0);
+  assert(top->integer->value == 3 + 5 + 110 + 3 + 1000);
+
+  Hash *a = vm->globals[1].hash;
+  Hash *b = vm->globals[2].hash;
+  assert(a->shape != NULL && a->shape == b->shape);
+  String next = {.value = "next", .length = 4};
+  Object key = {.type = StringObj, .string = &next};
+  assert(a->size == 3 && hashFind(a, &key) == 2);
+  freeVM(vm);
+
+  // a missing field is null, as with OpIndex
+  vm = runInput("let r = fn(x) { {\"x\": x} }; r(1)[\"y\"]");
+  assert(strcmp(stackTop(vm)->type, NullObj) == 0);
+  freeVM(vm);
+
+  printf("✓ Record fields test passed\n");
+}
+
+void testHashBuiltins() {
+  printf("Testing set and delete...\n");
+
+  // set and delete leave the hash they were given untouched, and a field
+  // site reads trie hashes as well as records
+  char *input = "let fill = fn(h, n) { if (n == 0) { h } else { "
+                "fill(set(h, n, n * 2), n - 1) } };\n"
+                "let base = {\"age\": 7, \"name\": \"x\"};\n"
+                "let big = fill(base, 300);\n"
+                "let small = delete(delete(big, 300), \"name\");\n"
+                "let older = set(base, \"age\", 8);\n"
+                "len(base) + len(big) + len(small) + big[150] + small[\"age\"] "
+                "+ older[\"age\"] + base[\"age\"]";
+  VM *vm = runInput(input);
+  Object *top = stackTop(vm);
+  assert(strcmp(top->type, IntegerObj) == 0);
+  assert(top->integer->value == 2 + 302 + 300 + 300 + 7 + 8 + 7);
+
+  Hash *small = vm->globals[3].hash;
+  Integer gone = {.value = 300};
+  Object key = {.type = IntegerObj, .integer = &gone};
+  assert(hashGet(small, &key) == NULL);
+  freeVM(vm);
+
+  // unhashable keys are runtime errors
+  vm = runInput("set({}, [1], 2)");
+  assert(strcmp(stackTop(vm)->type, ErrorObj) == 0);
+  freeVM(vm);
+
+  printf("✓ Hash builtins test passed\n");
+}
+
+void testArrayPush() {
+  printf("Testing push...\n");
+
+  // push shares the array it extends, which keeps its own elements
+  char *input = "let fill = fn(a, n) { if (n == 0) { a } else { "
+                "fill(push(a, n), n - 1) } };\n"
+                "let base = [1, 2, 3];\n"
+                "let big = fill(base, 500);\n"
+                "let other = push(base, 9);\n"
+                "len(base) + len(big) + len(other) + big[3] + big[502] + "
+                "other[3] + last(big) + first(rest(big))";
+  VM *vm = runInput(input);
+  Object *top = stackTop(vm);
+  assert(strcmp(top->type, IntegerObj) == 0);
+  assert(top->integer->value == 3 + 503 + 4 + 500 + 1 + 9 + 1 + 2);
+  assert(vm->globals[1].array->packed != NULL);
+  assert(vm->globals[2].array->packed != NULL);
+  freeVM(vm);
+
+  // anything but an integer unpacks into a vector
+  vm = runInput("let a = push([1, 2], \"x\"); let b = push(a, 3); "
+                "len(b) + b[1] + b[3]");
+  assert(stackTop(vm)->integer->value == 4 + 2 + 3);
+  assert(vm->globals[0].array->packed == NULL);
+  assert(vm->globals[1].array->tail != NULL);
+  freeVM(vm);
+
+  printf("✓ Array push test passed\n");
+}
+
+void testIntegerReductions() {
+  printf("Testing sum, min, max and dot...\n");
+
+  char *input = "let fill = fn(a, n) { if (n == 0) { a } else { "
+                "fill(push(a, n - 50), n - 1) } };\n"
+                "let a = fill([], 100);\n"
+                "let b = rest(rest(fill([], 102)));\n"
+                "sum(a) * 1000000 + min(a) * 10000 + max(a) * 100 + "
+                "dot([1, 2, 3], [4, 5, 6]) + sum([]) + dot(a, b) - dot(a, b)";
+  VM *vm = runInput(input);
+  Object *top = stackTop(vm);
+  assert(strcmp(top->type, IntegerObj) == 0);
+  assert(top->integer->value == 50 * 1000000 - 49 * 10000 + 50 * 100 + 32);
+  freeVM(vm);
+
+  // arrays that are not packed work as long as they hold integers
+  vm = runInput("let v = rest(push(push([\"x\"], 5), 7)); "
+                "sum(v) + min(v) + max(v) + dot(v, v)");
+  assert(stackTop(vm)->integer->value == 12 + 5 + 7 + 74);
+  freeVM(vm);
+  vm = runInput("sum(push([1], \"x\"))");
+  assert(strcmp(stackTop(vm)->type, ErrorObj) == 0);
+  freeVM(vm);
+
+  vm = runInput("min([])");
+  assert(strcmp(stackTop(vm)->type, NullObj) == 0);
+  freeVM(vm);
+  vm = runInput("dot([1, 2], [1])");
+  assert(strcmp(stackTop(vm)->type, ErrorObj) == 0);
+  freeVM(vm);
+
+  printf("✓ Integer reductions test passed\n");
+}
+
 void testComplexProgram() {
   const char *input = "let getAge = fn(user) {\n"
                       "  return user[\"age\"];\n"
@@ -272,6 +456,11 @@ int main() {
   testGlobalVariables();
   testArrayLiterals();
   testBasicFunctionCalls();
+  testNativeFunctionCalls();
+  testRecordFields();
+  testHashBuiltins();
+  testArrayPush();
+  testIntegerReductions();
   testComplexProgram();
 
   printf("\n🎉 All VM tests passed!\n");
@@ -6,50 +6,108 @@
 // internal structure for keyword mapping
 typedef struct {
   const char *keyword;
+  int length;
   TokenType type;
 } KeywordMap;
 
-// static array of keyword mappings
-// this array maps MonkeyC language keywords to their corresponding token types
-// the array is searched linearly, which is efficient for the small number of keywords
-static const KeywordMap keywords[] = {
-    {"fn", FUNCTION}, 
-    {"let", LET},   
-    {"true", TRUE_TOK}, 
-    {"false", FALSE_TOK},
-    {"if", IF},       
-    {"else", ELSE}, 
-    {"return", RETURN},
+// perfect hash over the keyword set: (2 * first + last + length) & 7 lands
+// every keyword in its own slot, so a lookup is one hash and at most one
+// memcmp. empty slots have a NULL keyword. regenerate the slots if a keyword
+// is added
+#define KEYWORD_SLOTS 8
+#define KEYWORD_HASH(start, length)                                            \
+  ((2 * (unsigned char)(start)[0] + (unsigned char)(start)[(length) - 1] +     \
+    (length)) &                                                                \
+   (KEYWORD_SLOTS - 1))
+
+static const KeywordMap keywords[KEYWORD_SLOTS] = {
+    [0] = {"return", 6, RETURN},
+    [1] = {"true", 4, TRUE_TOK},
+    [2] = {"if", 2, IF},
+    [3] = {"else", 4, ELSE},
+    [4] = {"fn", 2, FUNCTION},
+    [6] = {"false", 5, FALSE_TOK},
+    [7] = {"let", 3, LET},
 };
 
-#define KEYWORD_COUNT (sizeof(keywords) / sizeof(keywords[0]))
+static const char *const tokenTypeNames[TOKEN_TYPE_COUNT] = {
+    [ILLEGAL] = "ILLEGAL",   [EOF_TOK] = "EOF",      [IDENTIFIER] = "IDENTIFIER",
+    [INT] = "INT",           [STRING] = "STRING",    [ASSIGN] = "=",
+    [PLUS] = "+",            [MINUS] = "-",          [BANG] = "!",
+    [ASTERISK] = "*",        [SLASH] = "/",          [LT] = "<",
+    [GT] = ">",              [EQ] = "==",            [NOT_EQ] = "!=",
+    [COMMA] = ",",           [SEMICOLON] = ";",      [COLON] = ":",
+    [LPAREN] = "(",          [RPAREN] = ")",         [LBRACE] = "{",
+    [RBRACE] = "}",          [LBRACKET] = "[",       [RBRACKET] = "]",
+    [FUNCTION] = "FUNCTION", [LET] = "LET",          [TRUE_TOK] = "TRUE",
+    [FALSE_TOK] = "FALSE",   [IF] = "IF",            [ELSE] = "ELSE",
+    [RETURN] = "RETURN",
+};
 
 Token newToken(TokenType type, const char *literal) {
+  return newTokenSlice(type, literal, literal ? strlen(literal) : 0);
+}
+
+Token newTokenSlice(TokenType type, const char *start, int length) {
   Token token;
   token.type = type;
-  token.literal = literal;
+  token.start = start;
+  token.length = length;
+  token.line = 0;
   return token;
 }
 
+int tokenColumn(Token token, const char *source) {
+  const char *at = token.start;
+  while (at > source && at[-1] != '\n') {
+    at--;
+  }
+  return (int)(token.start - at) + 1;
+}
+
 TokenType lookupIdentifier(const char *identifier) {
   // input validation
   if (identifier == NULL) {
     return IDENTIFIER;
   }
-  
-  // linear search through keywords array
-  for (size_t i = 0; i < KEYWORD_COUNT; ++i) {
-    if (strcmp(identifier, keywords[i].keyword) == 0) {
-      return keywords[i].type;
-    }
+
+  return lookupKeyword(identifier, strlen(identifier));
+}
+
+TokenType lookupKeyword(const char *start, int length) {
+  if (length < 2 || length > 6) {
+    return IDENTIFIER;
+  }
+
+  const KeywordMap *entry = &keywords[KEYWORD_HASH(start, length)];
+  if (entry->keyword && entry->length == length &&
+      memcmp(start, entry->keyword, length) == 0) {
+    return entry->type;
   }
 
   return IDENTIFIER;
 }
 
-Token cloneToken(Token original) {
-  Token t;
-  t.type = original.type;
-  t.literal = strdup(original.literal);
-  return t;
+const char *tokenTypeName(TokenType type) {
+  if ((int)type < 0 || type >= TOKEN_TYPE_COUNT) {
+    return "UNKNOWN";
+  }
+  return tokenTypeNames[type];
+}
+
+Token cloneToken(Token original) { return original; }
+
+char *tokenLiteral(Token token) {
+  char *literal = malloc(token.length + 1);
+  if (!literal) {
+    return NULL;
+  }
+  memcpy(literal, token.start, token.length);
+  literal[token.length] = '\0';
+  return literal;
+}
+
+int tokenLiteralIs(Token token, const char *text) {
+  return strncmp(token.start, text, token.length) == 0 &&
+         text[token.length] == '\0';
 }
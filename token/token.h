@@ -1,75 +1,109 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-typedef const char *TokenType;
+// token kinds are a dense enum so they can index parser tables directly;
+// tokenTypeName() gives the printable name used in diagnostics
+typedef enum {
+  // Special tokens
+  ILLEGAL,
+  EOF_TOK,
+
+  // Literals
+  IDENTIFIER,
+  INT,
+  STRING,
+
+  // Operators
+  ASSIGN,
+  PLUS,
+  MINUS,
+  BANG,
+  ASTERISK,
+  SLASH,
+
+  LT,
+  GT,
+
+  EQ,
+  NOT_EQ,
+
+  // Delimiters
+  COMMA,
+  SEMICOLON,
+  COLON,
+  LPAREN,
+  RPAREN,
+  LBRACE,
+  RBRACE,
+  LBRACKET,
+  RBRACKET,
+
+  // Keywords
+  FUNCTION,
+  LET,
+  TRUE_TOK,
+  FALSE_TOK,
+  IF,
+  ELSE,
+  RETURN,
+
+  TOKEN_TYPE_COUNT
+} TokenType;
 
 // represents a lexical token with its type and literal value
-// note: the literal field points to memory that should be managed by the caller
-// this structure does not own the literal string memory
+// the literal is a slice of the source buffer: `start` points at its first
+// character and it is NOT null-terminated, so the source must outlive every
+// token (and every AST node holding one). use tokenLiteral() where an owned
+// string is needed. line is the 1-based source line of `start`, set by the
+// lexer; 0 means unknown. the column is not stored, tokenColumn() recovers
+// it from the source. fields are packed so the struct stays 16 bytes and is
+// returned in registers
 typedef struct {
-  TokenType type;
-  const char *literal;  // Made const to clarify immutability
+  const char *start;
+  int length;
+  TokenType type : 8;
+  unsigned line : 24;
 } Token;
 
-// Special tokens
-#define ILLEGAL "ILLEGAL"
-#define EOF_TOK "EOF"
-
-// Literals
-#define IDENTIFIER "IDENTIFIER"
-#define INT "INT"
-#define STRING "STRING"
-
-// Operators
-#define ASSIGN "="
-#define PLUS "+"
-#define MINUS "-"
-#define BANG "!"
-#define ASTERISK "*"
-#define SLASH "/"
-
-#define LT "<"
-#define GT ">"
-
-#define EQ "=="
-#define NOT_EQ "!="
-
-// Delimiters
-#define COMMA ","
-#define SEMICOLON ";"
-#define COLON ":"
-#define LPAREN "("
-#define RPAREN ")"
-#define LBRACE "{"
-#define RBRACE "}"
-#define LBRACKET "["
-#define RBRACKET "]"
-
-// Keywords
-#define FUNCTION "FUNCTION"
-#define LET "LET"
-#define TRUE_TOK "TRUE"
-#define FALSE_TOK "FALSE"
-#define IF "IF"
-#define ELSE "ELSE"
-#define RETURN "RETURN"
+// lines past this are recorded as unknown
+#define TOKEN_MAX_LINE 0xffffff
 
 // creates a new token with the given type and literal value
-// type: the token type (should be one of the defined constants)
-// literal: the literal string value (caller retains ownership)
+// type: the token type
+// literal: a null-terminated string the token will slice (caller retains ownership)
 // returns: a new Token structure
 // note: this function does not allocate memory for the literal string
 // the caller is responsible for ensuring the literal remains valid for the lifetime of the token
 Token newToken(TokenType type, const char *literal);
 
+// creates a token slicing length characters at start
+Token newTokenSlice(TokenType type, const char *start, int length);
+
+// 1-based column of token in source, the buffer it was lexed from
+int tokenColumn(Token token, const char *source);
+
 // looks up an identifier to determine if it's a keyword
 // identifier: the identifier string to look up (must not be NULL)
 // returns: the corresponding keyword token type, or IDENTIFIER if not a keyword
 TokenType lookupIdentifier(const char *identifier);
 
-// creates a deep copy of a token with duplicated literal string
+// same as lookupIdentifier for a slice that is not null-terminated
+TokenType lookupKeyword(const char *start, int length);
+
+// returns the printable name of a token type ("IDENTIFIER", "+", "LET", ...)
+const char *tokenTypeName(TokenType type);
+
+// copies a token; the copy slices the same source characters
 // original: the token to clone
-// returns: a new token with copied literal (caller must free the literal)
+// returns: a new token (no memory is allocated)
 Token cloneToken(Token original);
 
+// materializes the token's literal as a null-terminated string
+// returns: a newly allocated string (caller must free)
+char *tokenLiteral(Token token);
+
+// compares the token's literal with a null-terminated string
+// returns: 1 if equal, 0 otherwise
+int tokenLiteralIs(Token token, const char *text);
+
 #endif
@@ -1,4 +1,5 @@
 #include "vm.h"
+#include "../jit/jit.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -24,9 +25,17 @@ VM *newVM(ByteCode *bytecode) {
     vm->constants[i] = bytecode->constants[i];
   }
 
+  vm->fieldCaches = calloc(bytecode->constantsCount + 1, sizeof(FieldCache));
+  if (!vm->fieldCaches) {
+    free(vm->constants);
+    free(vm);
+    return NULL;
+  }
+
   // Initialize stack
   vm->stack = malloc(sizeof(Object) * STACK_SIZE);
   if (!vm->stack) {
+    free(vm->fieldCaches);
     free(vm->constants);
     free(vm);
     return NULL;
@@ -38,6 +47,7 @@ VM *newVM(ByteCode *bytecode) {
   vm->globals = malloc(sizeof(Object) * GLOBAL_SIZE);
   if (!vm->globals) {
     free(vm->stack);
+    free(vm->fieldCaches);
     free(vm->constants);
     free(vm);
     return NULL;
@@ -55,6 +65,7 @@ VM *newVM(ByteCode *bytecode) {
   if (!vm->frames) {
     free(vm->globals);
     free(vm->stack);
+    free(vm->fieldCaches);
     free(vm->constants);
     free(vm);
     return NULL;
@@ -68,6 +79,7 @@ VM *newVM(ByteCode *bytecode) {
     free(vm->frames);
     free(vm->globals);
     free(vm->stack);
+    free(vm->fieldCaches);
     free(vm->constants);
     free(vm);
     return NULL;
@@ -76,6 +88,11 @@ VM *newVM(ByteCode *bytecode) {
   mainFn->numLocals = 0;
   mainFn->numParameters = 0;
   mainFn->instructionCount = bytecode->instructionCount;
+  mainFn->native = NULL;
+  mainFn->invocationCount = 0;
+  mainFn->jitFailed = false;
+  mainFn->lineTable = bytecode->lineTable;
+  mainFn->lineTableLength = bytecode->lineTableLength;
 
   // Create the main frame (equivalent to mainFrame in Go)
   vm->frames[0].compiledFunction = mainFn;
@@ -96,6 +113,7 @@ void freeVM(VM *vm) {
   }
 
   free(vm->constants);
+  free(vm->fieldCaches);
   free(vm->stack);
   free(vm->globals);
   free(vm->frames);
@@ -104,6 +122,22 @@ void freeVM(VM *vm) {
 
 Frame *currentFrame(VM *vm) { return &vm->frames[vm->framesIndex - 1]; }
 
+int vmCurrentLine(VM *vm) {
+  Frame *frame = currentFrame(vm);
+  CompiledFunction *fn = frame->compiledFunction;
+  int ip = frame->ip < 0 ? 0 : frame->ip;
+  return lineForOffset(fn->lineTable, fn->lineTableLength, ip);
+}
+
+void reportRuntimeError(VM *vm) {
+  int line = vmCurrentLine(vm);
+  if (line > 0) {
+    fprintf(stderr, "❌ runtime error at line %d\n", line);
+  } else {
+    fprintf(stderr, "❌ runtime error\n");
+  }
+}
+
 // push call frame with overflow protection
 void pushFrame(VM *vm, Frame *frame) {
   if (vm->framesIndex >= MAX_FRAMES) {
@@ -242,19 +276,9 @@ int executeBinaryStringOperation(VM *vm, OpCode opCode, Object *left,
     return -1; // Only concatenation supported for strings
   }
 
-  char *leftValue = left->string->value;
-  char *rightValue = right->string->value;
-
-  int leftLen = strlen(leftValue);
-  int rightLen = strlen(rightValue);
-  char *result = malloc(leftLen + rightLen + 1);
-  strcpy(result, leftValue);
-  strcat(result, rightValue);
-
   Object *resultObj = malloc(sizeof(Object));
   resultObj->type = StringObj;
-  resultObj->string = malloc(sizeof(String));
-  resultObj->string->value = result;
+  resultObj->string = concatStrings(left->string, right->string);
 
   return push(vm, resultObj);
 }
@@ -367,7 +391,13 @@ int executeArrayIndex(VM *vm, Object *array, Object *index) {
     return push(vm, &nullObj);
   }
 
-  return push(vm, &arrayObj->elements[i]);
+  if (!arrayObj->packed) {
+    return push(vm, arrayGet(arrayObj, i));
+  }
+  // the pushed value outlives this call, so its Integer is allocated as
+  // arithmetic results are
+  Object element = arrayGetValue(arrayObj, i, malloc(sizeof(Integer)));
+  return push(vm, &element);
 }
 
 int executeHashIndex(VM *vm, Object *hash, Object *index) {
@@ -384,15 +414,12 @@ int executeHashIndex(VM *vm, Object *hash, Object *index) {
 Object *buildArray(VM *vm, int startIndex, int endIndex) {
   Object *arrayObj = malloc(sizeof(Object));
   arrayObj->type = ArrayObj;
-  arrayObj->array = malloc(sizeof(Array));
-
   int numElements = endIndex - startIndex;
-  arrayObj->array->elements = malloc(sizeof(Object) * numElements);
-  arrayObj->array->count = numElements;
-
+  Object *elements = malloc(sizeof(Object) * numElements);
   for (int i = startIndex; i < endIndex; i++) {
-    arrayObj->array->elements[i - startIndex] = vm->stack[i];
+    elements[i - startIndex] = vm->stack[i];
   }
+  arrayObj->array = newArrayOf(elements, numElements);
 
   return arrayObj;
 }
@@ -433,18 +460,32 @@ int callCompiledFunction(VM *vm, CompiledFunction *fn, int numArgs) {
     return -1; // Wrong number of arguments
   }
 
+  if (fn->native == NULL) {
+    jitMaybeCompile(fn);
+  }
+
+  if (fn->native != NULL) {
+    int basePointer = vm->sp - numArgs;
+    vm->sp = basePointer + fn->numLocals;
+    return fn->native(vm, basePointer);
+  }
+
   Frame *frame = &vm->frames[vm->framesIndex++];
   frame->compiledFunction = fn;
   frame->ip = -1;
   frame->basePointer = vm->sp - numArgs;
-  // vm->sp = frame.basePointer + fn->numLocals;
+  // reserve the local slots so operands don't clobber them
+  vm->sp = frame->basePointer + fn->numLocals;
 
   return 0;
 }
 
 int callBuiltin(VM *vm, Builtin *builtin, int numArgs) {
-  Object *args = &vm->stack[vm->sp - numArgs];
-  Object *result = builtin->function(&args, numArgs);
+  Object *args[256]; // OpCall's operand is one byte
+  for (int i = 0; i < numArgs; i++) {
+    args[i] = &vm->stack[vm->sp - numArgs + i];
+  }
+  Object *result = builtin->function(args, numArgs);
 
   vm->sp = vm->sp - numArgs - 1;
 
@@ -458,13 +499,141 @@ int callBuiltin(VM *vm, Builtin *builtin, int numArgs) {
   return 0;
 }
 
-int run(VM *vm) {
+// === single-instruction helpers ===
+// each mirrors one case of the dispatch loop in run(); native backends call
+// them directly so compiled code behaves exactly like the interpreter
+
+int executeConstant(VM *vm, int constIndex) {
+  return push(vm, &vm->constants[constIndex]);
+}
+
+int executePop(VM *vm) {
+  pop(vm);
+  return 0;
+}
+
+int executeBoolean(VM *vm, bool value) {
+  Object obj = {.type = BooleanObj, .boolean = value ? &TRUE : &FALSE};
+  return push(vm, &obj);
+}
+
+int executeNull(VM *vm) {
+  Object nullObj = {.type = NullObj, .null = &null_obj};
+  return push(vm, &nullObj);
+}
+
+bool executeJumpCondition(VM *vm) {
+  Object *condition = pop(vm);
+  return isTruthy(condition);
+}
+
+int executeSetGlobal(VM *vm, int globalIndex) {
+  vm->globals[globalIndex] = *pop(vm);
+  return 0;
+}
+
+int executeGetGlobal(VM *vm, int globalIndex) {
+  return push(vm, &vm->globals[globalIndex]);
+}
+
+int executeArray(VM *vm, int numElements) {
+  Object *array = buildArray(vm, vm->sp - numElements, vm->sp);
+  vm->sp = vm->sp - numElements;
+  return push(vm, array);
+}
+
+int executeHash(VM *vm, int numElements) {
+  Object *hash = buildHash(vm, vm->sp - numElements, vm->sp);
+  vm->sp = vm->sp - numElements;
+  return push(vm, hash);
+}
+
+int executeIndex(VM *vm) {
+  Object *index = pop(vm);
+  Object *left = pop(vm);
+  return executeIndexExpression(vm, left, index);
+}
+
+int executeRecord(VM *vm, int shapeIndex) {
+  Hash *shape = vm->constants[shapeIndex].hash;
+  int start = vm->sp - shape->size;
+
+  Object *hashObj = malloc(sizeof(Object));
+  hashObj->type = HashObj;
+  hashObj->hash = newHashWithShape(shape);
+  for (int i = 0; i < shape->size; i++) {
+    hashObj->hash->entries[i].value = vm->stack[start + i];
+  }
+
+  vm->sp = start;
+  return push(vm, hashObj);
+}
+
+// a hash of the shape the site last saw is read at the cached slot without
+// hashing the key; other hashes with a shape become the one the site
+// expects, and anything else takes the OpIndex path
+int executeGetField(VM *vm, int keyIndex) {
+  Object *left = pop(vm);
+  Object *key = &vm->constants[keyIndex];
+  if (strcmp(left->type, HashObj) != 0) {
+    return executeIndexExpression(vm, left, key);
+  }
+
+  Hash *hash = left->hash;
+  FieldCache *cache = &vm->fieldCaches[keyIndex];
+  if (!hash->shape) {
+    return executeHashIndex(vm, left, key);
+  }
+  if (hash->shape == cache->shape) {
+    return push(vm, &hash->entries[cache->slot].value);
+  }
+
+  int position = hashFind(hash, key);
+  if (position < 0) {
+    Object nullObj = {.type = NullObj, .null = &null_obj};
+    return push(vm, &nullObj);
+  }
+  cache->shape = hash->shape;
+  cache->slot = position;
+  return push(vm, &hash->entries[position].value);
+}
+
+int executeReturnValue(VM *vm, int basePointer) {
+  Object *returnValue = pop(vm);
+  vm->sp = basePointer - 1;
+  return push(vm, returnValue);
+}
+
+int executeReturn(VM *vm, int basePointer) {
+  vm->sp = basePointer - 1;
+  return executeNull(vm);
+}
+
+int executeSetLocal(VM *vm, int basePointer, int localIndex) {
+  vm->stack[basePointer + localIndex] = *pop(vm);
+  return 0;
+}
+
+int executeGetLocal(VM *vm, int basePointer, int localIndex) {
+  return push(vm, &vm->stack[basePointer + localIndex]);
+}
+
+int executeGetBuiltin(VM *vm, int builtinIndex) {
+  Object builtin = {.type = BuiltinObj,
+                    .builtin = builtins[builtinIndex].function};
+  return push(vm, &builtin);
+}
+
+// dispatch loop; returns once the frame count drops to exitFrame, or when the
+// main frame runs out of instructions
+static int execute(VM *vm, int exitFrame) {
   int ip;
   Instructions instructions;
   OpCode opCode;
 
-  while (currentFrame(vm)->ip <
-         currentFrame(vm)->compiledFunction->instructionCount - 1) {
+  while (vm->framesIndex > exitFrame &&
+         currentFrame(vm)->ip <
+             currentFrame(vm)->compiledFunction->instructionCount - 1) {
     currentFrame(vm)->ip++;
 
     ip = currentFrame(vm)->ip;
@@ -477,14 +646,14 @@ int run(VM *vm) {
                        (unsigned char)instructions[ip + 2];
       currentFrame(vm)->ip += 2;
 
-      if (push(vm, &vm->constants[constIndex]) != 0) {
+      if (executeConstant(vm, constIndex) != 0) {
         return -1;
       }
       break;
     }
 
     case OpPop:
-      pop(vm);
+      executePop(vm);
       break;
 
     case OpAdd:
@@ -496,21 +665,12 @@ int run(VM *vm) {
       }
       break;
 
-    case OpTrue: {
-      Object trueObj = {.type = BooleanObj, .boolean = &TRUE};
-      if (push(vm, &trueObj) != 0) {
-        return -1;
-      }
-      break;
-    }
-
-    case OpFalse: {
-      Object falseObj = {.type = BooleanObj, .boolean = &FALSE};
-      if (push(vm, &falseObj) != 0) {
+    case OpTrue:
+    case OpFalse:
+      if (executeBoolean(vm, opCode == OpTrue) != 0) {
         return -1;
       }
       break;
-    }
 
     case OpEqual:
     case OpNotEqual:
@@ -537,8 +697,7 @@ int run(VM *vm) {
                 (unsigned char)instructions[ip + 2];
       currentFrame(vm)->ip += 2;
 
-      Object *condition = pop(vm);
-      if (!isTruthy(condition)) {
+      if (!executeJumpCondition(vm)) {
         currentFrame(vm)->ip = pos - 1;
       }
       break;
@@ -551,20 +710,18 @@ int run(VM *vm) {
       break;
     }
 
-    case OpNull: {
-      Object nullObj = {.type = NullObj, .null = &null_obj};
-      if (push(vm, &nullObj) != 0) {
+    case OpNull:
+      if (executeNull(vm) != 0) {
         return -1;
       }
       break;
-    }
 
     case OpSetGlobal: {
       int globalIndex = ((unsigned char)instructions[ip + 1] << 8) |
                         (unsigned char)instructions[ip + 2];
       currentFrame(vm)->ip += 2;
 
-      vm->globals[globalIndex] = *pop(vm);
+      executeSetGlobal(vm, globalIndex);
       break;
     }
 
@@ -573,7 +730,7 @@ int run(VM *vm) {
                         (unsigned char)instructions[ip + 2];
       currentFrame(vm)->ip += 2;
 
-      if (push(vm, &vm->globals[globalIndex]) != 0) {
+      if (executeGetGlobal(vm, globalIndex) != 0) {
         return -1;
       }
       break;
@@ -584,10 +741,7 @@ int run(VM *vm) {
                         (unsigned char)instructions[ip + 2];
       currentFrame(vm)->ip += 2;
 
-      Object *array = buildArray(vm, vm->sp - numElements, vm->sp);
-      vm->sp = vm->sp - numElements;
-
-      if (push(vm, array) != 0) {
+      if (executeArray(vm, numElements) != 0) {
         return -1;
       }
       break;
@@ -598,20 +752,35 @@ int run(VM *vm) {
                         (unsigned char)instructions[ip + 2];
       currentFrame(vm)->ip += 2;
 
-      Object *hash = buildHash(vm, vm->sp - numElements, vm->sp);
-      vm->sp = vm->sp - numElements;
+      if (executeHash(vm, numElements) != 0) {
+        return -1;
+      }
+      break;
+    }
+
+    case OpIndex:
+      if (executeIndex(vm) != 0) {
+        return -1;
+      }
+      break;
+
+    case OpRecord: {
+      int shapeIndex = ((unsigned char)instructions[ip + 1] << 8) |
+                       (unsigned char)instructions[ip + 2];
+      currentFrame(vm)->ip += 2;
 
-      if (push(vm, hash) != 0) {
+      if (executeRecord(vm, shapeIndex) != 0) {
         return -1;
       }
       break;
     }
 
-    case OpIndex: {
-      Object *index = pop(vm);
-      Object *left = pop(vm);
+    case OpGetField: {
+      int keyIndex = ((unsigned char)instructions[ip + 1] << 8) |
+                     (unsigned char)instructions[ip + 2];
+      currentFrame(vm)->ip += 2;
 
-      if (executeIndexExpression(vm, left, index) != 0) {
+      if (executeGetField(vm, keyIndex) != 0) {
         return -1;
       }
       break;
@@ -628,11 +797,8 @@ int run(VM *vm) {
     }
 
     case OpReturnValue: {
-      Object *returnValue = pop(vm);
       Frame *frame = popFrame(vm);
-      vm->sp = frame->basePointer - 1;
-
-      if (push(vm, returnValue) != 0) {
+      if (executeReturnValue(vm, frame->basePointer) != 0) {
         return -1;
       }
       break;
@@ -640,10 +806,7 @@ int run(VM *vm) {
 
     case OpReturn: {
       Frame *frame = popFrame(vm);
-      vm->sp = frame->basePointer - 1;
-
-      Object nullObj = {.type = NullObj, .null = &null_obj};
-      if (push(vm, &nullObj) != 0) {
+      if (executeReturn(vm, frame->basePointer) != 0) {
         return -1;
       }
       break;
@@ -653,8 +816,7 @@ int run(VM *vm) {
       int localIndex = (unsigned char)instructions[ip + 1];
       currentFrame(vm)->ip += 1;
 
-      Frame *frame = currentFrame(vm);
-      vm->stack[frame->basePointer + localIndex] = *pop(vm);
+      executeSetLocal(vm, currentFrame(vm)->basePointer, localIndex);
       break;
     }
 
@@ -662,8 +824,7 @@ int run(VM *vm) {
       int localIndex = (unsigned char)instructions[ip + 1];
       currentFrame(vm)->ip += 1;
 
-      Frame *frame = currentFrame(vm);
-      if (push(vm, &vm->stack[frame->basePointer + localIndex]) != 0) {
+      if (executeGetLocal(vm, currentFrame(vm)->basePointer, localIndex) != 0) {
         return -1;
       }
       break;
@@ -673,8 +834,7 @@ int run(VM *vm) {
       int builtinIndex = (unsigned char)instructions[ip + 1];
       currentFrame(vm)->ip += 1;
 
-      // Get builtin from builtins array
-      if (push(vm, (Object *)&builtins[builtinIndex].function) != 0) {
+      if (executeGetBuiltin(vm, builtinIndex) != 0) {
         return -1;
       }
       break;
@@ -687,3 +847,19 @@ int run(VM *vm) {
 
   return 0;
 }
+
+int run(VM *vm) { return execute(vm, 0); }
+
+// call the callee sitting below numArgs arguments and run it to completion,
+// leaving its result on the stack like a finished OpCall
+int runCall(VM *vm, int numArgs) {
+  int exitFrame = vm->framesIndex;
+
+  if (executeCall(vm, numArgs) != 0) {
+    return -1;
+  }
+  if (vm->framesIndex == exitFrame) {
+    return 0; // builtin or native function, already done
+  }
+  return execute(vm, exitFrame);
+}
@@ -15,6 +15,13 @@
 
 typedef struct VM VM;
 
+// what an OpGetField site last saw: hashes of shape keep its key at slot.
+// a site's key is a constant of its own, so caches are kept per constant
+typedef struct {
+  Hash *shape;
+  int slot;
+} FieldCache;
+
 static Boolean TRUE = {
   .value = 1
 };
@@ -34,15 +41,22 @@ struct VM {
   Frame* frames;
   int frameCount;
   int framesIndex;
+  FieldCache* fieldCaches; // one per constant
 };
 
 VM* newVM(ByteCode *bytecode);
 VM* newVMWithGlobalStore(ByteCode *bytecode, Object* globals, int globalCount);
 void freeVM(VM *vm);
 Frame* currentFrame(VM *vm);
+// source line of the instruction the innermost interpreted frame is at,
+// e.g. the one that made run() fail; 0 when the bytecode has no line table
+int vmCurrentLine(VM *vm);
+// tells stderr where run() failed
+void reportRuntimeError(VM *vm);
 void pushFrame(VM *vm, Frame *frame);
 Frame* popFrame(VM *vm);
 int run(VM* vm);
+int runCall(VM *vm, int numArgs);
 int push(VM *vm, Object *object);
 Object* pop(VM *vm);
 Object* stackTop(VM *vm);
@@ -65,4 +79,23 @@ int executeCall(VM *vm, int numArgs);
 int callCompiledFunction(VM *vm, CompiledFunction *fn, int numArgs);
 int callBuiltin(VM *vm, Builtin *builtin, int numArgs);
 
+// single-instruction helpers, shared by run() and the native backends
+int executeConstant(VM *vm, int constIndex);
+int executePop(VM *vm);
+int executeBoolean(VM *vm, bool value);
+int executeNull(VM *vm);
+bool executeJumpCondition(VM *vm);
+int executeSetGlobal(VM *vm, int globalIndex);
+int executeGetGlobal(VM *vm, int globalIndex);
+int executeArray(VM *vm, int numElements);
+int executeHash(VM *vm, int numElements);
+int executeIndex(VM *vm);
+int executeRecord(VM *vm, int shapeIndex);
+int executeGetField(VM *vm, int keyIndex);
+int executeReturnValue(VM *vm, int basePointer);
+int executeReturn(VM *vm, int basePointer);
+int executeSetLocal(VM *vm, int basePointer, int localIndex);
+int executeGetLocal(VM *vm, int basePointer, int localIndex);
+int executeGetBuiltin(VM *vm, int builtinIndex);
+
 #endif